@@ -0,0 +1,546 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include "batch.hh"
+#include "vector.hh"
+
+//	============================================================================================
+//	Free callables for standard algorithms
+//
+//	Every pack operation as a stateless noexcept function object, bodies are straight line
+//	selects over operator[] so loops built by std::transform / std::transform_reduce /
+//	std::for_each with std::execution::par_unseq inline and vectorize, e.g.
+//
+//		std::transform( std::execution::par_unseq, in.begin( ), in.end( ), out.begin( ), ops::normalized_length );
+//		std::transform_reduce( std::execution::par_unseq, in.begin( ), in.end( ), 0.F, std::plus{ }, ops::get_length );
+//	============================================================================================
+
+namespace detail
+{
+	template <typename P>
+	concept float_vector_t = pack_t<P> && std::is_same_v<typename P::Type, float>;
+
+	template <typename P>
+	concept float_v3_t = float_vector_t<P> && P::Len == 3U;
+
+	template <typename P, size_t N>
+	constexpr auto extent_v = N == 0 ? P::Len : N;
+
+	/**
+	 * std::remainderf( x, 360 ) without the libm call
+	 * Exact for |x| < 2^23, only the sign of an exact +-180 result may differ
+	 *
+	 * \param x
+	 * \return
+	 */
+	inline auto wrap_degrees( const float x )noexcept->float
+	{
+		const auto turns = std::nearbyint( x * ( 1.F / 360.F ) );
+		auto result      = x - turns * 360.F;
+
+		result = result > 180.F ? result - 360.F : result;
+		result = result < -180.F ? result + 360.F : result;
+
+		return std::isfinite( x ) ? result : 0.F;
+	}
+}
+
+namespace ops
+{
+	//	============================================================================================
+	//	Mathematical operations
+	//	N = 0 means the full Len
+	//	============================================================================================
+
+	template <size_t N = 0>
+	struct get_dot_t
+	{
+		template <detail::pack_t P>
+		auto operator( )( const P &p )const noexcept->typename P::Type
+		{
+			static_assert( detail::extent_v<P, N> <= P::Len );
+
+			return detail::fold_sum<typename P::Type, detail::extent_v<P, N>>( [ &p ]( const size_t i ) { return p[ i ] * p[ i ]; } );
+		}
+	};
+
+	template <size_t N = 0>
+	struct get_length_t
+	{
+		template <detail::pack_t P>
+		auto operator( )( const P &p )const noexcept
+		{
+			using T = typename P::Type;
+			using L = std::conditional_t<std::is_floating_point_v<T>, T, double>;
+
+			return std::sqrt( static_cast<L>( get_dot_t<N>{ }( p ) ) );
+		}
+	};
+
+	template <size_t N = 0>
+	struct dot_t
+	{
+		template <detail::pack_t P>
+		auto operator( )( const P &p, const P &arg )const noexcept->typename P::Type
+		{
+			static_assert( detail::extent_v<P, N> <= P::Len );
+
+			return detail::fold_sum<typename P::Type, detail::extent_v<P, N>>( [ &p, &arg ]( const size_t i ) { return p[ i ] * arg[ i ]; } );
+		}
+
+		template <detail::pack_t P>
+		auto operator( )( const P &p, const typename P::Type arg )const noexcept->typename P::Type
+		{
+			static_assert( detail::extent_v<P, N> <= P::Len );
+
+			return detail::fold_sum<typename P::Type, detail::extent_v<P, N>>( [ &p, arg ]( const size_t i ) { return p[ i ] * arg; } );
+		}
+	};
+
+	template <size_t N = 0>
+	struct length_t
+	{
+		template <detail::pack_t P, typename A>
+		auto operator( )( const P &p, const A &arg )const noexcept
+		{
+			using T = typename P::Type;
+			using L = std::conditional_t<std::is_floating_point_v<T>, T, double>;
+
+			return std::sqrt( static_cast<L>( dot_t<N>{ }( p, arg ) ) );
+		}
+	};
+
+	//	============================================================================================
+	//	Geometric operations
+	//	============================================================================================
+
+	struct cross_t
+	{
+		template <detail::pack_t P>
+		auto operator( )( const P &p, const P &arg )const noexcept->P
+		{
+			return p.cross( arg );
+		}
+	};
+
+	struct project_t
+	{
+		template <detail::pack_t P>
+		auto operator( )( const P &p, const P &onto )const noexcept->P
+		{
+			return p.project( onto );
+		}
+	};
+
+	/**
+	 * Binds the plane once, e.g. std::transform( in.begin( ), in.end( ), out.begin( ), ops::get_plane_distance_t{ normal, distance } )
+	 */
+	template <detail::pack_t P>
+	struct get_plane_distance_t
+	{
+		P normal;
+		typename P::Type distance;
+
+		auto operator( )( const P &p )const noexcept->typename P::Type
+		{
+			return p.get_plane_distance( normal, distance );
+		}
+	};
+
+	struct reflect_t
+	{
+		template <detail::pack_t P>
+		auto operator( )( const P &p, const P &normal )const noexcept->P
+		{
+			return p.reflect( normal );
+		}
+	};
+
+	/**
+	 * Components I... as a new pack, e.g. std::transform( in.begin( ), in.end( ), out.begin( ), ops::swizzle<0, 1> )
+	 */
+	template <size_t... I>
+	struct swizzle_t
+	{
+		template <detail::pack_t P>
+		auto operator( )( const P &p )const noexcept
+		{
+			return p.template swizzle<I...>( );
+		}
+	};
+
+	//	============================================================================================
+	//	CS:GO operations
+	//	In place forms for std::for_each, copying forms for std::transform
+	//	============================================================================================
+
+	struct normalize_angle_t
+	{
+		template <detail::float_v3_t P>
+		auto operator( )( P &p )const noexcept->void
+		{
+			p[ PITCH ] = detail::wrap_degrees( p[ PITCH ] );
+			p[ YAW ]   = detail::wrap_degrees( p[ YAW ] );
+			p[ ROLL ]  = 0.F;
+		}
+	};
+
+	struct normalized_angle_t
+	{
+		template <detail::float_v3_t P>
+		auto operator( )( P p )const noexcept->P
+		{
+			normalize_angle_t{ }( p );
+			return p;
+		}
+	};
+
+	/**
+	 * Zero length turns into the last axis, as pack::normalize_length
+	 */
+	struct normalize_length_t
+	{
+		template <detail::float_vector_t P>
+		auto operator( )( P &p )const noexcept->void
+		{
+			const auto length = std::sqrt( get_dot_t<>{ }( p ) );
+			const auto valid  = length != 0.F;
+			const auto safe   = valid ? length : 1.F;
+
+			detail::unroll<P::Len>( [ &p, valid, safe ]( const size_t i ) { p[ i ] = valid ? p[ i ] / safe : ( i + 1 == P::Len ? 1.F : 0.F ); } );
+		}
+	};
+
+	struct normalized_length_t
+	{
+		template <detail::float_vector_t P>
+		auto operator( )( P p )const noexcept->P
+		{
+			normalize_length_t{ }( p );
+			return p;
+		}
+	};
+
+	struct clamp_angle_t
+	{
+		template <detail::float_v3_t P>
+		auto operator( )( P &p )const noexcept->void
+		{
+			p[ PITCH ] = std::min( std::max( p[ PITCH ], -89.F ), 89.F );
+			p[ YAW ]   = std::min( std::max( p[ YAW ], -180.F ), 180.F );
+			p[ ROLL ]  = 0.F;
+		}
+	};
+
+	struct clamped_angle_t
+	{
+		template <detail::float_v3_t P>
+		auto operator( )( P p )const noexcept->P
+		{
+			clamp_angle_t{ }( p );
+			return p;
+		}
+	};
+
+	/**
+	 * Same formula as pack::get_angle, evaluated in float
+	 */
+	struct get_angle_t
+	{
+		template <detail::float_v3_t P>
+		auto operator( )( const P &forward )const noexcept->P
+		{
+			constexpr auto Degrees = static_cast<float>( 180.F / M_PI );
+
+			const auto vertical = forward[ PITCH ] == 0.F && forward[ YAW ] == 0.F;
+			auto angles         = P{ };
+
+			if( vertical )
+			{
+				angles[ PITCH ] = forward[ ROLL ] > 0.F ? -90.F : 90.F;
+				angles[ YAW ]   = 0.F;
+			}
+			else
+			{
+				angles[ PITCH ] = std::atan2( -forward[ ROLL ], std::sqrt( get_dot_t<2>{ }( forward ) ) ) * Degrees;
+				angles[ YAW ]   = std::atan2( forward[ YAW ], forward[ PITCH ] ) * Degrees;
+			}
+
+			angles[ ROLL ] = 0.F;
+
+			return angles;
+		}
+	};
+
+	inline constexpr auto get_dot           = get_dot_t<>{ };
+	inline constexpr auto get_length        = get_length_t<>{ };
+	inline constexpr auto dot               = dot_t<>{ };
+	inline constexpr auto length            = length_t<>{ };
+	inline constexpr auto cross             = cross_t{ };
+	inline constexpr auto project           = project_t{ };
+	inline constexpr auto reflect           = reflect_t{ };
+
+	template <size_t... I>
+	inline constexpr auto swizzle = swizzle_t<I...>{ };
+
+	inline constexpr auto normalize_angle   = normalize_angle_t{ };
+	inline constexpr auto normalized_angle  = normalized_angle_t{ };
+	inline constexpr auto normalize_length  = normalize_length_t{ };
+	inline constexpr auto normalized_length = normalized_length_t{ };
+	inline constexpr auto clamp_angle       = clamp_angle_t{ };
+	inline constexpr auto clamped_angle     = clamped_angle_t{ };
+	inline constexpr auto get_angle         = get_angle_t{ };
+}
+
+//	============================================================================================
+//	Range adaptors
+//	Iterators below are random access with real references where they have elements,
+//	which is what the parallel overloads dispatch on
+//	============================================================================================
+
+/**
+ * Walks one component across an array of structs batch
+ */
+template <typename T>
+struct component_iterator_t
+{
+	public:
+	using iterator_category = std::random_access_iterator_tag;
+	using iterator_concept  = std::random_access_iterator_tag;
+	using value_type        = std::remove_const_t<T>;
+	using difference_type   = std::ptrdiff_t;
+	using pointer           = T *;
+	using reference         = T &;
+
+	component_iterator_t( ) = default;
+
+	component_iterator_t( T *data, const difference_type stride ) : m_data( data ), m_stride( stride )
+	{
+	}
+
+	auto operator*( )const noexcept->T &
+	{
+		return *m_data;
+	}
+
+	auto operator[ ]( const difference_type i )const noexcept->T &
+	{
+		return m_data[ i * m_stride ];
+	}
+
+	auto operator++( )noexcept->component_iterator_t &
+	{
+		m_data += m_stride;
+		return *this;
+	}
+
+	auto operator++( int )noexcept->component_iterator_t
+	{
+		auto copy = *this;
+		m_data += m_stride;
+		return copy;
+	}
+
+	auto operator--( )noexcept->component_iterator_t &
+	{
+		m_data -= m_stride;
+		return *this;
+	}
+
+	auto operator--( int )noexcept->component_iterator_t
+	{
+		auto copy = *this;
+		m_data -= m_stride;
+		return copy;
+	}
+
+	auto operator+=( const difference_type n )noexcept->component_iterator_t &
+	{
+		m_data += n * m_stride;
+		return *this;
+	}
+
+	auto operator-=( const difference_type n )noexcept->component_iterator_t &
+	{
+		m_data -= n * m_stride;
+		return *this;
+	}
+
+	friend auto operator+( component_iterator_t it, const difference_type n )noexcept->component_iterator_t
+	{
+		return it += n;
+	}
+
+	friend auto operator+( const difference_type n, component_iterator_t it )noexcept->component_iterator_t
+	{
+		return it += n;
+	}
+
+	friend auto operator-( component_iterator_t it, const difference_type n )noexcept->component_iterator_t
+	{
+		return it -= n;
+	}
+
+	friend auto operator-( const component_iterator_t &a, const component_iterator_t &b )noexcept->difference_type
+	{
+		return ( a.m_data - b.m_data ) / a.m_stride;
+	}
+
+	friend auto operator==( const component_iterator_t &a, const component_iterator_t &b )noexcept->bool
+	{
+		return a.m_data == b.m_data;
+	}
+
+	friend auto operator<=>( const component_iterator_t &a, const component_iterator_t &b )noexcept
+	{
+		return a.m_data <=> b.m_data;
+	}
+
+	private:
+	T *m_data                = nullptr;
+	difference_type m_stride = 1;
+};
+
+/**
+ * Element indices, for driving struct of arrays kernels through
+ * std::for_each / std::transform_reduce
+ */
+struct index_iterator_t
+{
+	public:
+	using iterator_category = std::random_access_iterator_tag;
+	using iterator_concept  = std::random_access_iterator_tag;
+	using value_type        = size_t;
+	using difference_type   = std::ptrdiff_t;
+	using pointer           = void;
+	using reference         = size_t;
+
+	index_iterator_t( ) = default;
+
+	explicit index_iterator_t( const size_t index ) : m_index( index )
+	{
+	}
+
+	auto operator*( )const noexcept->size_t
+	{
+		return m_index;
+	}
+
+	auto operator[ ]( const difference_type i )const noexcept->size_t
+	{
+		return m_index + static_cast<size_t>( i );
+	}
+
+	auto operator++( )noexcept->index_iterator_t &
+	{
+		++m_index;
+		return *this;
+	}
+
+	auto operator++( int )noexcept->index_iterator_t
+	{
+		return index_iterator_t{ m_index++ };
+	}
+
+	auto operator--( )noexcept->index_iterator_t &
+	{
+		--m_index;
+		return *this;
+	}
+
+	auto operator--( int )noexcept->index_iterator_t
+	{
+		return index_iterator_t{ m_index-- };
+	}
+
+	auto operator+=( const difference_type n )noexcept->index_iterator_t &
+	{
+		m_index += static_cast<size_t>( n );
+		return *this;
+	}
+
+	auto operator-=( const difference_type n )noexcept->index_iterator_t &
+	{
+		m_index -= static_cast<size_t>( n );
+		return *this;
+	}
+
+	friend auto operator+( index_iterator_t it, const difference_type n )noexcept->index_iterator_t
+	{
+		return it += n;
+	}
+
+	friend auto operator+( const difference_type n, index_iterator_t it )noexcept->index_iterator_t
+	{
+		return it += n;
+	}
+
+	friend auto operator-( index_iterator_t it, const difference_type n )noexcept->index_iterator_t
+	{
+		return it -= n;
+	}
+
+	friend auto operator-( const index_iterator_t &a, const index_iterator_t &b )noexcept->difference_type
+	{
+		return static_cast<difference_type>( a.m_index ) - static_cast<difference_type>( b.m_index );
+	}
+
+	friend auto operator==( const index_iterator_t &a, const index_iterator_t &b )noexcept->bool
+	{
+		return a.m_index == b.m_index;
+	}
+
+	friend auto operator<=>( const index_iterator_t &a, const index_iterator_t &b )noexcept
+	{
+		return a.m_index <=> b.m_index;
+	}
+
+	private:
+	size_t m_index = 0;
+};
+
+/**
+ * Cth component of every pack in an array of structs batch
+ *
+ * \param batch
+ * \param c
+ * \return
+ */
+template <typename P>
+	requires detail::pack_t<std::remove_const_t<P>>
+auto components( std::span<P> batch, const size_t c )
+{
+	using Pack     = std::remove_const_t<P>;
+	using T        = std::conditional_t<std::is_const_v<P>, const typename Pack::Type, typename Pack::Type>;
+	using iterator = component_iterator_t<T>;
+
+	static_assert( sizeof( Pack ) == sizeof( typename Pack::Type ) * Pack::Len );
+	assert( c < Pack::Len );
+
+	auto *first = reinterpret_cast<T *>( batch.data( ) ) + c;
+
+	return std::ranges::subrange{ iterator{ first, Pack::Len }, iterator{ first + batch.size( ) * Pack::Len, Pack::Len } };
+}
+
+/**
+ * Indices [ 0, count )
+ *
+ * \param count
+ * \return
+ */
+inline auto indices( const size_t count )
+{
+	return std::ranges::subrange{ index_iterator_t{ 0 }, index_iterator_t{ count } };
+}
+
+template <detail::pack_t P>
+auto indices( const soa_batch_t<P> &batch )
+{
+	return indices( batch.get_size( ) );
+}
@@ -0,0 +1,579 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+#include "instrument.hh"
+#include "transpose.hh"
+#include "vector.hh"
+
+namespace detail
+{
+	/**
+	 * Upstream passthrough which keeps track of how much
+	 * the owning arena had to borrow past its own block
+	 */
+	struct spill_resource_t : public std::pmr::memory_resource
+	{
+		public:
+		explicit spill_resource_t( std::pmr::memory_resource *upstream ) : m_upstream( upstream )
+		{
+		}
+
+		auto get_upstream( )const->std::pmr::memory_resource *
+		{
+			return m_upstream;
+		}
+
+		auto get_spilled( )const->size_t
+		{
+			return m_spilled;
+		}
+
+		auto clear( )->void
+		{
+			m_spilled = 0;
+		}
+
+		private:
+		auto do_allocate( size_t bytes, size_t alignment )->void *override
+		{
+			m_spilled += bytes;
+			return m_upstream->allocate( bytes, alignment );
+		}
+
+		auto do_deallocate( void *p, size_t bytes, size_t alignment )->void override
+		{
+			m_upstream->deallocate( p, bytes, alignment );
+		}
+
+		auto do_is_equal( const std::pmr::memory_resource &other )const noexcept->bool override
+		{
+			return this == &other;
+		}
+
+		std::pmr::memory_resource *m_upstream = nullptr;
+		size_t m_spilled                      = 0;
+	};
+}
+
+//	============================================================================================
+//	Allocation
+//	============================================================================================
+
+/**
+ * Bump arena meant to be sized per tick
+ * Everything allocated through get_resource( ) is dropped at once by reset( ).
+ * When a tick outgrows the block, reset( ) regrows it by what was spilled,
+ * so a steady workload stops touching the upstream resource after warmup
+ */
+struct tick_arena_t
+{
+	public:
+	constexpr static size_t Alignment = 64;
+
+	explicit tick_arena_t( const size_t capacity, std::pmr::memory_resource *upstream = std::pmr::new_delete_resource( ) )
+		: m_spill( upstream )
+	{
+		grow( capacity );
+	}
+
+	tick_arena_t( const tick_arena_t & )                    = delete;
+	auto operator=( const tick_arena_t & )->tick_arena_t & = delete;
+
+	~tick_arena_t( )
+	{
+		m_resource.reset( );
+		m_spill.get_upstream( )->deallocate( m_block, m_capacity, Alignment );
+	}
+
+	//	============================================================================================
+
+	/**
+	 * Resource to hand to batch containers
+	 *
+	 * \return
+	 */
+	auto get_resource( )->std::pmr::memory_resource *
+	{
+		return &*m_resource;
+	}
+
+	/**
+	 * Size of the owned block
+	 *
+	 * \return
+	 */
+	auto get_capacity( )const->size_t
+	{
+		return m_capacity;
+	}
+
+	/**
+	 * Bytes borrowed from upstream since last reset
+	 *
+	 * \return
+	 */
+	auto get_spilled( )const->size_t
+	{
+		return m_spill.get_spilled( );
+	}
+
+	/**
+	 * Release every allocation of the tick in O(1)
+	 * Containers built on the arena must not outlive this call
+	 */
+	auto reset( )->void
+	{
+		const auto spilled = m_spill.get_spilled( );
+
+		m_resource.reset( );
+		m_spill.clear( );
+
+		if( spilled != 0 )
+		{
+			m_spill.get_upstream( )->deallocate( m_block, m_capacity, Alignment );
+			grow( m_capacity + spilled );
+		}
+		else
+		{
+			m_resource.emplace( m_block, m_capacity, &m_spill );
+		}
+	}
+
+	//	============================================================================================
+
+	private:
+	auto grow( const size_t capacity )->void
+	{
+		m_capacity = ( ( capacity + Alignment - 1 ) / Alignment ) * Alignment;
+		m_block    = m_spill.get_upstream( )->allocate( m_capacity, Alignment );
+		m_resource.emplace( m_block, m_capacity, &m_spill );
+	}
+
+	detail::spill_resource_t m_spill;
+	std::optional<std::pmr::monotonic_buffer_resource> m_resource;
+	void *m_block     = nullptr;
+	size_t m_capacity = 0;
+};
+
+//	============================================================================================
+//	Containers
+//	============================================================================================
+
+/**
+ * Array of structs batch, allocator aware
+ */
+template <detail::pack_t P>
+using pack_batch_t = std::pmr::vector<P>;
+
+/**
+ * Struct of arrays batch, one allocator aware lane per component
+ */
+template <detail::pack_t P>
+struct soa_batch_t
+{
+	public:
+	constexpr static size_t Len = P::Len;
+	using Type                  = typename P::Type;
+	using Lane                  = std::pmr::vector<Type>;
+
+	//	============================================================================================
+
+	explicit soa_batch_t( std::pmr::memory_resource *resource = std::pmr::get_default_resource( ) )
+		: m_lanes( make_lanes( resource, std::make_index_sequence<Len>{ } ) )
+	{
+	}
+
+	soa_batch_t( const size_t size, std::pmr::memory_resource *resource = std::pmr::get_default_resource( ) )
+		: soa_batch_t( resource )
+	{
+		resize( size );
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	Operational methods
+	//	============================================================================================
+
+	auto get_size( )const->size_t
+	{
+		return m_lanes[ 0 ].size( );
+	}
+
+	auto get_resource( )const->std::pmr::memory_resource *
+	{
+		return m_lanes[ 0 ].get_allocator( ).resource( );
+	}
+
+	auto reserve( const size_t size )->void
+	{
+		for( auto &lane : m_lanes )
+		{
+			lane.reserve( size );
+		}
+	}
+
+	auto resize( const size_t size )->void
+	{
+		for( auto &lane : m_lanes )
+		{
+			lane.resize( size );
+		}
+	}
+
+	auto clear( )->void
+	{
+		for( auto &lane : m_lanes )
+		{
+			lane.clear( );
+		}
+	}
+
+	/**
+	 * Contiguous storage of Cth component
+	 *
+	 * \param c
+	 * \return
+	 */
+	auto lane( const size_t c )->Type *
+	{
+		return m_lanes[ c ].data( );
+	}
+
+	auto lane( const size_t c )const->const Type *
+	{
+		return m_lanes[ c ].data( );
+	}
+
+	/**
+	 * Gather Ith element back into a pack
+	 *
+	 * \param i
+	 * \return
+	 */
+	auto get( const size_t i )const->P
+	{
+		auto result = P{ };
+
+		for( auto c = size_t{ 0 }; c < Len; ++c )
+		{
+			result[ c ] = m_lanes[ c ][ i ];
+		}
+
+		return result;
+	}
+
+	auto set( const size_t i, const P &value )->void
+	{
+		for( auto c = size_t{ 0 }; c < Len; ++c )
+		{
+			m_lanes[ c ][ i ] = value[ c ];
+		}
+	}
+
+	auto push_back( const P &value )->void
+	{
+		for( auto c = size_t{ 0 }; c < Len; ++c )
+		{
+			m_lanes[ c ].push_back( value[ c ] );
+		}
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	Layout conversion
+	//	============================================================================================
+
+	/**
+	 * Replace contents with an array of structs batch
+	 *
+	 * \param source
+	 */
+	auto load( std::span<const P> source )->void
+	{
+		PACK_TIME( soa_load );
+
+		resize( source.size( ) );
+
+		Type *lanes[ Len ];
+
+		for( auto c = size_t{ 0 }; c < Len; ++c )
+		{
+			lanes[ c ] = lane( c );
+		}
+
+		detail::deinterleave( source.data( ), lanes, source.size( ) );
+	}
+
+	/**
+	 * Write contents out as an array of structs batch
+	 *
+	 * \param destination
+	 */
+	auto store( std::span<P> destination )const->void
+	{
+		assert( destination.size( ) >= get_size( ) );
+
+		PACK_TIME( soa_store );
+
+		const Type *lanes[ Len ];
+
+		for( auto c = size_t{ 0 }; c < Len; ++c )
+		{
+			lanes[ c ] = lane( c );
+		}
+
+		detail::interleave( lanes, destination.data( ), get_size( ) );
+	}
+
+	//	============================================================================================
+
+	private:
+	template <size_t... I>
+	static auto make_lanes( std::pmr::memory_resource *resource, std::index_sequence<I...> )->std::array<Lane, Len>
+	{
+		return { { ( static_cast<void>( I ), Lane( resource ) )... } };
+	}
+
+	std::array<Lane, Len> m_lanes;
+};
+
+/**
+ * Array of struct of arrays batch, Width elements per block with each component
+ * of a block in its own run. Keeps SoA friendly streams for kernels while one
+ * element still lives within a single cache line or two
+ */
+template <detail::pack_t P, size_t Width = 8>
+struct aosoa_batch_t
+{
+	static_assert( Width != 0 && ( Width & ( Width - 1 ) ) == 0, "Width has to be a power of two" );
+
+	public:
+	constexpr static size_t Len = P::Len;
+	using Type                  = typename P::Type;
+
+	struct alignas( std::min<size_t>( Width * sizeof( Type ), 64 ) ) block_t
+	{
+		std::array<std::array<Type, Width>, Len> lanes;
+	};
+
+	//	============================================================================================
+
+	explicit aosoa_batch_t( std::pmr::memory_resource *resource = std::pmr::get_default_resource( ) )
+		: m_blocks( resource )
+	{
+	}
+
+	aosoa_batch_t( const size_t size, std::pmr::memory_resource *resource = std::pmr::get_default_resource( ) )
+		: aosoa_batch_t( resource )
+	{
+		resize( size );
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	Operational methods
+	//	============================================================================================
+
+	auto get_size( )const->size_t
+	{
+		return m_size;
+	}
+
+	auto get_block_count( )const->size_t
+	{
+		return m_blocks.size( );
+	}
+
+	auto get_resource( )const->std::pmr::memory_resource *
+	{
+		return m_blocks.get_allocator( ).resource( );
+	}
+
+	auto reserve( const size_t size )->void
+	{
+		m_blocks.reserve( get_blocks( size ) );
+	}
+
+	/**
+	 * Slots past size in the last block are kept zeroed
+	 * so kernels may always run whole blocks
+	 *
+	 * \param size
+	 */
+	auto resize( const size_t size )->void
+	{
+		m_blocks.resize( get_blocks( size ) );
+
+		if( size < m_size && !m_blocks.empty( ) )
+		{
+			auto &last = m_blocks.back( );
+
+			for( auto c = size_t{ 0 }; c < Len; ++c )
+			{
+				std::fill( last.lanes[ c ].begin( ) + ( ( size - 1 ) % Width + 1 ), last.lanes[ c ].end( ), Type{ } );
+			}
+		}
+
+		m_size = size;
+	}
+
+	auto clear( )->void
+	{
+		m_blocks.clear( );
+		m_size = 0;
+	}
+
+	auto block( const size_t b )->block_t &
+	{
+		return m_blocks[ b ];
+	}
+
+	auto block( const size_t b )const->const block_t &
+	{
+		return m_blocks[ b ];
+	}
+
+	auto get( const size_t i )const->P
+	{
+		const auto &source = m_blocks[ i / Width ];
+		auto result        = P{ };
+
+		for( auto c = size_t{ 0 }; c < Len; ++c )
+		{
+			result[ c ] = source.lanes[ c ][ i % Width ];
+		}
+
+		return result;
+	}
+
+	auto set( const size_t i, const P &value )->void
+	{
+		auto &destination = m_blocks[ i / Width ];
+
+		for( auto c = size_t{ 0 }; c < Len; ++c )
+		{
+			destination.lanes[ c ][ i % Width ] = value[ c ];
+		}
+	}
+
+	auto push_back( const P &value )->void
+	{
+		resize( m_size + 1 );
+		set( m_size - 1, value );
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	Layout conversion
+	//	============================================================================================
+
+	/**
+	 * Replace contents with an array of structs batch
+	 *
+	 * \param source
+	 */
+	auto load( std::span<const P> source )->void
+	{
+		PACK_TIME( aosoa_load );
+
+		resize( source.size( ) );
+
+		for( auto b = size_t{ 0 }; b < m_blocks.size( ); ++b )
+		{
+			Type *lanes[ Len ];
+
+			for( auto c = size_t{ 0 }; c < Len; ++c )
+			{
+				lanes[ c ] = m_blocks[ b ].lanes[ c ].data( );
+			}
+
+			detail::deinterleave( source.data( ) + b * Width, lanes, std::min( Width, source.size( ) - b * Width ) );
+		}
+	}
+
+	/**
+	 * Write contents out as an array of structs batch
+	 *
+	 * \param destination
+	 */
+	auto store( std::span<P> destination )const->void
+	{
+		assert( destination.size( ) >= m_size );
+
+		PACK_TIME( aosoa_store );
+
+		for( auto b = size_t{ 0 }; b < m_blocks.size( ); ++b )
+		{
+			const Type *lanes[ Len ];
+
+			for( auto c = size_t{ 0 }; c < Len; ++c )
+			{
+				lanes[ c ] = m_blocks[ b ].lanes[ c ].data( );
+			}
+
+			detail::interleave( lanes, destination.data( ) + b * Width, std::min( Width, m_size - b * Width ) );
+		}
+	}
+
+	/**
+	 * Replace contents with a struct of arrays batch, a plain block copy per component
+	 *
+	 * \param source
+	 */
+	auto load( const soa_batch_t<P> &source )->void
+	{
+		PACK_TIME( aosoa_load );
+
+		resize( source.get_size( ) );
+
+		for( auto b = size_t{ 0 }; b < m_blocks.size( ); ++b )
+		{
+			const auto count = std::min( Width, m_size - b * Width );
+
+			for( auto c = size_t{ 0 }; c < Len; ++c )
+			{
+				std::copy_n( source.lane( c ) + b * Width, count, m_blocks[ b ].lanes[ c ].begin( ) );
+			}
+		}
+	}
+
+	auto store( soa_batch_t<P> &destination )const->void
+	{
+		PACK_TIME( aosoa_store );
+
+		destination.resize( m_size );
+
+		for( auto b = size_t{ 0 }; b < m_blocks.size( ); ++b )
+		{
+			const auto count = std::min( Width, m_size - b * Width );
+
+			for( auto c = size_t{ 0 }; c < Len; ++c )
+			{
+				std::copy_n( m_blocks[ b ].lanes[ c ].begin( ), count, destination.lane( c ) + b * Width );
+			}
+		}
+	}
+
+	//	============================================================================================
+
+	private:
+	static auto get_blocks( const size_t size )->size_t
+	{
+		return ( size + Width - 1 ) / Width;
+	}
+
+	std::pmr::vector<block_t> m_blocks;
+	size_t m_size = 0;
+};
@@ -0,0 +1,1183 @@
+//	Self-contained microbenchmarks for every pack method
+//
+//	Build from the repository root, e.g.
+//		cl /std:c++20 /O2 /arch:AVX2 /I. bench\bench.cc
+//		c++ -std=c++20 -O2 -ffp-contract=off -march=native -I. bench/bench.cc -o pack_bench
+//
+//	Usage
+//		pack_bench [--filter <substring>] [--json <file>] [--baseline <file>] [--tolerance <ratio>]
+//
+//	--json writes the results, --baseline compares against a previous --json run
+//	and exits with 1 when any case got slower than baseline * ( 1 + tolerance )
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "vector.hh"
+#include "batch.hh"
+#include "cached.hh"
+#include "collision.hh"
+#include "dispatch.hh"
+#include "frustum.hh"
+#include "grenade.hh"
+#include "matrix.hh"
+#include "morton.hh"
+#include "movement.hh"
+#include "obb.hh"
+#include "occlusion.hh"
+#include "queue.hh"
+#include "snapshot.hh"
+#include "view.hh"
+
+namespace bench
+{
+	//	Hot set for single forms stays in L1, batches go well past L2
+	constexpr auto Single = size_t{ 1024 };
+	constexpr auto Batch  = size_t{ 1 } << 16;
+
+	inline volatile double g_sink = 0.0;
+
+	template <typename T>
+	auto sink( const T value )->void
+	{
+		g_sink = static_cast<double>( value );
+	}
+
+	//	============================================================================================
+	//	Registry
+	//	============================================================================================
+
+	/**
+	 * A case runs its body the given number of operations
+	 */
+	using body_t = std::function<void( size_t )>;
+
+	struct case_t
+	{
+		std::string name;
+		body_t body;
+	};
+
+	struct result_t
+	{
+		std::string name;
+		double ns_per_op;
+		double ns_per_op_min;
+		size_t operations;
+	};
+
+	inline auto get_cases( )->std::vector<case_t> &
+	{
+		static auto cases = std::vector<case_t>{};
+		return cases;
+	}
+
+	inline auto add( std::string name, body_t body )->void
+	{
+		get_cases( ).push_back( { std::move( name ), std::move( body ) } );
+	}
+
+	//	============================================================================================
+	//	Measurement
+	//	============================================================================================
+
+	/**
+	 * Grow the operation count until a sample lasts long enough to trust,
+	 * then report the median and minimum over several samples
+	 *
+	 * \param entry
+	 * \return
+	 */
+	inline auto measure( const case_t &entry )->result_t
+	{
+		using clock_t = std::chrono::steady_clock;
+
+		constexpr auto Target  = std::chrono::milliseconds{ 10 };
+		constexpr auto Samples = size_t{ 7 };
+
+		const auto run = [ & ]( const size_t operations )
+		{
+			const auto start = clock_t::now( );
+			entry.body( operations );
+			return std::chrono::duration<double, std::nano>( clock_t::now( ) - start ).count( );
+		};
+
+		auto operations = Single;
+
+		while( run( operations ) < std::chrono::duration<double, std::nano>( Target ).count( ) && operations < ( size_t{ 1 } << 34 ) )
+		{
+			operations *= 2;
+		}
+
+		auto samples = std::array<double, Samples>{};
+
+		for( auto &sample : samples )
+		{
+			sample = run( operations ) / static_cast<double>( operations );
+		}
+
+		std::sort( samples.begin( ), samples.end( ) );
+
+		return { entry.name, samples[ Samples / 2 ], samples[ 0 ], operations };
+	}
+
+	//	============================================================================================
+	//	Inputs
+	//	============================================================================================
+
+	template <typename P>
+	auto make_inputs( const size_t count, const unsigned seed )->pack_batch_t<P>
+	{
+		using T = typename P::Type;
+
+		auto engine = std::mt19937{ seed };
+		auto result = pack_batch_t<P>( count );
+
+		for( auto &value : result )
+		{
+			for( auto c = size_t{ 0 }; c < P::Len; ++c )
+			{
+				if constexpr( std::is_integral_v<T> )
+				{
+					value[ c ] = std::uniform_int_distribution<T>{ -1000, 1000 }( engine );
+				}
+				else
+				{
+					value[ c ] = std::uniform_real_distribution<T>{ T( -1000 ), T( 1000 ) }( engine );
+				}
+			}
+		}
+
+		//	Keep the zero length branches exercised
+		result[ 0 ] = P{};
+
+		return result;
+	}
+
+	//	============================================================================================
+	//	Case generation
+	//	============================================================================================
+
+	/**
+	 * Register single and batch forms of one operation
+	 * Op takes a pack by reference, may mutate it and returns something to sink
+	 *
+	 * \param name
+	 * \param op
+	 */
+	template <typename P, typename Op>
+	auto add_operation( const std::string &name, Op op )->void
+	{
+		add( name + "/single", [ op, inputs = make_inputs<P>( Single, 1 ) ]( const size_t operations )
+		{
+			for( auto i = size_t{ 0 }; i < operations; ++i )
+			{
+				auto value = inputs[ i & ( Single - 1 ) ];
+				sink( op( value ) );
+			}
+		} );
+
+		add( name + "/batch", [ op, inputs = make_inputs<P>( Batch, 2 ) ]( const size_t operations )
+		{
+			using R = decltype( op( std::declval<P &>( ) ) );
+
+			static auto outputs = std::vector<R>( Batch );
+
+			for( auto done = size_t{ 0 }; done < operations; done += Batch )
+			{
+				const auto count = std::min( Batch, operations - done );
+
+				for( auto i = size_t{ 0 }; i < count; ++i )
+				{
+					auto value   = inputs[ i ];
+					outputs[ i ] = op( value );
+				}
+
+				sink( outputs[ done % count ] );
+			}
+		} );
+	}
+
+	template <typename P>
+	auto add_pack( const std::string &type )->void
+	{
+		using T = typename P::Type;
+
+		const auto prefix = type + "/v" + std::to_string( P::Len ) + "/";
+		const auto other  = make_inputs<P>( 1, 3 )[ 0 ];
+
+		add_operation<P>( prefix + "construct", []( P &p )
+		{
+			auto result = P{};
+			result[ 0 ] = p[ P::Len - 1 ];
+			return result[ 0 ];
+		} );
+		add_operation<P>( prefix + "get_size", []( P &p ) { return p.get_size( ) + size_t( p[ 0 ] ); } );
+		add_operation<P>( prefix + "operator[]", []( P &p ) { return std::as_const( p )[ P::Len - 1 ]; } );
+		add_operation<P>( prefix + "at", []( P &p ) { return std::as_const( p ).at( P::Len - 1 ); } );
+		add_operation<P>( prefix + "get_contents", []( P &p ) { return p.get_contents( )[ P::Len - 1 ]; } );
+		add_operation<P>( prefix + "get_copy", []( P &p ) { return p.get_copy( )[ 0 ]; } );
+		add_operation<P>( prefix + "get_dot", []( P &p ) { return p.get_dot( ); } );
+		add_operation<P>( prefix + "get_length", []( P &p ) { return p.get_length( ); } );
+		add_operation<P>( prefix + "dot_scalar", []( P &p ) { return p.dot( T( 3 ) ); } );
+		add_operation<P>( prefix + "dot_pack", [ other ]( P &p ) { return p.dot( other ); } );
+		add_operation<P>( prefix + "length_scalar", []( P &p ) { return p.length( T( 3 ) ); } );
+		add_operation<P>( prefix + "length_pack", [ other ]( P &p ) { return p.length( other ); } );
+		add_operation<P>( prefix + "project", [ other ]( P &p ) { return p.project( other )[ 0 ]; } );
+
+		if constexpr( P::Len == 3U )
+		{
+			add_operation<P>( prefix + "cross", [ other ]( P &p ) { return p.cross( other )[ 0 ]; } );
+		}
+
+		//	Swizzles, each should cost no more than operator[]
+		add_operation<P>( prefix + "xy", []( P &p ) { return p.xy( )[ 1 ]; } );
+		add_operation<P>( prefix + "yx", []( P &p ) { return p.yx( )[ 1 ]; } );
+
+		if constexpr( P::Len >= 3U )
+		{
+			add_operation<P>( prefix + "xz", []( P &p ) { return p.xz( )[ 1 ]; } );
+			add_operation<P>( prefix + "yz", []( P &p ) { return p.yz( )[ 1 ]; } );
+			add_operation<P>( prefix + "xyz", []( P &p ) { return p.xyz( )[ 2 ]; } );
+			add_operation<P>( prefix + "zyx", []( P &p ) { return p.zyx( )[ 2 ]; } );
+		}
+
+		if constexpr( std::is_same_v<T, float> )
+		{
+			add_operation<P>( prefix + "normalize_length", []( P &p ) { p.normalize_length( ); return p[ 0 ]; } );
+			add_operation<P>( prefix + "normalized_length", []( P &p ) { return p.normalized_length( )[ 0 ]; } );
+
+			//	Plane methods expect a unit normal
+			const auto normal = other.normalized_length( );
+
+			add_operation<P>( prefix + "get_plane_distance", [ normal ]( P &p ) { return p.get_plane_distance( normal, T( 16 ) ); } );
+			add_operation<P>( prefix + "reflect", [ normal ]( P &p ) { return p.reflect( normal )[ 0 ]; } );
+
+			//	Long lived directions, everything after the first call
+			add( prefix + "cached/normalized_length", [ inputs = make_inputs<P>( Batch, 18 ) ]( const size_t operations )
+			{
+				static auto outputs = std::vector<T>( Batch );
+				static auto packs   = [ &inputs ]
+				{
+					auto result = std::vector<cached_pack_t<P>>{ };
+
+					for( const auto &input : inputs )
+					{
+						result.emplace_back( input );
+					}
+
+					return result;
+				}( );
+
+				for( auto done = size_t{ 0 }; done < operations; done += Batch )
+				{
+					const auto count = std::min( Batch, operations - done );
+
+					for( auto i = size_t{ 0 }; i < count; ++i )
+					{
+						outputs[ i ] = packs[ i ].normalized_length( )[ 0 ];
+					}
+
+					sink( outputs[ done % count ] );
+				}
+			} );
+		}
+
+		if constexpr( std::is_same_v<T, float> && P::Len == 3U )
+		{
+			add_operation<P>( prefix + "normalize_angle", []( P &p ) { p.normalize_angle( ); return p[ 0 ]; } );
+			add_operation<P>( prefix + "normalized_angle", []( P &p ) { return p.normalized_angle( )[ 0 ]; } );
+			add_operation<P>( prefix + "get_angle", []( P &p ) { return p.get_angle( )[ 0 ]; } );
+			add_operation<P>( prefix + "clamp_angle", []( P &p ) { p.clamp_angle( ); return p[ 0 ]; } );
+		}
+	}
+
+	/**
+	 * Batch kernels with their own entry points rather than per pack calls
+	 */
+	template <typename P>
+	auto add_views( const std::string &type )->void
+	{
+		using T = typename P::Type;
+
+		const auto prefix = type + "/v" + std::to_string( P::Len ) + "/view/";
+
+		add( prefix + "get_dot", [ inputs = make_inputs<P>( Batch, 4 ) ]( const size_t operations ) mutable
+		{
+			static auto outputs = std::vector<T>( Batch );
+			const auto view     = strided_view_t<const P>{ reinterpret_cast<const T *>( inputs.data( ) ), Batch, sizeof( P ) };
+
+			for( auto done = size_t{ 0 }; done < operations; done += Batch )
+			{
+				view.get_dot( outputs );
+				sink( outputs[ done % Batch ] );
+			}
+		} );
+
+		add( prefix + "get_length", [ inputs = make_inputs<P>( Batch, 5 ) ]( const size_t operations ) mutable
+		{
+			using L = typename strided_view_t<const P>::Length;
+
+			static auto outputs = std::vector<L>( Batch );
+			const auto view     = strided_view_t<const P>{ reinterpret_cast<const T *>( inputs.data( ) ), Batch, sizeof( P ) };
+
+			for( auto done = size_t{ 0 }; done < operations; done += Batch )
+			{
+				view.get_length( outputs );
+				sink( outputs[ done % Batch ] );
+			}
+		} );
+
+		if constexpr( std::is_same_v<T, float> )
+		{
+			add( prefix + "normalize_length", [ inputs = make_inputs<P>( Batch, 6 ) ]( const size_t operations ) mutable
+			{
+				const auto view = strided_view_t<P>{ reinterpret_cast<T *>( inputs.data( ) ), Batch, sizeof( P ) };
+
+				for( auto done = size_t{ 0 }; done < operations; done += Batch )
+				{
+					view.normalize_length( );
+					sink( inputs[ done % Batch ][ 0 ] );
+				}
+			} );
+		}
+	}
+
+	/**
+	 * Layout conversions, per element so they line up against the kernels they feed
+	 */
+	template <typename P>
+	auto add_layout( const std::string &type )->void
+	{
+		const auto prefix = type + "/v" + std::to_string( P::Len ) + "/layout/";
+
+		add( prefix + "soa_load", [ inputs = make_inputs<P>( Batch, 8 ) ]( const size_t operations )
+		{
+			static auto batch = soa_batch_t<P>{ };
+
+			for( auto done = size_t{ 0 }; done < operations; done += Batch )
+			{
+				batch.load( std::span<const P>{ inputs.data( ), inputs.size( ) } );
+				sink( batch.lane( 0 )[ done % Batch ] );
+			}
+		} );
+
+		add( prefix + "soa_store", [ inputs = make_inputs<P>( Batch, 9 ) ]( const size_t operations )
+		{
+			static auto batch   = soa_batch_t<P>{ };
+			static auto outputs = std::vector<P>( Batch );
+
+			batch.load( std::span<const P>{ inputs.data( ), inputs.size( ) } );
+
+			for( auto done = size_t{ 0 }; done < operations; done += Batch )
+			{
+				batch.store( outputs );
+				sink( outputs[ done % Batch ][ 0 ] );
+			}
+		} );
+
+		add( prefix + "aosoa_load", [ inputs = make_inputs<P>( Batch, 10 ) ]( const size_t operations )
+		{
+			static auto batch = aosoa_batch_t<P>{ };
+
+			for( auto done = size_t{ 0 }; done < operations; done += Batch )
+			{
+				batch.load( std::span<const P>{ inputs.data( ), inputs.size( ) } );
+				sink( batch.get( done % Batch )[ 0 ] );
+			}
+		} );
+
+		add( prefix + "aosoa_store", [ inputs = make_inputs<P>( Batch, 11 ) ]( const size_t operations )
+		{
+			static auto batch   = aosoa_batch_t<P>{ };
+			static auto outputs = std::vector<P>( Batch );
+
+			batch.load( std::span<const P>{ inputs.data( ), inputs.size( ) } );
+
+			for( auto done = size_t{ 0 }; done < operations; done += Batch )
+			{
+				batch.store( outputs );
+				sink( outputs[ done % Batch ][ 0 ] );
+			}
+		} );
+	}
+
+	/**
+	 * Every dispatched kernel once per instruction set this CPU runs,
+	 * so e.g. --filter kernels/ lines the AVX2 and AVX-512 variants up
+	 */
+	inline auto add_kernels( )->void
+	{
+		using P = vector_t<float>::v3;
+
+		constexpr const char *Names[] = { "scalar", "sse2", "avx2", "avx512" };
+
+		//	Not a multiple of any width so the tail path is part of the measurement
+		constexpr auto Count = Batch - 5;
+
+		for( auto isa = isa_t::scalar; isa <= get_isa( ); isa = static_cast<isa_t>( static_cast<int>( isa ) + 1 ) )
+		{
+			const auto table  = get_kernels( isa );
+			const auto prefix = std::string{ "float/v3/kernels/" } + Names[ static_cast<int>( isa ) ] + "/";
+
+			const auto inputs = make_inputs<P>( Count, 7 );
+
+			auto batch = std::make_shared<soa_batch_t<P>>( );
+			batch->load( std::span<const P>{ inputs.data( ), inputs.size( ) } );
+
+			const auto run = [ batch ]( auto kernel )
+			{
+				return [ batch, kernel ]( const size_t operations )
+				{
+					static auto outputs = std::vector<float>( Batch );
+
+					auto lanes = std::array<float *, P::Len>{ };
+
+					for( auto c = size_t{ 0 }; c < P::Len; ++c )
+					{
+						lanes[ c ] = batch->lane( c );
+					}
+
+					//	The last call only covers what is left so exactly operations elements run
+					for( auto done = size_t{ 0 }; done < operations; done += Count )
+					{
+						kernel( lanes, outputs.data( ), std::min( size_t{ Count }, operations - done ) );
+						sink( outputs[ 0 ] + lanes[ 0 ][ done % Count ] );
+					}
+				};
+			};
+
+			add( prefix + "get_dot", run( [ table ]( const auto &lanes, float *outputs, const size_t count ) { table.get_dot( lanes.data( ), P::Len, outputs, count ); } ) );
+			add( prefix + "get_length", run( [ table ]( const auto &lanes, float *outputs, const size_t count ) { table.get_length( lanes.data( ), P::Len, outputs, count ); } ) );
+			add( prefix + "normalize_length", run( [ table ]( const auto &lanes, float *, const size_t count ) { table.normalize_length( lanes.data( ), P::Len, count ); } ) );
+			add( prefix + "normalize_angle", run( [ table ]( const auto &lanes, float *, const size_t count ) { table.normalize_angle( lanes[ 0 ], lanes[ 1 ], lanes[ 2 ], count ); } ) );
+			add( prefix + "clamp_angle", run( [ table ]( const auto &lanes, float *, const size_t count ) { table.clamp_angle( lanes[ 0 ], lanes[ 1 ], lanes[ 2 ], count ); } ) );
+			add( prefix + "get_angle", run( [ table ]( const auto &lanes, float *outputs, const size_t count )
+			{
+				static auto angles = std::vector<float>( Batch * 2 );
+				table.get_angle( lanes[ 0 ], lanes[ 1 ], lanes[ 2 ], outputs, angles.data( ), angles.data( ) + Batch, count );
+			} ) );
+		}
+	}
+
+	/**
+	 * Spin on a queue, yielding now and then so the other side gets to run when both share
+	 * a core
+	 */
+	inline auto back_off( size_t &spins )->void
+	{
+		if( ++spins % 64 == 0 )
+		{
+			std::this_thread::yield( );
+		}
+	}
+
+	/**
+	 * Ping pong a batch handle with a second thread through two queues of type Q. One
+	 * operation is one round trip, two stage to stage handoffs
+	 *
+	 * \param operations
+	 * \param size		elements in the batch, never touched
+	 */
+	template <typename Q>
+	auto hand_off( const size_t operations, const size_t size )->void
+	{
+		using handle_t = std::unique_ptr<soa_batch_t<vector_t<float>::v3>>;
+
+		auto forward  = Q{ 2 };
+		auto backward = Q{ 2 };
+
+		auto echo = std::thread( [ &forward, &backward, operations ]( )
+		{
+			auto handle = handle_t{ };
+			auto spins  = size_t{ 0 };
+
+			for( auto done = size_t{ 0 }; done < operations; ++done )
+			{
+				while( !forward.try_pop( handle ) )
+				{
+					back_off( spins );
+				}
+
+				while( !backward.try_push( std::move( handle ) ) )
+				{
+					back_off( spins );
+				}
+			}
+		} );
+
+		auto batch = std::make_unique<soa_batch_t<vector_t<float>::v3>>( size );
+		auto spins = size_t{ 0 };
+
+		for( auto done = size_t{ 0 }; done < operations; ++done )
+		{
+			while( !forward.try_push( std::move( batch ) ) )
+			{
+				back_off( spins );
+			}
+
+			while( !backward.try_pop( batch ) )
+			{
+				back_off( spins );
+			}
+		}
+
+		echo.join( );
+		sink( batch->get_size( ) );
+	}
+
+	/**
+	 * Batched point traces through as many props as the sweep case, through the box
+	 * hierarchy when Built and against every box otherwise. One operation is one segment
+	 *
+	 * \param operations
+	 */
+	template <bool Built>
+	auto trace_props( const size_t operations )->void
+	{
+		using P = vector_t<float>::v3;
+
+		constexpr auto Props    = size_t{ 512 };
+		constexpr auto Segments = size_t{ 256 };
+
+		static auto props     = box_geometry_t{ };
+		static auto starts    = soa_batch_t<P>{ };
+		static auto ends      = soa_batch_t<P>{ };
+		static auto normals   = soa_batch_t<P>{ };
+		static auto fractions = std::vector<float>( Segments );
+
+		if( props.get_size( ) == 0 )
+		{
+			for( const auto &center : make_inputs<P>( Props, 15 ) )
+			{
+				props.add( P{ center[ 0 ] - 24.F, center[ 1 ] - 24.F, center[ 2 ] - 24.F }, P{ center[ 0 ] + 24.F, center[ 1 ] + 24.F, center[ 2 ] + 24.F } );
+			}
+
+			if constexpr( Built )
+			{
+				props.build( );
+			}
+
+			const auto from  = make_inputs<P>( Segments, 16 );
+			const auto delta = make_inputs<P>( Segments, 17 );
+
+			for( auto i = size_t{ 0 }; i < Segments; ++i )
+			{
+				starts.push_back( from[ i ] );
+				ends.push_back( P{ from[ i ][ 0 ] + delta[ i ][ 0 ], from[ i ][ 1 ] + delta[ i ][ 1 ], from[ i ][ 2 ] + delta[ i ][ 2 ] } );
+			}
+
+			normals.resize( Segments );
+		}
+
+		const auto start  = detail::get_lanes( starts );
+		const auto end    = detail::get_lanes( ends );
+		const auto normal = detail::get_lanes( normals );
+
+		for( auto done = size_t{ 0 }; done < operations; done += Segments )
+		{
+			const auto count = std::min( Segments, operations - done );
+
+			props.trace( trace_batch_t{
+				{ start[ 0 ], start[ 1 ], start[ 2 ] },
+				{ end[ 0 ], end[ 1 ], end[ 2 ] },
+				fractions.data( ),
+				{ normal[ 0 ], normal[ 1 ], normal[ 2 ] },
+				count } );
+
+			sink( fractions[ 0 ] );
+		}
+	}
+
+	/**
+	 * Whole simulations, one operation per simulated entity
+	 */
+	inline auto add_simulations( )->void
+	{
+		using P = vector_t<float>::v3;
+
+		constexpr auto Throws = size_t{ 10000 };
+
+		add( "float/v3/grenade/simulate", [ ]( const size_t operations )
+		{
+			static auto geometry = [ ]
+			{
+				auto result = plane_geometry_t{ };
+				result.add( P{ 0.F, 0.F, 1.F }, 0.F );
+				result.add( P{ -1.F, 0.F, 0.F }, -800.F );
+				result.add( P{ 1.F, 0.F, 0.F }, -800.F );
+				return result;
+			}( );
+
+			static auto simulator = grenade_simulator_t<plane_geometry_t>{ geometry };
+			static auto origins   = soa_batch_t<P>{ };
+			static auto velocity  = soa_batch_t<P>{ };
+			static auto ends      = soa_batch_t<P>{ };
+			static auto times     = std::vector<float>( Throws );
+
+			if( velocity.get_size( ) == 0 )
+			{
+				const auto inputs = make_inputs<P>( Throws, 12 );
+				velocity.load( std::span<const P>{ inputs.data( ), inputs.size( ) } );
+			}
+
+			//	The last call only throws what is left so exactly operations throws run
+			for( auto done = size_t{ 0 }; done < operations; done += Throws )
+			{
+				const auto count = std::min( size_t{ Throws }, operations - done );
+
+				if( origins.get_size( ) != count )
+				{
+					origins.resize( count );
+
+					for( auto i = size_t{ 0 }; i < count; ++i )
+					{
+						origins.set( i, P{ 0.F, 0.F, 64.F } );
+					}
+				}
+
+				simulator.simulate( origins, velocity, ends, times );
+				sink( times[ done % count ] );
+			}
+		} );
+
+		//	64 bots, 16 candidate inputs each, 8 ticks ahead
+		constexpr auto Bots       = size_t{ 64 };
+		constexpr auto Candidates = size_t{ 16 };
+		constexpr auto Ticks      = size_t{ 8 };
+
+		add( "float/v3/movement/predict", [ ]( const size_t operations )
+		{
+			static auto predictor  = movement_predictor_t{ };
+			static auto origins    = soa_batch_t<P>{ };
+			static auto velocities = soa_batch_t<P>{ };
+			static auto wishes     = soa_batch_t<P>{ };
+			static auto ground     = std::vector<uint8_t>( Bots );
+			static auto out_origin = soa_batch_t<P>{ };
+			static auto out_speed  = soa_batch_t<P>{ };
+
+			if( origins.get_size( ) == 0 )
+			{
+				const auto positions = make_inputs<P>( Bots, 13 );
+				const auto speeds    = make_inputs<P>( Bots, 14 );
+
+				origins.load( std::span<const P>{ positions.data( ), positions.size( ) } );
+				velocities.load( std::span<const P>{ speeds.data( ), speeds.size( ) } );
+
+				for( auto k = size_t{ 0 }; k < Candidates; ++k )
+				{
+					const auto angle = static_cast<float>( k ) * ( 2.F * static_cast<float>( M_PI ) / Candidates );
+					wishes.push_back( P{ std::cos( angle ) * 450.F, std::sin( angle ) * 450.F, 0.F } );
+				}
+
+				for( auto b = size_t{ 0 }; b < Bots; ++b )
+				{
+					ground[ b ] = static_cast<uint8_t>( b % 4 != 0 );
+				}
+			}
+
+			//	One operation is one bot and candidate advanced by one tick
+			for( auto done = size_t{ 0 }; done < operations; done += Bots * Candidates * Ticks )
+			{
+				predictor.predict( origins, velocities, ground, wishes, Candidates, Ticks, out_origin, out_speed );
+				sink( out_origin.lane( 0 )[ done % ( Bots * Candidates ) ] );
+			}
+		} );
+
+		//	Standing player hull against a few hundred props
+		constexpr auto Boxes = size_t{ 512 };
+
+		add( "float/v3/collision/sweep", [ ]( const size_t operations )
+		{
+			static auto boxes  = box_geometry_t{ };
+			static auto starts = pack_batch_t<P>{ };
+			static auto deltas = pack_batch_t<P>{ };
+
+			if( boxes.get_size( ) == 0 )
+			{
+				const auto centers = make_inputs<P>( Boxes, 15 );
+
+				for( const auto &center : centers )
+				{
+					boxes.add( P{ center[ 0 ] - 24.F, center[ 1 ] - 24.F, center[ 2 ] - 24.F }, P{ center[ 0 ] + 24.F, center[ 1 ] + 24.F, center[ 2 ] + 24.F } );
+				}
+
+				starts = make_inputs<P>( 256, 16 );
+				deltas = make_inputs<P>( 256, 17 );
+			}
+
+			//	One operation is one box tested against one sweep
+			for( auto done = size_t{ 0 }; done < operations; done += Boxes )
+			{
+				const auto i      = ( done / Boxes ) % starts.size( );
+				const auto result = boxes.sweep( starts[ i ], deltas[ i ], P{ -16.F, -16.F, 0.F }, P{ 16.F, 16.F, 72.F } );
+				sink( result.fraction );
+			}
+		} );
+
+		add( "float/v3/collision/trace", trace_props<false> );
+		add( "float/v3/collision/trace_tree", trace_props<true> );
+
+		//	Overlay export, one frame of positions
+		constexpr auto Positions = size_t{ 4096 };
+
+		add( "float/v3/matrix/world_to_screen", [ ]( const size_t operations )
+		{
+			static auto positions = soa_batch_t<P>{ };
+			static auto screen    = soa_batch_t<vector_t<float>::v2>{ };
+			static auto visible   = std::vector<uint8_t>( Positions );
+
+			const auto matrix = matrix4x4_t{
+				vector_t<float>::v4{ 0.8F, 0.6F, 0.F, 10.F },
+				vector_t<float>::v4{ -0.1F, 0.2F, 1.2F, -40.F },
+				vector_t<float>::v4{ 0.F, 0.F, 0.F, 0.F },
+				vector_t<float>::v4{ 0.0006F, -0.0008F, 0.00005F, 1.F } };
+
+			if( positions.get_size( ) == 0 )
+			{
+				const auto inputs = make_inputs<P>( Positions, 19 );
+				positions.load( std::span<const P>{ inputs.data( ), inputs.size( ) } );
+			}
+
+			for( auto done = size_t{ 0 }; done < operations; done += Positions )
+			{
+				world_to_screen( positions, matrix, 1920.F, 1080.F, screen, visible );
+				sink( screen.lane( 0 )[ done % Positions ] + visible[ done % Positions ] );
+			}
+		} );
+
+		add( "float/v3/frustum/cull_spheres", [ ]( const size_t operations )
+		{
+			static auto centers = soa_batch_t<P>{ };
+			static auto radii   = std::vector<float>( Positions, 32.F );
+			static auto indices = std::vector<uint32_t>( Positions );
+
+			const auto frustum = frustum_t::from_angles( P{ 0.F, 0.F, 64.F }, P{ 10.F, 30.F, 0.F }, 90.F, 16.F / 9.F, 4.F, 4096.F );
+
+			if( centers.get_size( ) == 0 )
+			{
+				const auto inputs = make_inputs<P>( Positions, 20 );
+				centers.load( std::span<const P>{ inputs.data( ), inputs.size( ) } );
+			}
+
+			for( auto done = size_t{ 0 }; done < operations; done += Positions )
+			{
+				const auto found = frustum.cull_spheres( centers, radii, { }, indices );
+				sink( found );
+			}
+		} );
+
+		//	Full server between pillars
+		constexpr auto Players = size_t{ 64 };
+
+		add( "float/v3/occlusion/update", [ ]( const size_t operations )
+		{
+			static auto pillars    = box_geometry_t{ };
+			static auto origins    = soa_batch_t<P>{ };
+			static auto eyes       = soa_batch_t<P>{ };
+			static auto angles     = soa_batch_t<P>{ };
+			static auto velocities = pack_batch_t<P>{ };
+			static auto visible    = std::vector<uint8_t>( Players * Players );
+
+			static auto culler = occlusion_culler_t<box_geometry_t>{ pillars };
+
+			if( origins.get_size( ) == 0 )
+			{
+				for( const auto &center : make_inputs<P>( Boxes / 8, 21 ) )
+				{
+					pillars.add( P{ center[ 0 ] - 48.F, center[ 1 ] - 48.F, 0.F }, P{ center[ 0 ] + 48.F, center[ 1 ] + 48.F, 128.F } );
+				}
+
+				pillars.build( );
+
+				for( const auto &spawn : make_inputs<P>( Players, 22 ) )
+				{
+					origins.push_back( P{ spawn[ 0 ], spawn[ 1 ], 0.F } );
+					eyes.push_back( P{ spawn[ 0 ], spawn[ 1 ], 64.F } );
+					angles.push_back( P{ spawn[ 2 ] * 0.01F, spawn[ 2 ] * 0.18F, 0.F } );
+				}
+
+				velocities = make_inputs<P>( Players, 23 );
+			}
+
+			//	One operation is one viewer and target pair, every other player holds an angle
+			for( auto done = size_t{ 0 }; done < operations; done += Players * Players )
+			{
+				for( auto i = size_t{ 1 }; i < Players; i += 2 )
+				{
+					auto origin = origins.get( i );
+
+					origin[ 0 ] += velocities[ i ][ 0 ] * 0.004F;
+					origin[ 1 ] += velocities[ i ][ 1 ] * 0.004F;
+
+					origins.set( i, origin );
+					eyes.set( i, P{ origin[ 0 ], origin[ 1 ], 64.F } );
+				}
+
+				culler.update( eyes, angles, origins, { }, visible );
+				sink( visible[ done % ( Players * Players ) ] + culler.get_traces( ) );
+			}
+		} );
+
+		//	Every hitbox of a full server
+		constexpr auto Hitboxes = Players * 19;
+
+		const auto make_hitboxes = [ ]( obb_batch_t &boxes )
+		{
+			const auto angles  = make_inputs<P>( Hitboxes, 24 );
+			const auto origins = make_inputs<P>( Hitboxes, 25 );
+
+			for( auto i = size_t{ 0 }; i < Hitboxes; ++i )
+			{
+				const auto bone = matrix3x4_t::from_angles( angles[ i ], origins[ i ] );
+				boxes.add( obb_t::from_matrix( bone, P{ -4.F, -3.F, -3.F }, P{ 6.F, 3.F, 3.F } ) );
+			}
+		};
+
+		//	The first count hitboxes, so the last pass of a bench only covers what is left.
+		//	Rebuilt only when count changes, which is once per measured operation count
+		const auto get_prefix = [ ]( const obb_batch_t &boxes, obb_batch_t &prefix, const size_t count )->const obb_batch_t &
+		{
+			if( count == boxes.get_size( ) )
+			{
+				return boxes;
+			}
+
+			if( prefix.get_size( ) != count )
+			{
+				prefix.clear( );
+
+				for( auto i = size_t{ 0 }; i < count; ++i )
+				{
+					prefix.add( boxes.get( i ) );
+				}
+			}
+
+			return prefix;
+		};
+
+		add( "float/v3/obb/ray", [ make_hitboxes, get_prefix ]( const size_t operations )
+		{
+			static auto boxes     = obb_batch_t{ };
+			static auto prefix    = obb_batch_t{ };
+			static auto fractions = std::vector<float>( Hitboxes );
+			static auto indices   = std::vector<uint32_t>( Hitboxes );
+
+			if( boxes.get_size( ) == 0 )
+			{
+				make_hitboxes( boxes );
+			}
+
+			//	One operation is one bullet against one hitbox
+			for( auto done = size_t{ 0 }; done < operations; done += Hitboxes )
+			{
+				const auto &batch = get_prefix( boxes, prefix, std::min( size_t{ Hitboxes }, operations - done ) );
+				const auto hits   = batch.intersect_ray( P{ -1000.F, 0.F, 0.F }, P{ 2000.F, static_cast<float>( done % 997 ), 10.F }, fractions, { }, indices );
+				sink( fractions[ done % batch.get_size( ) ] + hits );
+			}
+		} );
+
+		add( "float/v3/obb/overlap", [ make_hitboxes, get_prefix ]( const size_t operations )
+		{
+			static auto boxes   = obb_batch_t{ };
+			static auto prefix  = obb_batch_t{ };
+			static auto overlap = std::vector<uint8_t>( Hitboxes );
+
+			if( boxes.get_size( ) == 0 )
+			{
+				make_hitboxes( boxes );
+			}
+
+			const auto probe = obb_t::from_matrix( matrix3x4_t::from_angles( P{ 10.F, 45.F, 0.F } ), P{ -300.F, -300.F, -300.F }, P{ 300.F, 300.F, 300.F } );
+
+			//	One operation is one box pair
+			for( auto done = size_t{ 0 }; done < operations; done += Hitboxes )
+			{
+				const auto &batch = get_prefix( boxes, prefix, std::min( size_t{ Hitboxes }, operations - done ) );
+				const auto found  = batch.intersect( probe, overlap );
+				sink( overlap[ done % batch.get_size( ) ] + found );
+			}
+		} );
+
+		add( "float/v3/morton/sort", [ ]( const size_t operations )
+		{
+			static auto positions = soa_batch_t<P>{ };
+			static auto shuffled  = soa_batch_t<P>{ };
+			static auto sorter    = morton_sorter_t{ };
+
+			if( shuffled.get_size( ) == 0 )
+			{
+				const auto inputs = make_inputs<P>( Batch, 26 );
+				shuffled.load( std::span<const P>{ inputs.data( ), inputs.size( ) } );
+			}
+
+			//	One operation is one position keyed, sorted and moved
+			for( auto done = size_t{ 0 }; done < operations; done += Batch )
+			{
+				positions = shuffled;
+
+				sorter.sort( positions );
+				sorter.apply( positions );
+				sink( positions.lane( 0 )[ done % Batch ] );
+			}
+		} );
+
+		//	Positions and angles of every entity, published once a tick
+		add( "float/v3/snapshot/publish", [ ]( const size_t operations )
+		{
+			static auto publisher = snapshot_publisher_t<P, P>{ Positions };
+			static auto positions = soa_batch_t<P>{ Positions };
+			static auto angles    = soa_batch_t<P>{ Positions };
+
+			//	One operation is one entity
+			for( auto done = size_t{ 0 }; done < operations; done += Positions )
+			{
+				publisher.publish( positions, angles );
+				sink( publisher.get_version( ) );
+			}
+		} );
+
+		add( "float/v3/snapshot/read", [ ]( const size_t operations )
+		{
+			static auto publisher = snapshot_publisher_t<P, P>{ Positions };
+			static auto positions = soa_batch_t<P>{ Positions };
+			static auto angles    = soa_batch_t<P>{ Positions };
+
+			if( publisher.get_version( ) == 0 )
+			{
+				publisher.publish( positions, angles );
+			}
+
+			for( auto done = size_t{ 0 }; done < operations; done += Positions )
+			{
+				sink( publisher.read( positions, angles ) );
+			}
+		} );
+
+		//	A batch handle through a stage queue and back on one thread, the cost of the queue
+		//	operations alone. Contents never move
+		add( "float/v3/queue/spsc", [ ]( const size_t operations )
+		{
+			static auto queue = spsc_queue_t<std::unique_ptr<soa_batch_t<P>>>{ 64 };
+			static auto batch = std::make_unique<soa_batch_t<P>>( soa_batch_t<P>{ Positions } );
+
+			//	One operation is one push and one pop
+			for( auto done = size_t{ 0 }; done < operations; ++done )
+			{
+				queue.try_push( std::move( batch ) );
+				queue.try_pop( batch );
+			}
+
+			sink( batch->get_size( ) );
+		} );
+
+		add( "float/v3/queue/mpsc", [ ]( const size_t operations )
+		{
+			static auto queue = mpsc_queue_t<std::unique_ptr<soa_batch_t<P>>>{ 64 };
+			static auto batch = std::make_unique<soa_batch_t<P>>( soa_batch_t<P>{ Positions } );
+
+			for( auto done = size_t{ 0 }; done < operations; ++done )
+			{
+				queue.try_push( std::move( batch ) );
+				queue.try_pop( batch );
+			}
+
+			sink( batch->get_size( ) );
+		} );
+
+		add( "float/v3/queue/spsc_handoff", [ ]( const size_t operations )
+		{
+			hand_off<spsc_queue_t<std::unique_ptr<soa_batch_t<P>>>>( operations, Positions );
+		} );
+
+		add( "float/v3/queue/mpsc_handoff", [ ]( const size_t operations )
+		{
+			hand_off<mpsc_queue_t<std::unique_ptr<soa_batch_t<P>>>>( operations, Positions );
+		} );
+	}
+
+	template <typename T>
+	auto add_type( const std::string &type )->void
+	{
+		add_pack<typename vector_t<T>::v2>( type );
+		add_pack<typename vector_t<T>::v3>( type );
+		add_pack<typename vector_t<T>::v4>( type );
+
+		add_views<typename vector_t<T>::v2>( type );
+		add_views<typename vector_t<T>::v3>( type );
+		add_views<typename vector_t<T>::v4>( type );
+
+		add_layout<typename vector_t<T>::v2>( type );
+		add_layout<typename vector_t<T>::v3>( type );
+		add_layout<typename vector_t<T>::v4>( type );
+	}
+
+	//	============================================================================================
+	//	Reporting
+	//	============================================================================================
+
+	inline auto write_json( const std::string &path, const std::vector<result_t> &results )->bool
+	{
+		auto file = std::ofstream{ path };
+
+		if( !file )
+		{
+			return false;
+		}
+
+		file << "{\n\t\"benchmarks\": [\n";
+
+		for( auto i = size_t{ 0 }; i < results.size( ); ++i )
+		{
+			const auto &result = results[ i ];
+
+			file << "\t\t{ \"name\": \"" << result.name << "\", \"ns_per_op\": " << result.ns_per_op
+				 << ", \"ns_per_op_min\": " << result.ns_per_op_min << ", \"operations\": " << result.operations << " }"
+				 << ( i + 1 < results.size( ) ? ",\n" : "\n" );
+		}
+
+		file << "\t]\n}\n";
+		return true;
+	}
+
+	/**
+	 * Reads back what write_json produced, not a general JSON parser
+	 *
+	 * \param path
+	 * \return
+	 */
+	inline auto read_json( const std::string &path )->std::map<std::string, double>
+	{
+		auto file   = std::ifstream{ path };
+		auto result = std::map<std::string, double>{};
+		auto line   = std::string{};
+
+		constexpr auto Name = std::string_view{ "\"name\": \"" };
+		constexpr auto Time = std::string_view{ "\"ns_per_op\": " };
+
+		while( std::getline( file, line ) )
+		{
+			const auto name = line.find( Name );
+			const auto time = line.find( Time );
+
+			if( name == std::string::npos || time == std::string::npos )
+			{
+				continue;
+			}
+
+			const auto begin = name + Name.size( );
+			const auto end   = line.find( '"', begin );
+
+			result[ line.substr( begin, end - begin ) ] = std::strtod( line.c_str( ) + time + Time.size( ), nullptr );
+		}
+
+		return result;
+	}
+}
+
+int main( int argc, char **argv )
+{
+	auto filter    = std::string{};
+	auto json      = std::string{};
+	auto baseline  = std::string{};
+	auto tolerance = 0.10;
+
+	for( auto i = 1; i < argc; ++i )
+	{
+		const auto argument = std::string_view{ argv[ i ] };
+		const auto has_next = i + 1 < argc;
+
+		if( argument == "--filter" && has_next )
+		{
+			filter = argv[ ++i ];
+		}
+		else if( argument == "--json" && has_next )
+		{
+			json = argv[ ++i ];
+		}
+		else if( argument == "--baseline" && has_next )
+		{
+			baseline = argv[ ++i ];
+		}
+		else if( argument == "--tolerance" && has_next )
+		{
+			tolerance = std::strtod( argv[ ++i ], nullptr );
+		}
+		else
+		{
+			std::fprintf( stderr, "usage: %s [--filter s] [--json file] [--baseline file] [--tolerance ratio]\n", argv[ 0 ] );
+			return 2;
+		}
+	}
+
+	bench::add_type<float>( "float" );
+	bench::add_type<double>( "double" );
+	bench::add_type<int>( "int" );
+	bench::add_kernels( );
+	bench::add_simulations( );
+
+	auto results = std::vector<bench::result_t>{};
+
+	for( const auto &entry : bench::get_cases( ) )
+	{
+		if( !filter.empty( ) && entry.name.find( filter ) == std::string::npos )
+		{
+			continue;
+		}
+
+		results.push_back( bench::measure( entry ) );
+
+		const auto &result = results.back( );
+		std::printf( "%-48s %10.3f ns/op %10.3f min\n", result.name.c_str( ), result.ns_per_op, result.ns_per_op_min );
+	}
+
+	if( !json.empty( ) && !bench::write_json( json, results ) )
+	{
+		std::fprintf( stderr, "cannot write %s\n", json.c_str( ) );
+		return 2;
+	}
+
+	if( baseline.empty( ) )
+	{
+		return 0;
+	}
+
+	const auto reference = bench::read_json( baseline );
+	auto regressions     = 0;
+
+	for( const auto &result : results )
+	{
+		const auto found = reference.find( result.name );
+
+		if( found == reference.end( ) || found->second <= 0.0 )
+		{
+			continue;
+		}
+
+		const auto ratio = result.ns_per_op / found->second;
+
+		if( ratio > 1.0 + tolerance )
+		{
+			std::printf( "REGRESSION %-40s %10.3f -> %10.3f ns/op (%+.1f%%)\n",
+						 result.name.c_str( ), found->second, result.ns_per_op, ( ratio - 1.0 ) * 100.0 );
+			++regressions;
+		}
+	}
+
+	std::printf( "%d regression(s) against %s\n", regressions, baseline.c_str( ) );
+	return regressions == 0 ? 0 : 1;
+}
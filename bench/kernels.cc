@@ -0,0 +1,721 @@
+//	Self-contained agreement checks for the runtime selectable kernel tables
+//
+//	Build from the repository root, e.g.
+//		cl /std:c++20 /O2 /I. bench\kernels.cc
+//		c++ -std=c++20 -O2 -ffp-contract=off -march=native -I. bench/kernels.cc -o pack_kernels
+//
+//	Usage
+//		pack_kernels [--filter <substring>]
+//
+//	Every entry of every table the CPU supports runs on the same inputs as the scalar
+//	table and has to produce the same bits. Exits with 1 when any entry disagreed
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "dispatch.hh"
+#include "kernels.hh"
+
+namespace agree
+{
+	//	============================================================================================
+	//	Registry
+	//	============================================================================================
+
+	/**
+	 * A check feeds the same inputs to both tables and returns how many outputs differ
+	 */
+	using body_t = std::function<size_t( const kernel_table_t &reference, const kernel_table_t &candidate )>;
+
+	struct check_t
+	{
+		std::string name;
+		body_t body;
+	};
+
+	inline auto get_checks( )->std::vector<check_t> &
+	{
+		static auto checks = std::vector<check_t>{};
+		return checks;
+	}
+
+	inline auto add( std::string name, body_t body )->void
+	{
+		get_checks( ).push_back( { std::move( name ), std::move( body ) } );
+	}
+
+	//	============================================================================================
+	//	Inputs and comparison
+	//	============================================================================================
+
+	//	Not a multiple of any register width so every variant runs its tail
+	constexpr auto Count = size_t{ 1003 };
+
+	using lanes_t = std::vector<std::vector<float>>;
+
+	/**
+	 * len lanes of Count uniform values, the first element of every lane zero to keep
+	 * the zero length branches exercised
+	 */
+	inline auto make_lanes( const size_t len, const unsigned seed, const float low = -1000.F, const float high = 1000.F )->lanes_t
+	{
+		auto engine = std::mt19937{ seed };
+		auto result = lanes_t( len, std::vector<float>( Count ) );
+
+		for( auto &lane : result )
+		{
+			for( auto &value : lane )
+			{
+				value = std::uniform_real_distribution<float>{ low, high }( engine );
+			}
+
+			lane[ 0 ] = 0.F;
+		}
+
+		return result;
+	}
+
+	inline auto get_pointers( lanes_t &lanes )->std::vector<float *>
+	{
+		auto result = std::vector<float *>{ };
+
+		for( auto &lane : lanes )
+		{
+			result.push_back( lane.data( ) );
+		}
+
+		return result;
+	}
+
+	inline auto get_pointers( const lanes_t &lanes )->std::vector<const float *>
+	{
+		auto result = std::vector<const float *>{ };
+
+		for( const auto &lane : lanes )
+		{
+			result.push_back( lane.data( ) );
+		}
+
+		return result;
+	}
+
+	/**
+	 * Elements whose bits differ, so -0 against 0 and one NaN against another count
+	 */
+	template <typename T>
+	auto count_different( const std::vector<T> &a, const std::vector<T> &b )->size_t
+	{
+		auto result = a.size( ) == b.size( ) ? size_t{ 0 } : size_t{ 1 };
+
+		for( auto i = size_t{ 0 }; i < std::min( a.size( ), b.size( ) ); ++i )
+		{
+			if constexpr( std::is_same_v<T, float> )
+			{
+				result += std::bit_cast<uint32_t>( a[ i ] ) != std::bit_cast<uint32_t>( b[ i ] ) ? 1 : 0;
+			}
+			else
+			{
+				result += a[ i ] != b[ i ] ? 1 : 0;
+			}
+		}
+
+		return result;
+	}
+
+	inline auto count_different( const lanes_t &a, const lanes_t &b )->size_t
+	{
+		auto result = size_t{ 0 };
+
+		for( auto c = size_t{ 0 }; c < a.size( ); ++c )
+		{
+			result += count_different( a[ c ], b[ c ] );
+		}
+
+		return result;
+	}
+
+	/**
+	 * Run op once per table on its own copy of inputs and compare the copies after
+	 */
+	template <typename Op>
+	auto compare( const kernel_table_t &reference, const kernel_table_t &candidate, const lanes_t &inputs, Op op )->size_t
+	{
+		auto expected = inputs;
+		auto actual   = inputs;
+
+		op( reference, expected );
+		op( candidate, actual );
+
+		return count_different( expected, actual );
+	}
+
+	//	============================================================================================
+	//	Packs
+	//	============================================================================================
+
+	inline auto add_packs( )->void
+	{
+		for( auto len = size_t{ 2 }; len <= 4; ++len )
+		{
+			const auto suffix = "/v" + std::to_string( len );
+
+			//	Lanes 0 .. len - 1 are the input, lane len the output
+			add( "get_dot" + suffix, [ len ]( const kernel_table_t &reference, const kernel_table_t &candidate )
+			{
+				return compare( reference, candidate, make_lanes( len + 1, 1 ), [ len ]( const kernel_table_t &table, lanes_t &lanes )
+				{
+					table.get_dot( get_pointers( std::as_const( lanes ) ).data( ), len, lanes[ len ].data( ), Count );
+				} );
+			} );
+
+			add( "get_length" + suffix, [ len ]( const kernel_table_t &reference, const kernel_table_t &candidate )
+			{
+				return compare( reference, candidate, make_lanes( len + 1, 2 ), [ len ]( const kernel_table_t &table, lanes_t &lanes )
+				{
+					table.get_length( get_pointers( std::as_const( lanes ) ).data( ), len, lanes[ len ].data( ), Count );
+				} );
+			} );
+
+			add( "normalize_length" + suffix, [ len ]( const kernel_table_t &reference, const kernel_table_t &candidate )
+			{
+				return compare( reference, candidate, make_lanes( len, 3 ), [ len ]( const kernel_table_t &table, lanes_t &lanes )
+				{
+					table.normalize_length( get_pointers( lanes ).data( ), len, Count );
+				} );
+			} );
+
+			add( "translate" + suffix, [ len ]( const kernel_table_t &reference, const kernel_table_t &candidate )
+			{
+				const auto offset = std::vector<float>{ 1.5F, -2.25F, 1000.125F, -0.001F };
+
+				return compare( reference, candidate, make_lanes( len, 4 ), [ len, &offset ]( const kernel_table_t &table, lanes_t &lanes )
+				{
+					table.translate( get_pointers( lanes ).data( ), len, offset.data( ), Count );
+				} );
+			} );
+
+			//	Lanes 0 .. len - 1 move along lanes len .. 2 len - 1
+			add( "add_scaled" + suffix, [ len ]( const kernel_table_t &reference, const kernel_table_t &candidate )
+			{
+				return compare( reference, candidate, make_lanes( len * 2, 5 ), [ len ]( const kernel_table_t &table, lanes_t &lanes )
+				{
+					const auto pointers = get_pointers( lanes );
+					table.add_scaled( pointers.data( ), pointers.data( ) + len, len, 0.015625F * 3.F, Count );
+				} );
+			} );
+
+			//	Source, onto or normal, destination
+			add( "project" + suffix, [ len ]( const kernel_table_t &reference, const kernel_table_t &candidate )
+			{
+				return compare( reference, candidate, make_lanes( len * 3, 6 ), [ len ]( const kernel_table_t &table, lanes_t &lanes )
+				{
+					const auto pointers = get_pointers( lanes );
+					table.project( pointers.data( ), pointers.data( ) + len, pointers.data( ) + len * 2, len, Count );
+				} );
+			} );
+
+			add( "reflect" + suffix, [ len ]( const kernel_table_t &reference, const kernel_table_t &candidate )
+			{
+				return compare( reference, candidate, make_lanes( len * 3, 7, -1.F, 1.F ), [ len ]( const kernel_table_t &table, lanes_t &lanes )
+				{
+					const auto pointers = get_pointers( lanes );
+					table.reflect( pointers.data( ), pointers.data( ) + len, pointers.data( ) + len * 2, len, Count );
+				} );
+			} );
+
+			add( "get_plane_distance" + suffix, [ len ]( const kernel_table_t &reference, const kernel_table_t &candidate )
+			{
+				const auto normal = std::vector<float>{ 0.48F, -0.6F, 0.64F, 0.F };
+
+				return compare( reference, candidate, make_lanes( len + 1, 8 ), [ len, &normal ]( const kernel_table_t &table, lanes_t &lanes )
+				{
+					table.get_plane_distance( get_pointers( std::as_const( lanes ) ).data( ), len, normal.data( ), 37.5F, lanes[ len ].data( ), Count );
+				} );
+			} );
+		}
+
+		add( "cross/v3", [ ]( const kernel_table_t &reference, const kernel_table_t &candidate )
+		{
+			return compare( reference, candidate, make_lanes( 9, 9 ), [ ]( const kernel_table_t &table, lanes_t &lanes )
+			{
+				const auto pointers = get_pointers( lanes );
+				table.cross( pointers.data( ), pointers.data( ) + 3, pointers.data( ) + 6, Count );
+			} );
+		} );
+
+		//	Well past a full turn so the wrapping matters
+		add( "normalize_angle", [ ]( const kernel_table_t &reference, const kernel_table_t &candidate )
+		{
+			return compare( reference, candidate, make_lanes( 3, 10, -3000.F, 3000.F ), [ ]( const kernel_table_t &table, lanes_t &lanes )
+			{
+				table.normalize_angle( lanes[ 0 ].data( ), lanes[ 1 ].data( ), lanes[ 2 ].data( ), Count );
+			} );
+		} );
+
+		add( "clamp_angle", [ ]( const kernel_table_t &reference, const kernel_table_t &candidate )
+		{
+			return compare( reference, candidate, make_lanes( 3, 11, -3000.F, 3000.F ), [ ]( const kernel_table_t &table, lanes_t &lanes )
+			{
+				table.clamp_angle( lanes[ 0 ].data( ), lanes[ 1 ].data( ), lanes[ 2 ].data( ), Count );
+			} );
+		} );
+
+		//	Every eighth direction vertical, both ways
+		add( "get_angle", [ ]( const kernel_table_t &reference, const kernel_table_t &candidate )
+		{
+			auto inputs = make_lanes( 6, 12 );
+
+			for( auto i = size_t{ 1 }; i < Count; i += 8 )
+			{
+				inputs[ 0 ][ i ] = inputs[ 1 ][ i ] = 0.F;
+			}
+
+			return compare( reference, candidate, inputs, [ ]( const kernel_table_t &table, lanes_t &lanes )
+			{
+				table.get_angle( lanes[ 0 ].data( ), lanes[ 1 ].data( ), lanes[ 2 ].data( ), lanes[ 3 ].data( ), lanes[ 4 ].data( ), lanes[ 5 ].data( ), Count );
+			} );
+		} );
+	}
+
+	//	============================================================================================
+	//	Simulation
+	//	============================================================================================
+
+	inline auto add_simulation( )->void
+	{
+		//	Position, velocity, end
+		add( "toss_move", [ ]( const kernel_table_t &reference, const kernel_table_t &candidate )
+		{
+			return compare( reference, candidate, make_lanes( 9, 13 ), [ ]( const kernel_table_t &table, lanes_t &lanes )
+			{
+				const auto pointers = get_pointers( lanes );
+				table.toss_move( pointers.data( ), pointers.data( ) + 3, pointers.data( ) + 6, 1.F / 64.F, 800.F, Count );
+			} );
+		} );
+
+		//	Start, end, hit normal, fraction
+		add( "clip_plane", [ ]( const kernel_table_t &reference, const kernel_table_t &candidate )
+		{
+			auto inputs = make_lanes( 10, 14 );
+			std::fill( inputs[ 9 ].begin( ), inputs[ 9 ].end( ), 1.F );
+
+			const auto normal = std::vector<float>{ 0.F, 0.6F, 0.8F };
+
+			return compare( reference, candidate, inputs, [ &normal ]( const kernel_table_t &table, lanes_t &lanes )
+			{
+				const auto pointers = get_pointers( lanes );
+				table.clip_plane( pointers.data( ), pointers.data( ) + 3, normal.data( ), 12.F, lanes[ 9 ].data( ), pointers.data( ) + 6, Count );
+			} );
+		} );
+
+		//	Position, velocity, end, normal, fraction
+		add( "toss_bounce", [ ]( const kernel_table_t &reference, const kernel_table_t &candidate )
+		{
+			auto inputs = make_lanes( 13, 15 );
+
+			for( auto i = size_t{ 0 }; i < Count; ++i )
+			{
+				inputs[ 12 ][ i ] = i % 3 == 0 ? 1.F : std::fabs( inputs[ 12 ][ i ] ) / 1000.F;
+			}
+
+			return compare( reference, candidate, inputs, [ ]( const kernel_table_t &table, lanes_t &lanes )
+			{
+				const auto pointers = get_pointers( lanes );
+				table.toss_bounce( pointers.data( ), pointers.data( ) + 3, pointers.data( ) + 6, lanes[ 12 ].data( ), pointers.data( ) + 9, 0.45F, Count );
+			} );
+		} );
+
+		//	Origin, velocity, wish, ground, stepped for a second so differences compound
+		add( "move_step", [ ]( const kernel_table_t &reference, const kernel_table_t &candidate )
+		{
+			auto inputs = make_lanes( 10, 16, -300.F, 300.F );
+
+			for( auto i = size_t{ 0 }; i < Count; ++i )
+			{
+				inputs[ 9 ][ i ] = i % 2 == 0 ? 1.F : 0.F;
+			}
+
+			return compare( reference, candidate, inputs, [ ]( const kernel_table_t &table, lanes_t &lanes )
+			{
+				const auto pointers = get_pointers( lanes );
+				const auto wish     = get_pointers( std::as_const( lanes ) );
+
+				for( auto tick = 0; tick < 64; ++tick )
+				{
+					table.move_step( pointers.data( ), pointers.data( ) + 3, wish.data( ) + 6, lanes[ 9 ].data( ), movement_params_t{ }, Count );
+				}
+			} );
+		} );
+	}
+
+	//	============================================================================================
+	//	Collision and culling
+	//	============================================================================================
+
+	/**
+	 * Count boxes of up to 64 units a side, mins in lanes 0 .. 2 and maxs in 3 .. 5
+	 */
+	inline auto make_boxes( const unsigned seed )->lanes_t
+	{
+		auto result = make_lanes( 6, seed );
+		auto engine = std::mt19937{ seed };
+
+		for( auto c = size_t{ 0 }; c < 3; ++c )
+		{
+			for( auto i = size_t{ 0 }; i < Count; ++i )
+			{
+				result[ 3 + c ][ i ] = result[ c ][ i ] + std::uniform_real_distribution<float>{ 0.F, 64.F }( engine );
+			}
+		}
+
+		return result;
+	}
+
+	inline auto add_collision( )->void
+	{
+		//	One sweep per segment through every box, fraction, index and normal per segment
+		add( "sweep_boxes", [ ]( const kernel_table_t &reference, const kernel_table_t &candidate )
+		{
+			const auto boxes    = make_boxes( 17 );
+			const auto segments = make_lanes( 6, 18 );
+			const auto mins     = get_pointers( boxes );
+
+			auto errors = size_t{ 0 };
+
+			for( auto s = size_t{ 0 }; s < 64; ++s )
+			{
+				const float start[ 3 ] = { segments[ 0 ][ s ], segments[ 1 ][ s ], segments[ 2 ][ s ] };
+				const float delta[ 3 ] = { segments[ 3 ][ s ], s % 4 == 0 ? 0.F : segments[ 4 ][ s ], segments[ 5 ][ s ] };
+
+				const float hull_mins[ 3 ] = { -16.F, -16.F, 0.F };
+				const float hull_maxs[ 3 ] = { 16.F, 16.F, 72.F };
+
+				auto fraction = std::vector<float>( 2 );
+				auto index    = std::vector<size_t>( 2 );
+				auto normal   = std::vector<float>( 6 );
+
+				reference.sweep_boxes( mins.data( ), mins.data( ) + 3, start, delta, hull_mins, hull_maxs, Count, &fraction[ 0 ], &index[ 0 ], &normal[ 0 ] );
+				candidate.sweep_boxes( mins.data( ), mins.data( ) + 3, start, delta, hull_mins, hull_maxs, Count, &fraction[ 1 ], &index[ 1 ], &normal[ 3 ] );
+
+				errors += count_different( std::vector<float>{ fraction[ 0 ] }, std::vector<float>{ fraction[ 1 ] } );
+				errors += index[ 0 ] != index[ 1 ] ? 1 : 0;
+				errors += count_different( std::vector<float>( normal.begin( ), normal.begin( ) + 3 ), std::vector<float>( normal.begin( ) + 3, normal.end( ) ) );
+			}
+
+			return errors;
+		} );
+
+		//	A root over two leaves of half the boxes each, split along x
+		add( "trace_boxes", [ ]( const kernel_table_t &reference, const kernel_table_t &candidate )
+		{
+			const auto boxes = make_boxes( 19 );
+			const auto half  = static_cast<uint32_t>( Count / 2 );
+
+			auto index = std::vector<float>( Count );
+
+			for( auto i = size_t{ 0 }; i < Count; ++i )
+			{
+				index[ i ] = static_cast<float>( i );
+			}
+
+			auto nodes = lanes_t( 6, std::vector<float>( 3 ) );
+
+			const auto get_bounds = [ & ]( const size_t node, const size_t first, const size_t last )
+			{
+				for( auto c = size_t{ 0 }; c < 3; ++c )
+				{
+					nodes[ c ][ node ]     = *std::min_element( boxes[ c ].begin( ) + first, boxes[ c ].begin( ) + last );
+					nodes[ 3 + c ][ node ] = *std::max_element( boxes[ 3 + c ].begin( ) + first, boxes[ 3 + c ].begin( ) + last );
+				}
+			};
+
+			get_bounds( 0, 0, Count );
+			get_bounds( 1, 0, half );
+			get_bounds( 2, half, Count );
+
+			const auto first = std::vector<uint32_t>{ 2, 0, half };
+			const auto count = std::vector<uint32_t>{ 0, half, static_cast<uint32_t>( Count ) - half };
+			const auto split = std::vector<uint8_t>{ 0, 0, 0 };
+
+			const auto tree = box_tree_t{
+				{ nodes[ 0 ].data( ), nodes[ 1 ].data( ), nodes[ 2 ].data( ) },
+				{ nodes[ 3 ].data( ), nodes[ 4 ].data( ), nodes[ 5 ].data( ) },
+				first.data( ),
+				count.data( ),
+				split.data( ),
+				{ boxes[ 0 ].data( ), boxes[ 1 ].data( ), boxes[ 2 ].data( ) },
+				{ boxes[ 3 ].data( ), boxes[ 4 ].data( ), boxes[ 5 ].data( ) },
+				index.data( ),
+				3 };
+
+			//	Start, end, normal, fraction. Every fifth segment runs along z only
+			auto inputs = make_lanes( 10, 20 );
+
+			for( auto i = size_t{ 0 }; i < Count; i += 5 )
+			{
+				inputs[ 3 ][ i ] = inputs[ 0 ][ i ];
+				inputs[ 4 ][ i ] = inputs[ 1 ][ i ];
+			}
+
+			return compare( reference, candidate, inputs, [ &tree ]( const kernel_table_t &table, lanes_t &lanes )
+			{
+				const auto start  = get_pointers( std::as_const( lanes ) );
+				const auto normal = get_pointers( lanes );
+
+				table.trace_boxes( tree, start.data( ), start.data( ) + 3, lanes[ 9 ].data( ), normal.data( ) + 6, Count );
+			} );
+		} );
+
+		//	Screen x, y and visible as 0 or 1 after the position
+		add( "world_to_screen", [ ]( const kernel_table_t &reference, const kernel_table_t &candidate )
+		{
+			const auto matrix = std::vector<float>{
+				0.8F, 0.6F, 0.F, 10.F,
+				-0.1F, 0.2F, 1.2F, -40.F,
+				0.F, 0.F, 0.F, 0.F,
+				0.0006F, -0.0008F, 0.00005F, 1.F };
+
+			return compare( reference, candidate, make_lanes( 6, 21 ), [ &matrix ]( const kernel_table_t &table, lanes_t &lanes )
+			{
+				const auto position = get_pointers( std::as_const( lanes ) );
+				const auto screen   = get_pointers( lanes );
+
+				auto visible = std::vector<uint8_t>( Count );
+
+				table.world_to_screen( position.data( ), matrix.data( ), 1920.F, 1080.F, screen.data( ) + 3, visible.data( ), Count );
+				std::transform( visible.begin( ), visible.end( ), lanes[ 5 ].begin( ), [ ]( const uint8_t value ) { return static_cast<float>( value ); } );
+			} );
+		} );
+
+		//	Five planes of a view towards +x, survivors and their indices as floats
+		const auto get_planes = [ ]( )
+		{
+			return std::vector<float>{
+				1.F, 0.F, 0.F, 4.F,
+				0.6F, 0.8F, 0.F, 0.F,
+				0.6F, -0.8F, 0.F, 0.F,
+				0.6F, 0.F, 0.8F, 0.F,
+				0.6F, 0.F, -0.8F, 0.F };
+		};
+
+		add( "cull_spheres", [ get_planes ]( const kernel_table_t &reference, const kernel_table_t &candidate )
+		{
+			const auto planes = get_planes( );
+
+			return compare( reference, candidate, make_lanes( 6, 22 ), [ &planes ]( const kernel_table_t &table, lanes_t &lanes )
+			{
+				const auto center = get_pointers( std::as_const( lanes ) );
+
+				auto visible = std::vector<uint8_t>( Count );
+				auto indices = std::vector<uint32_t>( Count );
+
+				std::transform( lanes[ 3 ].begin( ), lanes[ 3 ].end( ), lanes[ 3 ].begin( ), [ ]( const float value ) { return std::fabs( value ) * 0.1F; } );
+
+				const auto found = table.cull_spheres( center.data( ), lanes[ 3 ].data( ), planes.data( ), 5, visible.data( ), indices.data( ), Count );
+
+				std::transform( visible.begin( ), visible.end( ), lanes[ 4 ].begin( ), [ ]( const uint8_t value ) { return static_cast<float>( value ); } );
+				std::transform( indices.begin( ), indices.begin( ) + found, lanes[ 5 ].begin( ), [ ]( const uint32_t value ) { return static_cast<float>( value ); } );
+				lanes[ 5 ][ Count - 1 ] = static_cast<float>( found );
+			} );
+		} );
+
+		add( "cull_boxes", [ get_planes ]( const kernel_table_t &reference, const kernel_table_t &candidate )
+		{
+			const auto planes = get_planes( );
+
+			auto inputs = make_boxes( 23 );
+			inputs.resize( 8, std::vector<float>( Count ) );
+
+			return compare( reference, candidate, inputs, [ &planes ]( const kernel_table_t &table, lanes_t &lanes )
+			{
+				const auto bounds = get_pointers( std::as_const( lanes ) );
+
+				auto visible = std::vector<uint8_t>( Count );
+				auto indices = std::vector<uint32_t>( Count );
+
+				const auto found = table.cull_boxes( bounds.data( ), bounds.data( ) + 3, planes.data( ), 5, visible.data( ), indices.data( ), Count );
+
+				std::transform( visible.begin( ), visible.end( ), lanes[ 6 ].begin( ), [ ]( const uint8_t value ) { return static_cast<float>( value ); } );
+				std::transform( indices.begin( ), indices.begin( ) + found, lanes[ 7 ].begin( ), [ ]( const uint32_t value ) { return static_cast<float>( value ); } );
+				lanes[ 7 ][ Count - 1 ] = static_cast<float>( found );
+			} );
+		} );
+	}
+
+	//	============================================================================================
+	//	Oriented boxes
+	//	============================================================================================
+
+	/**
+	 * Count oriented boxes in obb_t lane order, center, half extents, then three unit axes
+	 * rotated about z
+	 */
+	inline auto make_obbs( const unsigned seed )->lanes_t
+	{
+		auto result = make_lanes( 15, seed );
+		auto engine = std::mt19937{ seed };
+
+		for( auto i = size_t{ 0 }; i < Count; ++i )
+		{
+			const auto yaw  = std::uniform_real_distribution<float>{ -3.14159F, 3.14159F }( engine );
+			const auto cos  = std::cos( yaw );
+			const auto sin  = std::sin( yaw );
+			const float axes[ 9 ] = { cos, sin, 0.F, -sin, cos, 0.F, 0.F, 0.F, 1.F };
+
+			for( auto c = size_t{ 0 }; c < 3; ++c )
+			{
+				result[ 3 + c ][ i ] = 4.F + std::fabs( result[ 3 + c ][ i ] ) * 0.05F;
+			}
+
+			for( auto k = size_t{ 0 }; k < 9; ++k )
+			{
+				result[ 6 + k ][ i ] = axes[ k ];
+			}
+		}
+
+		return result;
+	}
+
+	inline auto add_obbs( )->void
+	{
+		//	Fraction, hit as 0 or 1 and indices as floats after the boxes
+		add( "ray_obbs", [ ]( const kernel_table_t &reference, const kernel_table_t &candidate )
+		{
+			auto inputs = make_obbs( 24 );
+			inputs.resize( 18, std::vector<float>( Count ) );
+
+			return compare( reference, candidate, inputs, [ ]( const kernel_table_t &table, lanes_t &lanes )
+			{
+				const auto obb = get_pointers( std::as_const( lanes ) );
+
+				const float start[ 3 ] = { -900.F, -850.F, 10.F };
+				const float delta[ 3 ] = { 1800.F, 1650.F, -5.F };
+
+				auto hit     = std::vector<uint8_t>( Count );
+				auto indices = std::vector<uint32_t>( Count );
+
+				const auto found = table.ray_obbs( obb.data( ), start, delta, lanes[ 15 ].data( ), hit.data( ), indices.data( ), Count );
+
+				std::transform( hit.begin( ), hit.end( ), lanes[ 16 ].begin( ), [ ]( const uint8_t value ) { return static_cast<float>( value ); } );
+				std::transform( indices.begin( ), indices.begin( ) + found, lanes[ 17 ].begin( ), [ ]( const uint32_t value ) { return static_cast<float>( value ); } );
+				lanes[ 17 ][ Count - 1 ] = static_cast<float>( found );
+			} );
+		} );
+
+		add( "overlap_obbs", [ ]( const kernel_table_t &reference, const kernel_table_t &candidate )
+		{
+			auto inputs = make_obbs( 25 );
+			inputs.resize( 17, std::vector<float>( Count ) );
+
+			return compare( reference, candidate, inputs, [ ]( const kernel_table_t &table, lanes_t &lanes )
+			{
+				const auto obb = get_pointers( std::as_const( lanes ) );
+
+				//	A large box near the middle against all of them
+				const float box[ 15 ] = { 20.F, -30.F, 5.F, 300.F, 200.F, 100.F, 0.8F, 0.6F, 0.F, -0.6F, 0.8F, 0.F, 0.F, 0.F, 1.F };
+
+				auto overlap = std::vector<uint8_t>( Count );
+				auto indices = std::vector<uint32_t>( Count );
+
+				const auto found = table.overlap_obbs( obb.data( ), box, overlap.data( ), indices.data( ), Count );
+
+				std::transform( overlap.begin( ), overlap.end( ), lanes[ 15 ].begin( ), [ ]( const uint8_t value ) { return static_cast<float>( value ); } );
+				std::transform( indices.begin( ), indices.begin( ) + found, lanes[ 16 ].begin( ), [ ]( const uint32_t value ) { return static_cast<float>( value ); } );
+				lanes[ 16 ][ Count - 1 ] = static_cast<float>( found );
+			} );
+		} );
+	}
+
+	inline auto get_name( const isa_t isa )->std::string_view
+	{
+		switch( isa )
+		{
+			case isa_t::sse2:
+				return "sse2";
+			case isa_t::avx2:
+				return "avx2";
+			case isa_t::avx512:
+				return "avx512";
+			default:
+				return "scalar";
+		}
+	}
+}
+
+int main( int argc, char **argv )
+{
+	auto filter = std::string{};
+
+	for( auto i = 1; i < argc; ++i )
+	{
+		const auto argument = std::string_view{ argv[ i ] };
+
+		if( argument == "--filter" && i + 1 < argc )
+		{
+			filter = argv[ ++i ];
+		}
+		else
+		{
+			std::fprintf( stderr, "usage: %s [--filter s]\n", argv[ 0 ] );
+			return 2;
+		}
+	}
+
+	agree::add_packs( );
+	agree::add_simulation( );
+	agree::add_collision( );
+	agree::add_obbs( );
+
+	const auto reference = get_kernels( isa_t::scalar );
+
+	auto failed = false;
+	auto ran    = false;
+
+	//	Every variant up to what this CPU runs, each against scalar
+	for( auto isa : { isa_t::sse2, isa_t::avx2, isa_t::avx512 } )
+	{
+		if( isa > detail::detect_isa( ) )
+		{
+			continue;
+		}
+
+		const auto candidate = get_kernels( isa );
+
+		//	Built without that variant, get_kernels fell back to scalar
+		if( candidate.isa != isa )
+		{
+			continue;
+		}
+
+		for( const auto &entry : agree::get_checks( ) )
+		{
+			const auto name = std::string{ agree::get_name( isa ) } + "/" + entry.name;
+
+			if( !filter.empty( ) && name.find( filter ) == std::string::npos )
+			{
+				continue;
+			}
+
+			const auto bad = entry.body( reference, candidate );
+
+			std::printf( "%-48s %s (%zu bad)\n", name.c_str( ), bad == 0 ? "ok" : "FAILED", bad );
+			failed = failed || bad != 0;
+			ran    = true;
+		}
+	}
+
+	if( !ran )
+	{
+		std::printf( "no vector variant to compare on this CPU\n" );
+	}
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,389 @@
+//	Self-contained concurrency checks for the lock-free structures
+//
+//	Build from the repository root, e.g.
+//		cl /std:c++20 /O2 /I. bench\stress.cc
+//		c++ -std=c++20 -O2 -ffp-contract=off -pthread -I. bench/stress.cc -o pack_stress
+//		c++ -std=c++20 -O1 -g -ffp-contract=off -fsanitize=thread -pthread -I. bench/stress.cc -o pack_stress_tsan
+//
+//	Usage
+//		pack_stress [--filter <substring>] [--rounds <count>]
+//
+//	Every check hammers one structure from several threads and validates every value that
+//	comes out. Exits with 1 when any check saw a bad value
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "vector.hh"
+#include "batch.hh"
+#include "queue.hh"
+#include "snapshot.hh"
+
+namespace stress
+{
+	using v3 = vector_t<float>::v3;
+
+	//	============================================================================================
+	//	Registry
+	//	============================================================================================
+
+	/**
+	 * A check runs the given number of rounds and returns how many bad values it saw
+	 */
+	using body_t = std::function<size_t( size_t )>;
+
+	struct check_t
+	{
+		std::string name;
+		body_t body;
+	};
+
+	inline auto get_checks( )->std::vector<check_t> &
+	{
+		static auto checks = std::vector<check_t>{};
+		return checks;
+	}
+
+	inline auto add( std::string name, body_t body )->void
+	{
+		get_checks( ).push_back( { std::move( name ), std::move( body ) } );
+	}
+
+	/**
+	 * Threads sharing a core still interleave, yielding keeps a spinning side from burning
+	 * the whole slice of the side it waits on
+	 */
+	inline auto back_off( size_t &spins )->void
+	{
+		if( ++spins % 64 == 0 )
+		{
+			std::this_thread::yield( );
+		}
+	}
+
+	//	============================================================================================
+	//	Snapshots
+	//	============================================================================================
+
+	inline auto add_snapshots( )->void
+	{
+		//	One writer against several readers, each publish is a different size and every
+		//	element encodes its version, so a torn copy or a stale slot shows as a mismatch
+		add( "snapshot/readers", [ ]( const size_t rounds )
+		{
+			constexpr auto Capacity = size_t{ 61 };
+			constexpr auto Readers  = size_t{ 3 };
+
+			auto publisher = snapshot_publisher_t<v3, v3>{ Capacity };
+			auto done      = std::atomic<bool>{ false };
+			auto bad       = std::atomic<size_t>{ 0 };
+			auto reads     = std::atomic<size_t>{ 0 };
+
+			const auto get_size = [ ]( const uint64_t version )
+			{
+				return static_cast<size_t>( 1 + version % Capacity );
+			};
+
+			auto readers = std::vector<std::thread>{ };
+
+			for( auto r = size_t{ 0 }; r < Readers; ++r )
+			{
+				readers.emplace_back( [ & ]( )
+				{
+					auto positions = soa_batch_t<v3>{ };
+					auto angles    = soa_batch_t<v3>{ };
+					auto last      = uint64_t{ 0 };
+					auto errors    = size_t{ 0 };
+					auto count     = size_t{ 0 };
+
+					while( !done.load( std::memory_order_acquire ) )
+					{
+						const auto version = publisher.read( positions, angles );
+
+						if( version == 0 )
+						{
+							continue;
+						}
+
+						++count;
+
+						//	Versions a reader sees never go back
+						errors += version < last ? 1 : 0;
+						last = version;
+
+						errors += positions.get_size( ) != get_size( version ) || angles.get_size( ) != get_size( version ) ? 1 : 0;
+
+						const auto value = static_cast<float>( version );
+
+						for( auto i = size_t{ 0 }; i < positions.get_size( ) && i < angles.get_size( ); ++i )
+						{
+							const auto position = positions.get( i );
+							const auto angle    = angles.get( i );
+
+							errors += position[ 0 ] != value || position[ 1 ] != static_cast<float>( i ) || position[ 2 ] != -value ? 1 : 0;
+							errors += angle[ 0 ] != static_cast<float>( i ) || angle[ 1 ] != value || angle[ 2 ] != 1.F ? 1 : 0;
+						}
+					}
+
+					bad.fetch_add( errors );
+					reads.fetch_add( count );
+				} );
+			}
+
+			auto positions = soa_batch_t<v3>{ };
+			auto angles    = soa_batch_t<v3>{ };
+
+			//	Versions stay well below 2^24 so they are exact in float
+			for( auto version = uint64_t{ 1 }; version <= rounds; ++version )
+			{
+				const auto size  = get_size( version );
+				const auto value = static_cast<float>( version );
+
+				positions.resize( size );
+				angles.resize( size );
+
+				for( auto i = size_t{ 0 }; i < size; ++i )
+				{
+					positions.set( i, v3{ value, static_cast<float>( i ), -value } );
+					angles.set( i, v3{ static_cast<float>( i ), value, 1.F } );
+				}
+
+				publisher.publish( positions, angles );
+			}
+
+			done.store( true, std::memory_order_release );
+
+			for( auto &reader : readers )
+			{
+				reader.join( );
+			}
+
+			//	A run where no reader got anything checked nothing
+			return bad.load( ) + ( reads.load( ) == 0 ? 1 : 0 );
+		} );
+	}
+
+	//	============================================================================================
+	//	Queues
+	//
+	//	Batches live in a pool and only their index travels, the way pipeline stages hand
+	//	batches on. Consumers send indices back through one free list per producer, so the
+	//	contents checked on the far side were written by the producer just before the push
+	//	============================================================================================
+
+	using handle_t = uint32_t;
+
+	//	Sequences wrap here so they stay exact in float
+	constexpr auto Sequences = uint64_t{ 1 } << 20;
+
+	/**
+	 * Batch contents for the sequence'th handoff of a producer, sized by the sequence
+	 */
+	inline auto fill( soa_batch_t<v3> &batch, const uint32_t producer, const uint64_t sequence )->void
+	{
+		const auto tag  = sequence % Sequences;
+		const auto size = static_cast<size_t>( 1 + tag % 7 );
+
+		batch.resize( size );
+
+		for( auto i = size_t{ 0 }; i < size; ++i )
+		{
+			batch.set( i, v3{ static_cast<float>( producer ), static_cast<float>( tag ), static_cast<float>( i ) } );
+		}
+	}
+
+	/**
+	 * Read back the producer and wrapped sequence of a filled batch
+	 *
+	 * \return mismatches, a garbled batch may also give a producer out of range
+	 */
+	inline auto check( const soa_batch_t<v3> &batch, const uint32_t producers, uint32_t &producer, uint64_t &sequence )->size_t
+	{
+		if( batch.get_size( ) == 0 )
+		{
+			return 1;
+		}
+
+		const auto first = batch.get( 0 );
+
+		producer = static_cast<uint32_t>( first[ 0 ] );
+		sequence = static_cast<uint64_t>( first[ 1 ] );
+
+		auto errors = producer < producers && batch.get_size( ) == 1 + sequence % 7 ? size_t{ 0 } : size_t{ 1 };
+
+		for( auto i = size_t{ 0 }; i < batch.get_size( ); ++i )
+		{
+			const auto element = batch.get( i );
+			errors += element[ 0 ] != first[ 0 ] || element[ 1 ] != first[ 1 ] || element[ 2 ] != static_cast<float>( i ) ? 1 : 0;
+		}
+
+		return errors;
+	}
+
+	/**
+	 * Producer threads push rounds batches each into queue, the calling thread consumes
+	 * and checks every producer's batches arrive complete and in order
+	 */
+	template <typename Q>
+	auto run_queue( Q &queue, const uint32_t producers, const size_t rounds )->size_t
+	{
+		constexpr auto Pooled = size_t{ 16 };
+
+		auto pool  = std::vector<soa_batch_t<v3>>( producers * Pooled );
+		auto frees = std::vector<std::unique_ptr<spsc_queue_t<handle_t>>>{ };
+
+		for( auto p = uint32_t{ 0 }; p < producers; ++p )
+		{
+			frees.push_back( std::make_unique<spsc_queue_t<handle_t>>( Pooled ) );
+
+			for( auto k = size_t{ 0 }; k < Pooled; ++k )
+			{
+				frees.back( )->try_push( static_cast<handle_t>( p * Pooled + k ) );
+			}
+		}
+
+		auto threads = std::vector<std::thread>{ };
+
+		for( auto p = uint32_t{ 0 }; p < producers; ++p )
+		{
+			threads.emplace_back( [ &, p ]( )
+			{
+				auto handle = handle_t{ };
+				auto spins  = size_t{ 0 };
+
+				for( auto sequence = uint64_t{ 0 }; sequence < rounds; ++sequence )
+				{
+					while( !frees[ p ]->try_pop( handle ) )
+					{
+						back_off( spins );
+					}
+
+					fill( pool[ handle ], p, sequence );
+
+					while( !queue.try_push( handle_t{ handle } ) )
+					{
+						back_off( spins );
+					}
+				}
+			} );
+		}
+
+		auto expected = std::vector<uint64_t>( producers, 0 );
+		auto errors   = size_t{ 0 };
+		auto handle   = handle_t{ };
+		auto spins    = size_t{ 0 };
+
+		for( auto received = size_t{ 0 }; received < producers * rounds; ++received )
+		{
+			while( !queue.try_pop( handle ) )
+			{
+				back_off( spins );
+			}
+
+			auto producer = uint32_t{ };
+			auto sequence = uint64_t{ };
+
+			//	A handle from outside the pool is beyond saving and its producer would wait
+			//	forever for it to come back, report and stop here
+			if( handle >= pool.size( ) )
+			{
+				std::fprintf( stderr, "handle %u outside the pool after %zu handoffs\n", handle, received );
+				std::exit( 1 );
+			}
+
+			errors += check( pool[ handle ], producers, producer, sequence );
+
+			//	Each producer's batches come out in the order it pushed them
+			if( producer < producers )
+			{
+				errors += sequence != expected[ producer ] % Sequences ? 1 : 0;
+				++expected[ producer ];
+			}
+
+			//	Back to the producer that owns the pool entry
+			while( !frees[ handle / Pooled ]->try_push( handle_t{ handle } ) )
+			{
+				back_off( spins );
+			}
+		}
+
+		for( auto &thread : threads )
+		{
+			thread.join( );
+		}
+
+		//	Nothing left over once every push was popped
+		errors += queue.try_pop( handle ) ? 1 : 0;
+
+		return errors;
+	}
+
+	inline auto add_queues( )->void
+	{
+		add( "queue/spsc", [ ]( const size_t rounds )
+		{
+			auto queue = spsc_queue_t<handle_t>{ 8 };
+			return run_queue( queue, 1, rounds );
+		} );
+
+		add( "queue/mpsc", [ ]( const size_t rounds )
+		{
+			auto queue = mpsc_queue_t<handle_t>{ 8 };
+			return run_queue( queue, 3, rounds );
+		} );
+	}
+}
+
+int main( int argc, char **argv )
+{
+	auto filter = std::string{};
+	auto rounds = size_t{ 200000 };
+
+	for( auto i = 1; i < argc; ++i )
+	{
+		const auto argument = std::string_view{ argv[ i ] };
+		const auto has_next = i + 1 < argc;
+
+		if( argument == "--filter" && has_next )
+		{
+			filter = argv[ ++i ];
+		}
+		else if( argument == "--rounds" && has_next )
+		{
+			rounds = std::max<size_t>( std::strtoull( argv[ ++i ], nullptr, 10 ), 1 );
+		}
+		else
+		{
+			std::fprintf( stderr, "usage: %s [--filter s] [--rounds count]\n", argv[ 0 ] );
+			return 2;
+		}
+	}
+
+	stress::add_snapshots( );
+	stress::add_queues( );
+
+	auto failed = false;
+
+	for( const auto &entry : stress::get_checks( ) )
+	{
+		if( !filter.empty( ) && entry.name.find( filter ) == std::string::npos )
+		{
+			continue;
+		}
+
+		const auto bad = entry.body( rounds );
+
+		std::printf( "%-48s %s (%zu bad)\n", entry.name.c_str( ), bad == 0 ? "ok" : "FAILED", bad );
+		failed = failed || bad != 0;
+	}
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include "instrument.hh"
+#include "vector.hh"
+
+//	============================================================================================
+//	Cached length packs
+//
+//	For long lived directions and offsets that are read far more often than written.
+//	Squared length and length are computed by the writes, initialize and normalize_length,
+//	and kept until the next one, normalizing an already normalized pack costs nothing.
+//	Const access never writes, so any number of threads may read one pack while none
+//	writes it. After a write through operator[ ] the reads recompute until the next write
+//	============================================================================================
+
+template <detail::pack_t P>
+struct cached_pack_t
+{
+	public:
+	using Pack                  = P;
+	using Type                  = typename P::Type;
+	using Length                = decltype( std::declval<const P &>( ).get_length( ) );
+	constexpr static size_t Len = P::Len;
+
+	//	============================================================================================
+
+	explicit cached_pack_t( ) = default;
+
+	auto initialize( const P &value )->void
+	{
+		m_pack = value;
+		refresh( );
+	}
+
+	template <detail::args_t... A>
+		requires( sizeof...( A ) == Len )
+	auto initialize( const A &...args )->void
+	{
+		m_pack.initialize( static_cast<Type>( args )... );
+		refresh( );
+	}
+
+	explicit cached_pack_t( const P &value )
+	{
+		initialize( value );
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	Operational methods
+	//	============================================================================================
+
+	constexpr auto get_size( )const->size_t
+	{
+		return Len;
+	}
+
+	auto operator[ ]( const size_t i )const->Type
+	{
+		return m_pack[ i ];
+	}
+
+	/**
+	 * Writable access, drops the cache since the reference may be written through,
+	 * initialize the pack again to refill it
+	 *
+	 * \param i
+	 * \return
+	 */
+	auto operator[ ]( const size_t i )->Type &
+	{
+		invalidate( );
+		return m_pack[ i ];
+	}
+
+	auto get_pack( )const->const P &
+	{
+		return m_pack;
+	}
+
+	auto is_cached( )const->bool
+	{
+		return ( m_state & Length_cached ) != 0;
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	Mathematical methods
+	//	Shorter prefixes than Len are not cached
+	//	============================================================================================
+
+	template <size_t N = Len>
+	auto get_dot( )const->Type
+	{
+		if constexpr( N != Len )
+		{
+			return m_pack.template get_dot<N>( );
+		}
+		else
+		{
+			PACK_COUNT_IF( ( m_state & Dot_cached ) == 0, cached_length_miss );
+
+			return ( m_state & Dot_cached ) != 0 ? m_dot : m_pack.get_dot( );
+		}
+	}
+
+	template <size_t N = Len>
+	auto get_length( )const
+	{
+		if constexpr( N != Len )
+		{
+			return m_pack.template get_length<N>( );
+		}
+		else
+		{
+			return ( m_state & Length_cached ) != 0 ? m_length : static_cast<Length>( sqrt( get_dot( ) ) );
+		}
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	CS:GO methods
+	//	Same results as the pack ones, minus the recomputed length
+	//	============================================================================================
+
+	/**
+	 * Second and later calls leave the components as the first one did
+	 */
+	auto normalize_length( )->void
+	{
+		static_assert( std::is_same_v<Type, float> );
+
+		if( ( m_state & Normalized ) != 0 )
+		{
+			PACK_COUNT( cached_length_normalized );
+			return;
+		}
+
+		m_pack = normalized( );
+		refresh( );
+		m_state |= Normalized;
+	}
+
+	auto normalized_length( )const->P
+	{
+		static_assert( std::is_same_v<Type, float> );
+
+		if( ( m_state & Normalized ) != 0 )
+		{
+			PACK_COUNT( cached_length_normalized );
+			return m_pack;
+		}
+
+		return normalized( );
+	}
+
+	//	============================================================================================
+
+	private:
+	enum : uint8_t
+	{
+		Dot_cached    = 1U << 0,
+		Length_cached = 1U << 1,
+		Normalized    = 1U << 2
+	};
+
+	auto invalidate( )->void
+	{
+		m_state = 0;
+	}
+
+	auto refresh( )->void
+	{
+		m_dot    = m_pack.get_dot( );
+		m_length = sqrt( m_dot );
+		m_state  = Dot_cached | Length_cached;
+	}
+
+	/**
+	 * pack::normalize_length with the cached length
+	 *
+	 * \return
+	 */
+	auto normalized( )const->P
+	{
+		const auto length  = get_length( );
+		auto result        = m_pack;
+
+		PACK_COUNT_IF( length == 0.F, normalize_length_zero );
+
+		if( length != 0.F )
+		{
+			detail::unroll<Len>( [ &result, length ]( const size_t i ) { result[ i ] /= length; } );
+		}
+		else
+		{
+			detail::unroll<Len>( [ &result ]( const size_t i ) { result[ i ] = i + 1 == Len ? 1.F : 0.F; } );
+		}
+
+		return result;
+	}
+
+	P m_pack = P{ };
+
+	Type m_dot      = Type{ };
+	Length m_length = Length{ };
+	uint8_t m_state = 0;
+};
@@ -0,0 +1,344 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+#include "batch.hh"
+#include "dispatch.hh"
+#include "instrument.hh"
+#include "morton.hh"
+#include "trace.hh"
+#include "vector.hh"
+
+//	============================================================================================
+//	Swept box collision
+//
+//	Axis aligned boxes are kept as struct of arrays bounds, a hull swept against the set
+//	is Minkowski expanded into every box and slab tested a full register of boxes at a
+//	time. Only the earliest entry survives, which is all a mover needs to clip against.
+//
+//	Batched traces go through a bounding volume hierarchy instead, boxes sorted by the
+//	Morton key of their center and halved down to small leaves. A packet of segments
+//	walks it together, so coherent segments such as one eye's rays share every node test
+//	============================================================================================
+
+/**
+ * Earliest contact of a sweep, fraction is 1 and normal zero when nothing was hit
+ */
+struct sweep_result_t
+{
+	float fraction             = 1.F;
+	size_t index               = 0;
+	vector_t<float>::v3 normal = vector_t<float>::v3{ };
+};
+
+/**
+ * Set of solid axis aligned boxes, also usable as trace geometry for point sized movers
+ */
+struct box_geometry_t
+{
+	public:
+	using v3 = vector_t<float>::v3;
+
+	//	Boxes per leaf, each costs one slab test per packet that reaches the leaf
+	constexpr static uint32_t Leaf = 4;
+
+	//	============================================================================================
+
+	explicit box_geometry_t( std::pmr::memory_resource *resource = std::pmr::get_default_resource( ) )
+		: m_mins( resource ), m_maxs( resource ), m_tree_mins( resource ), m_tree_maxs( resource ), m_tree_index( resource ), m_node_mins( resource ),
+		  m_node_maxs( resource ), m_node_first( resource ), m_node_count( resource ), m_node_split( resource )
+	{
+	}
+
+	//	============================================================================================
+
+	/**
+	 * Add a solid box, index is the insertion order. Drops the hierarchy until the next build( )
+	 *
+	 * \param mins
+	 * \param maxs
+	 */
+	auto add( const v3 &mins, const v3 &maxs )->void
+	{
+		assert( mins[ 0 ] <= maxs[ 0 ] && mins[ 1 ] <= maxs[ 1 ] && mins[ 2 ] <= maxs[ 2 ] );
+
+		m_mins.push_back( mins );
+		m_maxs.push_back( maxs );
+		drop_tree( );
+	}
+
+	auto get_size( )const->size_t
+	{
+		return m_mins.get_size( );
+	}
+
+	auto get_mins( )const->const soa_batch_t<v3> &
+	{
+		return m_mins;
+	}
+
+	auto get_maxs( )const->const soa_batch_t<v3> &
+	{
+		return m_maxs;
+	}
+
+	auto clear( )->void
+	{
+		m_mins.clear( );
+		m_maxs.clear( );
+		drop_tree( );
+	}
+
+	/**
+	 * Build the hierarchy trace( ) walks, once after the last add( ). Without one trace( )
+	 * tests every box for every segment
+	 */
+	auto build( )->void
+	{
+		PACK_TIME( box_build );
+
+		const auto count = get_size( );
+		auto *resource   = m_mins.get_resource( );
+
+		drop_tree( );
+
+		if( count == 0 )
+		{
+			return;
+		}
+
+		auto centers = soa_batch_t<v3>{ resource };
+		centers.resize( count );
+
+		for( auto c = size_t{ 0 }; c < 3; ++c )
+		{
+			for( auto i = size_t{ 0 }; i < count; ++i )
+			{
+				centers.lane( c )[ i ] = ( m_mins.lane( c )[ i ] + m_maxs.lane( c )[ i ] ) * 0.5F;
+			}
+		}
+
+		auto sorter = morton_sorter_t{ 10, resource };
+		sorter.sort( centers );
+
+		const auto order = sorter.get_order( );
+
+		m_tree_mins.resize( count );
+		m_tree_maxs.resize( count );
+		m_tree_index.resize( count );
+
+		for( auto c = size_t{ 0 }; c < 3; ++c )
+		{
+			for( auto i = size_t{ 0 }; i < count; ++i )
+			{
+				m_tree_mins.lane( c )[ i ] = m_mins.lane( c )[ order[ i ] ];
+				m_tree_maxs.lane( c )[ i ] = m_maxs.lane( c )[ order[ i ] ];
+			}
+		}
+
+		for( auto i = size_t{ 0 }; i < count; ++i )
+		{
+			m_tree_index[ i ] = static_cast<float>( order[ i ] );
+		}
+
+		add_node( 0, static_cast<uint32_t>( count ) );
+	}
+
+	/**
+	 * Whether trace( ) has a current hierarchy
+	 *
+	 * \return
+	 */
+	auto is_built( )const->bool
+	{
+		return !m_node_first.empty( );
+	}
+
+	/**
+	 * Sweep a hull through every box, boxes the hull starts in are ignored.
+	 * index is get_size( ) on a miss
+	 *
+	 * \param start		hull origin
+	 * \param delta		movement over the sweep
+	 * \param hull_mins	relative to the origin, e.g. { -16, -16, 0 } for a standing player
+	 * \param hull_maxs
+	 * \return
+	 */
+	auto sweep( const v3 &start, const v3 &delta, const v3 &hull_mins = v3{ }, const v3 &hull_maxs = v3{ } )const->sweep_result_t
+	{
+		PACK_TIME( box_sweep );
+
+		const auto mins = detail::get_lanes( m_mins );
+		const auto maxs = detail::get_lanes( m_maxs );
+
+		const auto origin = start.get_contents( );
+		const auto move   = delta.get_contents( );
+		const auto low    = hull_mins.get_contents( );
+		const auto high   = hull_maxs.get_contents( );
+
+		auto result = sweep_result_t{ };
+		auto normal = std::array<float, 3>{ };
+
+		get_kernels( ).sweep_boxes( mins.data( ), maxs.data( ), origin.data( ), move.data( ), low.data( ), high.data( ), get_size( ),
+									&result.fraction, &result.index, normal.data( ) );
+
+		result.normal = v3{ normal[ 0 ], normal[ 1 ], normal[ 2 ] };
+
+		return result;
+	}
+
+	/**
+	 * Point sweep per lane, segments starting inside a box are left alone. Results do not
+	 * depend on whether the hierarchy is built
+	 *
+	 * \param batch
+	 */
+	auto trace( const trace_batch_t &batch )const->void
+	{
+		PACK_TIME( box_trace );
+
+		const auto &kernels = get_kernels( );
+
+		if( is_built( ) )
+		{
+			const auto tree = box_tree_t{
+				{ m_node_mins.lane( 0 ), m_node_mins.lane( 1 ), m_node_mins.lane( 2 ) },
+				{ m_node_maxs.lane( 0 ), m_node_maxs.lane( 1 ), m_node_maxs.lane( 2 ) },
+				m_node_first.data( ),
+				m_node_count.data( ),
+				m_node_split.data( ),
+				{ m_tree_mins.lane( 0 ), m_tree_mins.lane( 1 ), m_tree_mins.lane( 2 ) },
+				{ m_tree_maxs.lane( 0 ), m_tree_maxs.lane( 1 ), m_tree_maxs.lane( 2 ) },
+				m_tree_index.data( ),
+				m_node_first.size( ) };
+
+			kernels.trace_boxes( tree, batch.start, batch.end, batch.fraction, batch.normal, batch.count );
+			return;
+		}
+
+		const auto mins     = detail::get_lanes( m_mins );
+		const auto maxs     = detail::get_lanes( m_maxs );
+		const auto hull     = std::array<float, 3>{ };
+
+		for( auto i = size_t{ 0 }; i < batch.count; ++i )
+		{
+			const auto start = std::array<float, 3>{ batch.start[ 0 ][ i ], batch.start[ 1 ][ i ], batch.start[ 2 ][ i ] };
+			const auto delta = std::array<float, 3>{ batch.end[ 0 ][ i ] - start[ 0 ], batch.end[ 1 ][ i ] - start[ 1 ], batch.end[ 2 ][ i ] - start[ 2 ] };
+
+			auto normal = std::array<float, 3>{ };
+			auto index  = size_t{ 0 };
+
+			kernels.sweep_boxes( mins.data( ), maxs.data( ), start.data( ), delta.data( ), hull.data( ), hull.data( ), get_size( ),
+								 batch.fraction + i, &index, normal.data( ) );
+
+			batch.normal[ 0 ][ i ] = normal[ 0 ];
+			batch.normal[ 1 ][ i ] = normal[ 1 ];
+			batch.normal[ 2 ][ i ] = normal[ 2 ];
+		}
+	}
+
+	//	============================================================================================
+
+	private:
+	auto drop_tree( )->void
+	{
+		m_node_mins.clear( );
+		m_node_maxs.clear( );
+		m_node_first.clear( );
+		m_node_count.clear( );
+		m_node_split.clear( );
+	}
+
+	auto get_bounds( const uint32_t first, const uint32_t count, v3 &mins, v3 &maxs )const->void
+	{
+		mins = m_tree_mins.get( first );
+		maxs = m_tree_maxs.get( first );
+
+		for( auto i = first + 1; i < first + count; ++i )
+		{
+			const auto low  = m_tree_mins.get( i );
+			const auto high = m_tree_maxs.get( i );
+
+			for( auto c = size_t{ 0 }; c < 3; ++c )
+			{
+				mins[ c ] = std::min( mins[ c ], low[ c ] );
+				maxs[ c ] = std::max( maxs[ c ], high[ c ] );
+			}
+		}
+	}
+
+	/**
+	 * Depth first, halving the sorted range in whole leaves
+	 *
+	 * \param first	sorted box
+	 * \param count
+	 */
+	auto add_node( const uint32_t first, const uint32_t count )->void
+	{
+		auto mins = v3{ };
+		auto maxs = v3{ };
+
+		get_bounds( first, count, mins, maxs );
+
+		const auto node = m_node_first.size( );
+
+		m_node_mins.push_back( mins );
+		m_node_maxs.push_back( maxs );
+		m_node_first.push_back( first );
+		m_node_count.push_back( count );
+		m_node_split.push_back( 0 );
+
+		if( count <= Leaf )
+		{
+			return;
+		}
+
+		const auto half = ( count / 2 + Leaf - 1 ) / Leaf * Leaf;
+
+		auto low_mins  = v3{ };
+		auto low_maxs  = v3{ };
+		auto high_mins = v3{ };
+		auto high_maxs = v3{ };
+
+		get_bounds( first, half, low_mins, low_maxs );
+		get_bounds( first + half, count - half, high_mins, high_maxs );
+
+		//	Split along the axis the halves' centers are furthest apart on, lower one first
+		auto split = uint8_t{ 0 };
+		auto gap   = std::array<float, 3>{ };
+
+		for( auto c = uint8_t{ 0 }; c < 3; ++c )
+		{
+			gap[ c ] = high_mins[ c ] + high_maxs[ c ] - low_mins[ c ] - low_maxs[ c ];
+			split    = std::fabs( gap[ c ] ) > std::fabs( gap[ split ] ) ? c : split;
+		}
+
+		const auto lower_first = gap[ split ] >= 0.F;
+
+		m_node_count[ node ] = 0;
+		m_node_split[ node ] = split;
+
+		add_node( lower_first ? first : first + half, lower_first ? half : count - half );
+
+		m_node_first[ node ] = static_cast<uint32_t>( m_node_first.size( ) );
+		add_node( lower_first ? first + half : first, lower_first ? count - half : half );
+	}
+
+	soa_batch_t<v3> m_mins;
+	soa_batch_t<v3> m_maxs;
+
+	//	Boxes again in hierarchy order with their insertion index, nodes empty until build( )
+	soa_batch_t<v3> m_tree_mins;
+	soa_batch_t<v3> m_tree_maxs;
+	std::pmr::vector<float> m_tree_index;
+	soa_batch_t<v3> m_node_mins;
+	soa_batch_t<v3> m_node_maxs;
+	std::pmr::vector<uint32_t> m_node_first;
+	std::pmr::vector<uint32_t> m_node_count;
+	std::pmr::vector<uint8_t> m_node_split;
+};
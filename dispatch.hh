@@ -0,0 +1,474 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <span>
+#include <string_view>
+#include "batch.hh"
+#include "instrument.hh"
+#include "kernels.hh"
+#include "vector.hh"
+
+#if defined( PACK_X86 ) && defined( _MSC_VER )
+#include <intrin.h>
+#elif defined( PACK_X86 )
+#include <cpuid.h>
+#endif
+
+namespace detail
+{
+#if defined( PACK_X86 )
+	inline auto cpuid( const uint32_t leaf, const uint32_t subleaf, uint32_t ( &registers )[ 4 ] )->void
+	{
+#if defined( _MSC_VER )
+		int values[ 4 ];
+		__cpuidex( values, static_cast<int>( leaf ), static_cast<int>( subleaf ) );
+
+		for( auto i = 0; i < 4; ++i )
+		{
+			registers[ i ] = static_cast<uint32_t>( values[ i ] );
+		}
+#else
+		__cpuid_count( leaf, subleaf, registers[ 0 ], registers[ 1 ], registers[ 2 ], registers[ 3 ] );
+#endif
+	}
+
+	inline auto xgetbv( )->uint64_t
+	{
+#if defined( _MSC_VER )
+		return _xgetbv( 0 );
+#else
+		auto low  = uint32_t{ };
+		auto high = uint32_t{ };
+		__asm__( "xgetbv" : "=a"( low ), "=d"( high ) : "c"( 0 ) );
+		return uint64_t{ low } | ( uint64_t{ high } << 32 );
+#endif
+	}
+#endif
+
+	/**
+	 * Best instruction set both the CPU and the OS ( saved register state ) support
+	 *
+	 * \return
+	 */
+	inline auto detect_isa( )->isa_t
+	{
+#if defined( PACK_X86 )
+		uint32_t registers[ 4 ] = { };
+
+		cpuid( 0, 0, registers );
+		const auto leaves = registers[ 0 ];
+
+		cpuid( 1, 0, registers );
+		const auto sse2    = ( registers[ 3 ] & ( 1U << 26 ) ) != 0;
+		const auto osxsave = ( registers[ 2 ] & ( 1U << 27 ) ) != 0;
+		const auto avx     = ( registers[ 2 ] & ( 1U << 28 ) ) != 0;
+
+		if( !sse2 )
+		{
+			return isa_t::scalar;
+		}
+
+		if( !osxsave || !avx || leaves < 7 )
+		{
+			return isa_t::sse2;
+		}
+
+		//	XMM | YMM, then opmask | ZMM low | ZMM high
+		const auto state     = xgetbv( );
+		const auto ymm_state = ( state & 0x06 ) == 0x06;
+		const auto zmm_state = ( state & 0xE6 ) == 0xE6;
+
+		cpuid( 7, 0, registers );
+		const auto avx2    = ( registers[ 1 ] & ( 1U << 5 ) ) != 0;
+		const auto avx512f = ( registers[ 1 ] & ( 1U << 16 ) ) != 0;
+
+		if( avx512f && zmm_state )
+		{
+			return isa_t::avx512;
+		}
+
+		if( avx2 && ymm_state )
+		{
+			return isa_t::avx2;
+		}
+
+		return isa_t::sse2;
+#else
+		return isa_t::scalar;
+#endif
+	}
+
+	/**
+	 * BMI2 with a PDEP worth using, AMD before Zen 3 runs it in microcode at
+	 * hundreds of cycles where the shift and mask fallback takes a handful
+	 *
+	 * \return
+	 */
+	inline auto detect_fast_pdep( )->bool
+	{
+#if defined( PACK_X86 ) && ( defined( _M_X64 ) || defined( __x86_64__ ) )
+		uint32_t registers[ 4 ] = { };
+
+		cpuid( 0, 0, registers );
+		const auto leaves = registers[ 0 ];
+
+		//	"AuthenticAMD" in ebx, edx, ecx
+		const auto amd = registers[ 1 ] == 0x68747541U && registers[ 3 ] == 0x69746E65U && registers[ 2 ] == 0x444D4163U;
+
+		if( leaves < 7 )
+		{
+			return false;
+		}
+
+		cpuid( 1, 0, registers );
+		const auto base_family = ( registers[ 0 ] >> 8 ) & 0x0FU;
+		const auto family      = base_family == 0x0FU ? base_family + ( ( registers[ 0 ] >> 20 ) & 0xFFU ) : base_family;
+
+		cpuid( 7, 0, registers );
+		const auto bmi2 = ( registers[ 1 ] & ( 1U << 8 ) ) != 0;
+
+		return bmi2 && ( !amd || family >= 0x19U );
+#else
+		return false;
+#endif
+	}
+
+	/**
+	 * PACK_ISA=scalar|sse2|avx2|avx512 caps the detected set, handy to compare variants in the field
+	 *
+	 * \param detected
+	 * \return
+	 */
+	inline auto apply_isa_override( const isa_t detected )->isa_t
+	{
+		const auto *value = std::getenv( "PACK_ISA" );
+
+		if( value == nullptr )
+		{
+			return detected;
+		}
+
+		const auto name = std::string_view{ value };
+		auto requested  = detected;
+
+		if( name == "scalar" )
+		{
+			requested = isa_t::scalar;
+		}
+		else if( name == "sse2" )
+		{
+			requested = isa_t::sse2;
+		}
+		else if( name == "avx2" )
+		{
+			requested = isa_t::avx2;
+		}
+		else if( name == "avx512" )
+		{
+			requested = isa_t::avx512;
+		}
+
+		return std::min( requested, detected );
+	}
+}
+
+//	============================================================================================
+//	Selection
+//	============================================================================================
+
+/**
+ * Instruction set this process runs kernels with, probed once
+ *
+ * \return
+ */
+inline auto get_isa( )->isa_t
+{
+	static const auto isa = detail::apply_isa_override( detail::detect_isa( ) );
+	return isa;
+}
+
+/**
+ * Whether PDEP is there and fast, probed once. PACK_ISA=scalar or sse2 turns it off
+ * along with the vector variants
+ *
+ * \return
+ */
+inline auto has_fast_pdep( )->bool
+{
+	static const auto fast = detail::detect_fast_pdep( ) && get_isa( ) >= isa_t::avx2;
+	return fast;
+}
+
+/**
+ * Kernels for a given instruction set, clamped to what was built
+ * Does not check the CPU, only pass what get_isa( ) allows
+ *
+ * \param isa
+ * \return
+ */
+inline auto get_kernels( const isa_t isa )->kernel_table_t
+{
+#if defined( PACK_X86 )
+	switch( isa )
+	{
+		case isa_t::avx512:
+			return kernels::avx512::get_table( );
+		case isa_t::avx2:
+			return kernels::avx2::get_table( );
+		case isa_t::sse2:
+			return kernels::sse2::get_table( );
+		default:
+			break;
+	}
+#else
+	static_cast<void>( isa );
+#endif
+
+	return kernels::scalar::get_table( );
+}
+
+/**
+ * Kernels picked for this process, resolved on first use
+ *
+ * \return
+ */
+inline auto get_kernels( )->const kernel_table_t &
+{
+	static const auto table = get_kernels( get_isa( ) );
+	return table;
+}
+
+//	============================================================================================
+//	Batched operations over struct of arrays float batches
+//	============================================================================================
+
+namespace detail
+{
+	template <typename P>
+	concept float_soa_v3_t = float_pack_t<P> && P::Len == 3U;
+
+	template <float_pack_t P>
+	auto get_lanes( const soa_batch_t<P> &batch )->std::array<const float *, P::Len>
+	{
+		auto result = std::array<const float *, P::Len>{ };
+
+		for( auto c = size_t{ 0 }; c < P::Len; ++c )
+		{
+			result[ c ] = batch.lane( c );
+		}
+
+		return result;
+	}
+
+	template <float_pack_t P>
+	auto get_lanes( soa_batch_t<P> &batch )->std::array<float *, P::Len>
+	{
+		auto result = std::array<float *, P::Len>{ };
+
+		for( auto c = size_t{ 0 }; c < P::Len; ++c )
+		{
+			result[ c ] = batch.lane( c );
+		}
+
+		return result;
+	}
+}
+
+/**
+ * Squared length of every element
+ *
+ * \param batch
+ * \param destination
+ */
+template <detail::float_pack_t P>
+auto get_dot( const soa_batch_t<P> &batch, std::span<float> destination )->void
+{
+	assert( destination.size( ) >= batch.get_size( ) );
+
+	PACK_TIME( batch_get_dot );
+
+	const auto lanes = detail::get_lanes( batch );
+	get_kernels( ).get_dot( lanes.data( ), P::Len, destination.data( ), batch.get_size( ) );
+}
+
+/**
+ * Length of every element
+ *
+ * \param batch
+ * \param destination
+ */
+template <detail::float_pack_t P>
+auto get_length( const soa_batch_t<P> &batch, std::span<float> destination )->void
+{
+	assert( destination.size( ) >= batch.get_size( ) );
+
+	PACK_TIME( batch_get_length );
+
+	const auto lanes = detail::get_lanes( batch );
+	get_kernels( ).get_length( lanes.data( ), P::Len, destination.data( ), batch.get_size( ) );
+}
+
+template <detail::float_pack_t P>
+auto normalize_length( soa_batch_t<P> &batch )->void
+{
+	PACK_TIME( batch_normalize_length );
+
+	const auto lanes = detail::get_lanes( batch );
+	get_kernels( ).normalize_length( lanes.data( ), P::Len, batch.get_size( ) );
+}
+
+template <detail::float_soa_v3_t P>
+auto normalize_angle( soa_batch_t<P> &batch )->void
+{
+	PACK_TIME( batch_normalize_angle );
+
+	get_kernels( ).normalize_angle( batch.lane( PITCH ), batch.lane( YAW ), batch.lane( ROLL ), batch.get_size( ) );
+}
+
+template <detail::float_soa_v3_t P>
+auto clamp_angle( soa_batch_t<P> &batch )->void
+{
+	PACK_TIME( batch_clamp_angle );
+
+	get_kernels( ).clamp_angle( batch.lane( PITCH ), batch.lane( YAW ), batch.lane( ROLL ), batch.get_size( ) );
+}
+
+/**
+ * Angles of every forward vector
+ *
+ * \param forward
+ * \param angles
+ */
+template <detail::float_soa_v3_t P>
+auto get_angle( const soa_batch_t<P> &forward, soa_batch_t<P> &angles )->void
+{
+	PACK_TIME( batch_get_angle );
+
+	angles.resize( forward.get_size( ) );
+	get_kernels( ).get_angle( forward.lane( 0 ), forward.lane( 1 ), forward.lane( 2 ),
+							  angles.lane( PITCH ), angles.lane( YAW ), angles.lane( ROLL ), forward.get_size( ) );
+}
+
+/**
+ * batch += offset
+ *
+ * \param batch
+ * \param offset
+ */
+template <detail::float_pack_t P>
+auto translate( soa_batch_t<P> &batch, const P &offset )->void
+{
+	PACK_TIME( batch_transform );
+
+	const auto lanes = detail::get_lanes( batch );
+	const auto delta = offset.get_contents( );
+	get_kernels( ).translate( lanes.data( ), P::Len, delta.data( ), batch.get_size( ) );
+}
+
+/**
+ * batch += direction * scale
+ *
+ * \param batch
+ * \param direction
+ * \param scale
+ */
+template <detail::float_pack_t P>
+auto add_scaled( soa_batch_t<P> &batch, const soa_batch_t<P> &direction, const float scale )->void
+{
+	assert( direction.get_size( ) >= batch.get_size( ) );
+
+	PACK_TIME( batch_transform );
+
+	const auto lanes = detail::get_lanes( batch );
+	const auto steps = detail::get_lanes( direction );
+	get_kernels( ).add_scaled( lanes.data( ), steps.data( ), P::Len, scale, batch.get_size( ) );
+}
+
+/**
+ * destination = a x b, destination may be a or b
+ *
+ * \param a
+ * \param b
+ * \param destination
+ */
+template <detail::float_soa_v3_t P>
+auto cross( const soa_batch_t<P> &a, const soa_batch_t<P> &b, soa_batch_t<P> &destination )->void
+{
+	assert( b.get_size( ) >= a.get_size( ) );
+
+	PACK_TIME( batch_geometry );
+
+	destination.resize( a.get_size( ) );
+
+	const auto left   = detail::get_lanes( a );
+	const auto right  = detail::get_lanes( b );
+	const auto output = detail::get_lanes( destination );
+	get_kernels( ).cross( left.data( ), right.data( ), output.data( ), a.get_size( ) );
+}
+
+/**
+ * Every element projected onto its counterpart in onto, destination may be source
+ *
+ * \param source
+ * \param onto
+ * \param destination
+ */
+template <detail::float_pack_t P>
+auto project( const soa_batch_t<P> &source, const soa_batch_t<P> &onto, soa_batch_t<P> &destination )->void
+{
+	assert( onto.get_size( ) >= source.get_size( ) );
+
+	PACK_TIME( batch_geometry );
+
+	destination.resize( source.get_size( ) );
+
+	const auto input      = detail::get_lanes( source );
+	const auto directions = detail::get_lanes( onto );
+	const auto output     = detail::get_lanes( destination );
+	get_kernels( ).project( input.data( ), directions.data( ), output.data( ), P::Len, source.get_size( ) );
+}
+
+/**
+ * Signed distance of every element to the plane dot( normal, x ) = distance
+ *
+ * \param batch
+ * \param normal
+ * \param distance
+ * \param destination
+ */
+template <detail::float_pack_t P>
+auto get_plane_distance( const soa_batch_t<P> &batch, const P &normal, const float distance, std::span<float> destination )->void
+{
+	assert( destination.size( ) >= batch.get_size( ) );
+
+	PACK_TIME( batch_geometry );
+
+	const auto lanes = detail::get_lanes( batch );
+	const auto plane = normal.get_contents( );
+	get_kernels( ).get_plane_distance( lanes.data( ), P::Len, plane.data( ), distance, destination.data( ), batch.get_size( ) );
+}
+
+/**
+ * Every element mirrored about its unit normal, destination may be source
+ *
+ * \param source
+ * \param normals
+ * \param destination
+ */
+template <detail::float_pack_t P>
+auto reflect( const soa_batch_t<P> &source, const soa_batch_t<P> &normals, soa_batch_t<P> &destination )->void
+{
+	assert( normals.get_size( ) >= source.get_size( ) );
+
+	PACK_TIME( batch_geometry );
+
+	destination.resize( source.get_size( ) );
+
+	const auto input  = detail::get_lanes( source );
+	const auto planes = detail::get_lanes( normals );
+	const auto output = detail::get_lanes( destination );
+	get_kernels( ).reflect( input.data( ), planes.data( ), output.data( ), P::Len, source.get_size( ) );
+}
@@ -0,0 +1,301 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "batch.hh"
+#include "dispatch.hh"
+#include "instrument.hh"
+#include "matrix.hh"
+#include "vector.hh"
+
+//	============================================================================================
+//	View frustum culling
+//
+//	First stage of visibility, drops whatever is entirely outside the view before any
+//	ray work. Planes have inward normals, dot( normal, x ) >= distance being inside, and
+//	the batched tests hand back a byte mask, a compacted index list or both
+//	============================================================================================
+
+struct frustum_t
+{
+	public:
+	using v3 = vector_t<float>::v3;
+
+	constexpr static size_t Planes = 6;
+
+	struct plane_t
+	{
+		v3 normal;
+		float distance;
+	};
+
+	//	============================================================================================
+
+	/**
+	 * No planes, everything is inside
+	 */
+	explicit frustum_t( ) = default;
+
+	/**
+	 * Gribb / Hartmann extraction from a D3D style view projection matrix, the kind
+	 * IVEngineClient::WorldToScreenMatrix returns. Rows without extent, e.g. a zero
+	 * depth row, give no plane
+	 *
+	 * \param matrix
+	 * \return
+	 */
+	static auto from_matrix( const matrix4x4_t &matrix )->frustum_t
+	{
+		auto result = frustum_t{ };
+
+		const auto combine = [ & ]( const size_t row, const float sign )
+		{
+			const auto &w = matrix[ 3 ];
+			const auto &r = matrix[ row ];
+
+			result.add_raw( v3{ w[ 0 ] + r[ 0 ] * sign, w[ 1 ] + r[ 1 ] * sign, w[ 2 ] + r[ 2 ] * sign }, w[ 3 ] + r[ 3 ] * sign );
+		};
+
+		combine( 0, 1.F );
+		combine( 0, -1.F );
+		combine( 1, 1.F );
+		combine( 1, -1.F );
+		combine( 2, -1.F );
+
+		const auto &depth = matrix[ 2 ];
+		result.add_raw( v3{ depth[ 0 ], depth[ 1 ], depth[ 2 ] }, depth[ 3 ] );
+
+		return result;
+	}
+
+	/**
+	 * Frustum of a camera given by its basis, e.g. from angle_vectors
+	 *
+	 * \param origin
+	 * \param forward
+	 * \param right
+	 * \param up
+	 * \param fov				horizontal, degrees
+	 * \param aspect			width / height
+	 * \param near_distance
+	 * \param far_distance
+	 * \return
+	 */
+	static auto from_view( const v3 &origin, const v3 &forward, const v3 &right, const v3 &up, const float fov, const float aspect,
+						   const float near_distance, const float far_distance )->frustum_t
+	{
+		constexpr auto Radians = static_cast<float>( M_PI / 360.0 );
+
+		//	Half angles
+		const auto horizontal = fov * Radians;
+		const auto vertical   = std::atan( std::tan( horizontal ) / aspect );
+
+		const auto sh = std::sin( horizontal );
+		const auto ch = std::cos( horizontal );
+		const auto sv = std::sin( vertical );
+		const auto cv = std::cos( vertical );
+
+		auto result = frustum_t{ };
+
+		const auto add_through_origin = [ & ]( const v3 &side, const float c, const float s )
+		{
+			const auto normal = v3{ side[ 0 ] * c + forward[ 0 ] * s, side[ 1 ] * c + forward[ 1 ] * s, side[ 2 ] * c + forward[ 2 ] * s };
+			result.add( normal, normal.dot( origin ) );
+		};
+
+		add_through_origin( right, ch, sh );
+		add_through_origin( v3{ -right[ 0 ], -right[ 1 ], -right[ 2 ] }, ch, sh );
+		add_through_origin( up, cv, sv );
+		add_through_origin( v3{ -up[ 0 ], -up[ 1 ], -up[ 2 ] }, cv, sv );
+
+		const auto ahead = forward.dot( origin );
+
+		result.add( forward, ahead + near_distance );
+		result.add( v3{ -forward[ 0 ], -forward[ 1 ], -forward[ 2 ] }, -( ahead + far_distance ) );
+
+		return result;
+	}
+
+	/**
+	 * Frustum of a camera at origin looking along angles
+	 *
+	 * \param origin
+	 * \param angles			pitch / yaw / roll, degrees
+	 * \param fov				horizontal, degrees
+	 * \param aspect			width / height
+	 * \param near_distance
+	 * \param far_distance
+	 * \return
+	 */
+	static auto from_angles( const v3 &origin, const v3 &angles, const float fov, const float aspect, const float near_distance, const float far_distance )->frustum_t
+	{
+		auto forward = v3{ };
+		auto right   = v3{ };
+		auto up      = v3{ };
+
+		angles.angle_vectors( forward, right, up );
+
+		return from_view( origin, forward, right, up, fov, aspect, near_distance, far_distance );
+	}
+
+	//	============================================================================================
+
+	/**
+	 * Add a plane, normal of unit length pointing into the frustum
+	 *
+	 * \param normal
+	 * \param distance
+	 */
+	auto add( const v3 &normal, const float distance )->void
+	{
+		assert( m_count < Planes );
+
+		auto *plane = m_planes.data( ) + m_count * 4;
+
+		plane[ 0 ] = normal[ 0 ];
+		plane[ 1 ] = normal[ 1 ];
+		plane[ 2 ] = normal[ 2 ];
+		plane[ 3 ] = distance;
+
+		++m_count;
+	}
+
+	auto get_plane_count( )const->size_t
+	{
+		return m_count;
+	}
+
+	auto get_plane( const size_t i )const->plane_t
+	{
+		const auto *plane = m_planes.data( ) + i * 4;
+		return plane_t{ v3{ plane[ 0 ], plane[ 1 ], plane[ 2 ] }, plane[ 3 ] };
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	Single tests
+	//	Same operations in the same order as the kernels. The kernels never contract, so
+	//	these agree lane for lane when built with -ffp-contract=off as the README does, and
+	//	otherwise only to within rounding
+	//	============================================================================================
+
+	auto contains_sphere( const v3 &center, const float radius )const->bool
+	{
+		for( auto p = size_t{ 0 }; p < m_count; ++p )
+		{
+			const auto *plane = m_planes.data( ) + p * 4;
+
+			if( center[ 0 ] * plane[ 0 ] + center[ 1 ] * plane[ 1 ] + center[ 2 ] * plane[ 2 ] - plane[ 3 ] + radius < 0.F )
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	auto contains_box( const v3 &mins, const v3 &maxs )const->bool
+	{
+		for( auto p = size_t{ 0 }; p < m_count; ++p )
+		{
+			const auto *plane = m_planes.data( ) + p * 4;
+
+			auto distance = ( plane[ 0 ] >= 0.F ? maxs[ 0 ] : mins[ 0 ] ) * plane[ 0 ];
+			distance += ( plane[ 1 ] >= 0.F ? maxs[ 1 ] : mins[ 1 ] ) * plane[ 1 ];
+			distance += ( plane[ 2 ] >= 0.F ? maxs[ 2 ] : mins[ 2 ] ) * plane[ 2 ];
+
+			if( distance - plane[ 3 ] < 0.F )
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	Batched tests
+	//	visible gets 1 / 0 per element, indices the surviving elements in order,
+	//	leave either empty to skip it
+	//	============================================================================================
+
+	/**
+	 * \param centers
+	 * \param radii
+	 * \param visible
+	 * \param indices
+	 * \return survivors
+	 */
+	auto cull_spheres( const soa_batch_t<v3> &centers, std::span<const float> radii, std::span<uint8_t> visible = { },
+					   std::span<uint32_t> indices = { } )const->size_t
+	{
+		const auto count = centers.get_size( );
+
+		assert( radii.size( ) >= count );
+		assert( visible.empty( ) || visible.size( ) >= count );
+		assert( indices.empty( ) || indices.size( ) >= count );
+
+		PACK_TIME( frustum_cull_spheres );
+
+		const auto center = detail::get_lanes( centers );
+
+		return get_kernels( ).cull_spheres( center.data( ), radii.data( ), m_planes.data( ), m_count, visible.empty( ) ? nullptr : visible.data( ),
+											indices.empty( ) ? nullptr : indices.data( ), count );
+	}
+
+	/**
+	 * \param mins
+	 * \param maxs
+	 * \param visible
+	 * \param indices
+	 * \return survivors
+	 */
+	auto cull_boxes( const soa_batch_t<v3> &mins, const soa_batch_t<v3> &maxs, std::span<uint8_t> visible = { },
+					 std::span<uint32_t> indices = { } )const->size_t
+	{
+		const auto count = mins.get_size( );
+
+		assert( maxs.get_size( ) >= count );
+		assert( visible.empty( ) || visible.size( ) >= count );
+		assert( indices.empty( ) || indices.size( ) >= count );
+
+		PACK_TIME( frustum_cull_boxes );
+
+		const auto low  = detail::get_lanes( mins );
+		const auto high = detail::get_lanes( maxs );
+
+		return get_kernels( ).cull_boxes( low.data( ), high.data( ), m_planes.data( ), m_count, visible.empty( ) ? nullptr : visible.data( ),
+										  indices.empty( ) ? nullptr : indices.data( ), count );
+	}
+
+	//	============================================================================================
+
+	private:
+	/**
+	 * a * x + b * y + c * z + d >= 0 form, normalized on the way in
+	 *
+	 * \param normal
+	 * \param offset
+	 */
+	auto add_raw( const v3 &normal, const float offset )->void
+	{
+		const auto length = std::sqrt( normal.get_dot( ) );
+
+		if( length == 0.F )
+		{
+			return;
+		}
+
+		add( v3{ normal[ 0 ] / length, normal[ 1 ] / length, normal[ 2 ] / length }, -offset / length );
+	}
+
+	std::array<float, Planes * 4> m_planes = { };
+	size_t m_count                         = 0;
+};
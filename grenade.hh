@@ -0,0 +1,254 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <utility>
+#include <vector>
+#include "batch.hh"
+#include "dispatch.hh"
+#include "instrument.hh"
+#include "trace.hh"
+#include "vector.hh"
+
+//	============================================================================================
+//	Grenade trajectories
+//
+//	Many throws are advanced tick by tick in lockstep. Live throws stay packed at the front
+//	of the state lanes, a throw that detonates or comes to rest is written out and replaced
+//	by the last live one, so every tick only runs over throws still in flight
+//	============================================================================================
+
+/**
+ * Defaults follow CS:GO, sv_gravity 800 scaled by the grenade gravity of 0.4
+ */
+struct grenade_params_t
+{
+	float interval   = 1.F / 64.F;
+	float gravity    = 800.F * 0.4F;
+	float elasticity = 0.45F;
+
+	//	Slower than this on ground contact and the grenade stops
+	float rest_speed = 20.F;
+
+	//	Detonation time, HE / flash 1.5, molotov 2, 0 for smoke / decoy which never go off on a timer
+	float fuse = 1.5F;
+
+	//	Upper bound for throws that never detonate
+	float max_time = 20.F;
+
+	//	Molotov
+	bool detonate_on_ground = false;
+
+	//	Smoke / decoy
+	bool detonate_at_rest = false;
+};
+
+template <detail::geometry_t G>
+struct grenade_simulator_t
+{
+	public:
+	using v3 = vector_t<float>::v3;
+
+	//	Normal z above which a surface counts as ground
+	constexpr static float Ground = 0.7F;
+
+	//	============================================================================================
+
+	explicit grenade_simulator_t( const G &geometry, const grenade_params_t &params = { }, std::pmr::memory_resource *resource = std::pmr::get_default_resource( ) )
+		: m_geometry( geometry ), m_params( params ), m_position( resource ), m_velocity( resource ), m_end( resource ), m_normal( resource ),
+		  m_fraction( resource ), m_bounces( resource ), m_id( resource )
+	{
+	}
+
+	//	============================================================================================
+
+	auto get_params( )const->const grenade_params_t &
+	{
+		return m_params;
+	}
+
+	/**
+	 * Simulate every throw until it detonates, rests or runs out of time
+	 *
+	 * \param origins		release points
+	 * \param velocities	release velocities
+	 * \param detonations	where each throw ended
+	 * \param times			when each throw ended
+	 * \param bounces		optional, surface contacts per throw
+	 */
+	auto simulate( const soa_batch_t<v3> &origins, const soa_batch_t<v3> &velocities, soa_batch_t<v3> &detonations,
+				   std::span<float> times, std::span<uint32_t> bounces = { } )->void
+	{
+		assert( velocities.get_size( ) >= origins.get_size( ) );
+		assert( times.size( ) >= origins.get_size( ) );
+		assert( bounces.empty( ) || bounces.size( ) >= origins.get_size( ) );
+
+		PACK_TIME( grenade_simulate );
+
+		const auto count = origins.get_size( );
+		const auto limit = std::min( m_params.max_time, m_params.fuse > 0.F ? m_params.fuse : m_params.max_time );
+
+		prepare( origins, velocities );
+		detonations.resize( count );
+
+		const auto &kernels = get_kernels( );
+
+		const auto position = detail::get_lanes( m_position );
+		const auto velocity = detail::get_lanes( m_velocity );
+		const auto end      = detail::get_lanes( m_end );
+		const auto normal   = detail::get_lanes( m_normal );
+
+		//	Throws leave in lockstep, so the clock is shared
+		auto live    = count;
+		auto elapsed = 0.F;
+
+		while( live != 0 )
+		{
+			kernels.toss_move( const_lanes( position ).data( ), velocity.data( ), end.data( ), m_params.interval, m_params.gravity, live );
+
+			m_geometry.trace( trace_batch_t{
+				{ position[ 0 ], position[ 1 ], position[ 2 ] },
+				{ end[ 0 ], end[ 1 ], end[ 2 ] },
+				m_fraction.data( ),
+				{ normal[ 0 ], normal[ 1 ], normal[ 2 ] },
+				live } );
+
+			kernels.toss_bounce( position.data( ), velocity.data( ), const_lanes( end ).data( ), m_fraction.data( ), const_lanes( normal ).data( ),
+								 m_params.elasticity, live );
+
+			elapsed += m_params.interval;
+
+			if( elapsed >= limit )
+			{
+				for( auto i = size_t{ 0 }; i < live; ++i )
+				{
+					m_bounces[ i ] += m_fraction[ i ] < 1.F ? 1U : 0U;
+					retire( i, elapsed, detonations, times, bounces );
+				}
+
+				break;
+			}
+
+			//	Only throws touching something need a look, they are compacted away as they drop out
+			for( auto i = size_t{ 0 }; i < live; )
+			{
+				if( m_fraction[ i ] >= 1.F )
+				{
+					++i;
+					continue;
+				}
+
+				++m_bounces[ i ];
+
+				if( normal[ 2 ][ i ] <= Ground )
+				{
+					++i;
+					continue;
+				}
+
+				const auto speed = velocity[ 0 ][ i ] * velocity[ 0 ][ i ] + velocity[ 1 ][ i ] * velocity[ 1 ][ i ] + velocity[ 2 ][ i ] * velocity[ 2 ][ i ];
+
+				if( m_params.detonate_on_ground )
+				{
+					retire( i, elapsed, detonations, times, bounces );
+				}
+				else if( speed < m_params.rest_speed * m_params.rest_speed )
+				{
+					//	Nothing moves any more, a timed grenade just waits out its fuse
+					retire( i, m_params.detonate_at_rest ? elapsed : limit, detonations, times, bounces );
+				}
+				else
+				{
+					++i;
+					continue;
+				}
+
+				if( i != --live )
+				{
+					move_slot( live, i );
+				}
+			}
+		}
+	}
+
+	//	============================================================================================
+
+	private:
+	template <size_t N>
+	static auto const_lanes( const std::array<float *, N> &lanes )->std::array<const float *, N>
+	{
+		auto result = std::array<const float *, N>{ };
+
+		for( auto c = size_t{ 0 }; c < N; ++c )
+		{
+			result[ c ] = lanes[ c ];
+		}
+
+		return result;
+	}
+
+	auto prepare( const soa_batch_t<v3> &origins, const soa_batch_t<v3> &velocities )->void
+	{
+		const auto count = origins.get_size( );
+
+		m_position.resize( count );
+		m_velocity.resize( count );
+		m_end.resize( count );
+		m_normal.resize( count );
+		m_fraction.resize( count );
+		m_bounces.assign( count, 0 );
+		m_id.resize( count );
+
+		for( auto c = size_t{ 0 }; c < 3; ++c )
+		{
+			std::copy_n( origins.lane( c ), count, m_position.lane( c ) );
+			std::copy_n( velocities.lane( c ), count, m_velocity.lane( c ) );
+		}
+
+		for( auto i = size_t{ 0 }; i < count; ++i )
+		{
+			m_id[ i ] = static_cast<uint32_t>( i );
+		}
+	}
+
+	auto retire( const size_t slot, const float time, soa_batch_t<v3> &detonations, std::span<float> times, std::span<uint32_t> bounces )const->void
+	{
+		const auto id = m_id[ slot ];
+
+		detonations.set( id, m_position.get( slot ) );
+		times[ id ] = time;
+
+		if( !bounces.empty( ) )
+		{
+			bounces[ id ] = m_bounces[ slot ];
+		}
+	}
+
+	/**
+	 * Includes this tick's trace result, the moved throw still has to be booked
+	 */
+	auto move_slot( const size_t from, const size_t to )->void
+	{
+		m_position.set( to, m_position.get( from ) );
+		m_velocity.set( to, m_velocity.get( from ) );
+		m_normal.set( to, m_normal.get( from ) );
+		m_fraction[ to ] = m_fraction[ from ];
+		m_bounces[ to ]  = m_bounces[ from ];
+		m_id[ to ]       = m_id[ from ];
+	}
+
+	const G &m_geometry;
+	grenade_params_t m_params;
+
+	soa_batch_t<v3> m_position;
+	soa_batch_t<v3> m_velocity;
+	soa_batch_t<v3> m_end;
+	soa_batch_t<v3> m_normal;
+	std::pmr::vector<float> m_fraction;
+	std::pmr::vector<uint32_t> m_bounces;
+	std::pmr::vector<uint32_t> m_id;
+};
@@ -0,0 +1,298 @@
+#pragma once
+
+//	============================================================================================
+//	Hot path probes
+//	Compiled in only with PACK_INSTRUMENT defined. Without it this header is only the no-op
+//	macros at the bottom, none of the registry or its includes reach the translation unit
+//	============================================================================================
+
+#if defined( PACK_INSTRUMENT )
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#if defined( _MSC_VER )
+#include <intrin.h>
+#elif defined( __x86_64__ ) || defined( __i386__ )
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+enum class probe_t : size_t
+{
+	normalize_angle,
+	normalize_angle_nonfinite,
+	normalize_length,
+	normalize_length_zero,
+	get_angle,
+	get_angle_vertical,
+	clamp_angle,
+	view_get_dot,
+	view_get_length,
+	view_normalize_length,
+	view_normalize_angle,
+	view_clamp_angle,
+	soa_load,
+	soa_store,
+	aosoa_load,
+	aosoa_store,
+	storage_compress,
+	storage_widen,
+	batch_get_dot,
+	batch_get_length,
+	batch_normalize_length,
+	batch_normalize_angle,
+	batch_clamp_angle,
+	batch_get_angle,
+	batch_transform,
+	batch_geometry,
+	grenade_simulate,
+	movement_predict,
+	box_sweep,
+	box_trace,
+	box_build,
+	cached_length_miss,
+	cached_length_normalized,
+	batch_world_to_screen,
+	frustum_cull_spheres,
+	frustum_cull_boxes,
+	occlusion_update,
+	obb_ray,
+	obb_overlap,
+	morton_sort,
+	snapshot_publish,
+	snapshot_read,
+	snapshot_retry,
+	queue_full,
+	count
+};
+
+constexpr auto Probes = static_cast<size_t>( probe_t::count );
+
+constexpr auto probe_names = std::array<std::string_view, Probes>{
+	"normalize_angle",
+	"normalize_angle_nonfinite",
+	"normalize_length",
+	"normalize_length_zero",
+	"get_angle",
+	"get_angle_vertical",
+	"clamp_angle",
+	"view_get_dot",
+	"view_get_length",
+	"view_normalize_length",
+	"view_normalize_angle",
+	"view_clamp_angle",
+	"soa_load",
+	"soa_store",
+	"aosoa_load",
+	"aosoa_store",
+	"storage_compress",
+	"storage_widen",
+	"batch_get_dot",
+	"batch_get_length",
+	"batch_normalize_length",
+	"batch_normalize_angle",
+	"batch_clamp_angle",
+	"batch_get_angle",
+	"batch_transform",
+	"batch_geometry",
+	"grenade_simulate",
+	"movement_predict",
+	"box_sweep",
+	"box_trace",
+	"box_build",
+	"cached_length_miss",
+	"cached_length_normalized",
+	"batch_world_to_screen",
+	"frustum_cull_spheres",
+	"frustum_cull_boxes",
+	"occlusion_update",
+	"obb_ray",
+	"obb_overlap",
+	"morton_sort",
+	"snapshot_publish",
+	"snapshot_read",
+	"snapshot_retry",
+	"queue_full",
+};
+
+/**
+ * Totals across every thread that ever touched a probe
+ * Cycles stay zero for probes that only count events
+ */
+struct probe_snapshot_t
+{
+	std::array<uint64_t, Probes> counts = {};
+	std::array<uint64_t, Probes> cycles = {};
+};
+
+namespace detail
+{
+	/**
+	 * Per thread probe storage, only its owner writes so
+	 * increments are plain relaxed load + store, no locked ops
+	 */
+	struct probe_block_t
+	{
+		std::array<std::atomic<uint64_t>, Probes> counts = {};
+		std::array<std::atomic<uint64_t>, Probes> cycles = {};
+
+		probe_block_t( );
+		~probe_block_t( );
+
+		probe_block_t( const probe_block_t & )                     = delete;
+		auto operator=( const probe_block_t & )->probe_block_t & = delete;
+	};
+
+	/**
+	 * Live blocks are summed on demand, blocks of exited threads
+	 * are folded into the retired totals
+	 */
+	struct probe_registry_t
+	{
+		std::mutex mutex;
+		std::vector<probe_block_t *> blocks;
+		probe_snapshot_t retired;
+	};
+
+	inline auto get_probe_registry( )->probe_registry_t &
+	{
+		static auto registry = probe_registry_t{};
+		return registry;
+	}
+
+	inline probe_block_t::probe_block_t( )
+	{
+		auto &registry = get_probe_registry( );
+		const auto lock = std::lock_guard{ registry.mutex };
+		registry.blocks.push_back( this );
+	}
+
+	inline probe_block_t::~probe_block_t( )
+	{
+		auto &registry = get_probe_registry( );
+		const auto lock = std::lock_guard{ registry.mutex };
+
+		for( auto i = size_t{ 0 }; i < Probes; ++i )
+		{
+			registry.retired.counts[ i ] += counts[ i ].load( std::memory_order_relaxed );
+			registry.retired.cycles[ i ] += cycles[ i ].load( std::memory_order_relaxed );
+		}
+
+		std::erase( registry.blocks, this );
+	}
+
+	inline auto get_probe_block( )->probe_block_t &
+	{
+		thread_local auto block = probe_block_t{};
+		return block;
+	}
+
+	inline auto bump( std::atomic<uint64_t> &value, const uint64_t amount )->void
+	{
+		value.store( value.load( std::memory_order_relaxed ) + amount, std::memory_order_relaxed );
+	}
+
+	inline auto read_cycles( )->uint64_t
+	{
+#if defined( _MSC_VER ) || defined( __x86_64__ ) || defined( __i386__ )
+		return __rdtsc( );
+#else
+		return static_cast<uint64_t>( std::chrono::steady_clock::now( ).time_since_epoch( ).count( ) );
+#endif
+	}
+
+	inline auto count_probe( const probe_t probe, const uint64_t amount = 1 )->void
+	{
+		bump( get_probe_block( ).counts[ static_cast<size_t>( probe ) ], amount );
+	}
+
+	/**
+	 * Counts a call and the cycles until scope exit
+	 */
+	struct probe_timer_t
+	{
+		explicit probe_timer_t( const probe_t probe ) : m_probe( static_cast<size_t>( probe ) ), m_start( read_cycles( ) )
+		{
+		}
+
+		~probe_timer_t( )
+		{
+			auto &block = get_probe_block( );
+
+			bump( block.cycles[ m_probe ], read_cycles( ) - m_start );
+			bump( block.counts[ m_probe ], 1 );
+		}
+
+		probe_timer_t( const probe_timer_t & )                     = delete;
+		auto operator=( const probe_timer_t & )->probe_timer_t & = delete;
+
+		private:
+		size_t m_probe   = 0;
+		uint64_t m_start = 0;
+	};
+}
+
+/**
+ * Sum every thread's probes
+ *
+ * \return
+ */
+inline auto get_probe_snapshot( )->probe_snapshot_t
+{
+	auto &registry = detail::get_probe_registry( );
+	const auto lock = std::lock_guard{ registry.mutex };
+	auto result     = registry.retired;
+
+	for( const auto *block : registry.blocks )
+	{
+		for( auto i = size_t{ 0 }; i < Probes; ++i )
+		{
+			result.counts[ i ] += block->counts[ i ].load( std::memory_order_relaxed );
+			result.cycles[ i ] += block->cycles[ i ].load( std::memory_order_relaxed );
+		}
+	}
+
+	return result;
+}
+
+/**
+ * Write a snapshot in Prometheus text exposition format
+ *
+ * \param stream
+ * \param snapshot
+ */
+inline auto write_probe_snapshot( std::ostream &stream, const probe_snapshot_t &snapshot )->void
+{
+	stream << "# TYPE pack_probe_count_total counter\n";
+
+	for( auto i = size_t{ 0 }; i < Probes; ++i )
+	{
+		stream << "pack_probe_count_total{probe=\"" << probe_names[ i ] << "\"} " << snapshot.counts[ i ] << '\n';
+	}
+
+	stream << "# TYPE pack_probe_cycles_total counter\n";
+
+	for( auto i = size_t{ 0 }; i < Probes; ++i )
+	{
+		stream << "pack_probe_cycles_total{probe=\"" << probe_names[ i ] << "\"} " << snapshot.cycles[ i ] << '\n';
+	}
+}
+
+#define PACK_PROBE_CONCAT_( a, b ) a##b
+#define PACK_PROBE_CONCAT( a, b )  PACK_PROBE_CONCAT_( a, b )
+
+#define PACK_COUNT( probe )               detail::count_probe( probe_t::probe )
+#define PACK_COUNT_IF( condition, probe ) detail::count_probe( probe_t::probe, ( condition ) ? 1U : 0U )
+#define PACK_TIME( probe )                const auto PACK_PROBE_CONCAT( pack_probe_timer_, __LINE__ ) = detail::probe_timer_t{ probe_t::probe }
+#else
+#define PACK_COUNT( probe )               static_cast<void>( 0 )
+#define PACK_COUNT_IF( condition, probe ) static_cast<void>( 0 )
+#define PACK_TIME( probe )                static_cast<void>( 0 )
+#endif
@@ -0,0 +1,437 @@
+#pragma once
+
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include "simd.hh"
+
+//	============================================================================================
+//	Runtime selectable kernel variants
+//
+//	kernels.inl is compiled once per instruction set against a small vec wrapper. On GCC
+//	and Clang each copy sits in a target region so it may use instructions the rest of the
+//	translation unit is not compiled for, MSVC allows those intrinsics anywhere.
+//	Every copy, the scalar one included, is compiled without floating point contraction:
+//	the target regions may enable FMA, and a fused multiply add rounds once where the
+//	scalar reference rounds twice. Nothing here checks the CPU, see dispatch.hh for that.
+//	============================================================================================
+
+enum class isa_t
+{
+	scalar,
+	sse2,
+	avx2,
+	avx512,
+};
+
+/**
+ * Source movement convars, CS:GO defaults
+ * Shared by the move_step kernel and movement.hh
+ */
+struct movement_params_t
+{
+	float interval         = 1.F / 64.F;
+	float gravity          = 800.F;
+	float friction         = 5.2F;
+	float stop_speed       = 80.F;
+	float accelerate       = 5.5F;
+	float air_accelerate   = 12.F;
+	float air_speed_cap    = 30.F;
+	float max_speed        = 250.F;
+	float surface_friction = 1.F;
+};
+
+/**
+ * Bounding volume hierarchy over boxes, flattened depth first by box_geometry_t and walked
+ * by the trace_boxes kernel. An inner node has count 0, its first child follows it and
+ * first is the second, the first one's center being lower along the split axis. A leaf
+ * covers count boxes from first. index is the insertion order of each box, carried as
+ * float like the kernels' other indices
+ */
+struct box_tree_t
+{
+	const float *node_mins[ 3 ];
+	const float *node_maxs[ 3 ];
+	const uint32_t *first;
+	const uint32_t *count;
+	const uint8_t *split;
+	const float *mins[ 3 ];
+	const float *maxs[ 3 ];
+	const float *index;
+	size_t nodes;
+};
+
+/**
+ * One entry per batched kernel, all operating on float lanes
+ */
+struct kernel_table_t
+{
+	isa_t isa;
+	void ( *get_dot )( const float *const *lanes, size_t len, float *destination, size_t count );
+	void ( *get_length )( const float *const *lanes, size_t len, float *destination, size_t count );
+	void ( *normalize_length )( float *const *lanes, size_t len, size_t count );
+	void ( *normalize_angle )( float *pitch, float *yaw, float *roll, size_t count );
+	void ( *clamp_angle )( float *pitch, float *yaw, float *roll, size_t count );
+	void ( *get_angle )( const float *x, const float *y, const float *z, float *pitch, float *yaw, float *roll, size_t count );
+	void ( *translate )( float *const *lanes, size_t len, const float *offset, size_t count );
+	void ( *add_scaled )( float *const *lanes, const float *const *direction, size_t len, float scale, size_t count );
+	void ( *cross )( const float *const *a, const float *const *b, float *const *destination, size_t count );
+	void ( *project )( const float *const *source, const float *const *onto, float *const *destination, size_t len, size_t count );
+	void ( *get_plane_distance )( const float *const *lanes, size_t len, const float *normal, float distance, float *destination, size_t count );
+	void ( *reflect )( const float *const *source, const float *const *normal, float *const *destination, size_t len, size_t count );
+	void ( *toss_move )( const float *const *position, float *const *velocity, float *const *end, float interval, float gravity, size_t count );
+	void ( *clip_plane )( const float *const *start, const float *const *end, const float *normal, float distance, float *fraction, float *const *hit, size_t count );
+	void ( *toss_bounce )( float *const *position, float *const *velocity, const float *const *end, const float *fraction, const float *const *normal, float elasticity, size_t count );
+	void ( *sweep_boxes )( const float *const *mins, const float *const *maxs, const float *start, const float *delta, const float *hull_mins, const float *hull_maxs,
+						   size_t count, float *fraction, size_t *index, float *normal );
+	void ( *trace_boxes )( const box_tree_t &tree, const float *const *start, const float *const *end, float *fraction, float *const *normal, size_t count );
+	void ( *world_to_screen )( const float *const *position, const float *matrix, float width, float height, float *const *screen, uint8_t *visible, size_t count );
+	size_t ( *cull_spheres )( const float *const *center, const float *radius, const float *planes, size_t plane_count, uint8_t *visible, uint32_t *indices, size_t count );
+	size_t ( *cull_boxes )( const float *const *mins, const float *const *maxs, const float *planes, size_t plane_count, uint8_t *visible, uint32_t *indices, size_t count );
+	size_t ( *ray_obbs )( const float *const *obb, const float *start, const float *delta, float *fraction, uint8_t *hit, uint32_t *indices, size_t count );
+	size_t ( *overlap_obbs )( const float *const *obb, const float *box, uint8_t *overlap, uint32_t *indices, size_t count );
+	void ( *move_step )( float *const *origin, float *const *velocity, const float *const *wish, const float *ground, const movement_params_t &params, size_t count );
+};
+
+namespace kernels
+{
+	//	============================================================================================
+	//	Scalar
+	//	============================================================================================
+
+#if defined( __clang__ )
+#pragma float_control( push )
+#pragma clang fp contract( off )
+#elif defined( __GNUC__ )
+#pragma GCC push_options
+#pragma GCC optimize( "fp-contract=off" )
+#endif
+
+	namespace scalar
+	{
+		constexpr auto Isa = isa_t::scalar;
+
+		struct vec
+		{
+			using V                       = float;
+			using M                       = bool;
+			constexpr static size_t Width = 1;
+
+			static auto zero( )->V { return 0.F; }
+			static auto set( const float v )->V { return v; }
+			static auto load( const float *p )->V { return *p; }
+			static auto store( float *p, const V v )->void { *p = v; }
+			static auto load_partial( const float *p, size_t )->V { return *p; }
+			static auto store_partial( float *p, const V v, size_t )->void { *p = v; }
+
+			static auto add( const V a, const V b )->V { return a + b; }
+			static auto sub( const V a, const V b )->V { return a - b; }
+			static auto mul( const V a, const V b )->V { return a * b; }
+			static auto div( const V a, const V b )->V { return a / b; }
+			static auto sqrt( const V a )->V { return std::sqrt( a ); }
+			static auto min( const V a, const V b )->V { return a < b ? a : b; }
+			static auto max( const V a, const V b )->V { return a > b ? a : b; }
+			static auto abs( const V a )->V { return std::fabs( a ); }
+			static auto copysign( const V magnitude, const V sign )->V { return std::copysign( magnitude, sign ); }
+			static auto round( const V a )->V { return std::nearbyint( a ); }
+
+			static auto lt( const V a, const V b )->M { return a < b; }
+			static auto gt( const V a, const V b )->M { return a > b; }
+			static auto ge( const V a, const V b )->M { return a >= b; }
+			static auto eq( const V a, const V b )->M { return a == b; }
+			static auto neq( const V a, const V b )->M { return a != b; }
+			static auto is_finite( const V a )->M { return std::fabs( a ) < std::numeric_limits<float>::infinity( ); }
+			static auto land( const M a, const M b )->M { return a && b; }
+			static auto select( const M m, const V a, const V b )->V { return m ? a : b; }
+			static auto bits( const M m )->uint32_t { return m ? 1U : 0U; }
+		};
+
+#include "kernels.inl"
+	}
+
+#if defined( __clang__ )
+#pragma float_control( pop )
+#elif defined( __GNUC__ )
+#pragma GCC pop_options
+#endif
+
+#if defined( PACK_X86 )
+
+	//	============================================================================================
+	//	SSE2
+	//	============================================================================================
+
+#if defined( __clang__ )
+#pragma clang attribute push( __attribute__( ( target( "sse2" ) ) ), apply_to = function )
+#pragma float_control( push )
+#pragma clang fp contract( off )
+#elif defined( __GNUC__ )
+#pragma GCC push_options
+#pragma GCC target( "sse2" )
+#pragma GCC optimize( "fp-contract=off" )
+#endif
+
+	namespace sse2
+	{
+		constexpr auto Isa = isa_t::sse2;
+
+		struct vec
+		{
+			using V                       = __m128;
+			using M                       = __m128;
+			constexpr static size_t Width = 4;
+
+			static auto zero( )->V { return _mm_setzero_ps( ); }
+			static auto set( const float v )->V { return _mm_set1_ps( v ); }
+			static auto load( const float *p )->V { return _mm_loadu_ps( p ); }
+			static auto store( float *p, const V v )->void { _mm_storeu_ps( p, v ); }
+
+			static auto load_partial( const float *p, const size_t count )->V
+			{
+				alignas( 16 ) float buffer[ Width ] = { };
+
+				for( auto i = size_t{ 0 }; i < count; ++i )
+				{
+					buffer[ i ] = p[ i ];
+				}
+
+				return _mm_load_ps( buffer );
+			}
+
+			static auto store_partial( float *p, const V v, const size_t count )->void
+			{
+				alignas( 16 ) float buffer[ Width ];
+				_mm_store_ps( buffer, v );
+
+				for( auto i = size_t{ 0 }; i < count; ++i )
+				{
+					p[ i ] = buffer[ i ];
+				}
+			}
+
+			static auto add( const V a, const V b )->V { return _mm_add_ps( a, b ); }
+			static auto sub( const V a, const V b )->V { return _mm_sub_ps( a, b ); }
+			static auto mul( const V a, const V b )->V { return _mm_mul_ps( a, b ); }
+			static auto div( const V a, const V b )->V { return _mm_div_ps( a, b ); }
+			static auto sqrt( const V a )->V { return _mm_sqrt_ps( a ); }
+			static auto min( const V a, const V b )->V { return _mm_min_ps( a, b ); }
+			static auto max( const V a, const V b )->V { return _mm_max_ps( a, b ); }
+			static auto abs( const V a )->V { return _mm_andnot_ps( _mm_set1_ps( -0.F ), a ); }
+
+			static auto copysign( const V magnitude, const V sign )->V
+			{
+				const auto mask = _mm_set1_ps( -0.F );
+				return _mm_or_ps( _mm_andnot_ps( mask, magnitude ), _mm_and_ps( mask, sign ) );
+			}
+
+			/**
+			 * Nearest even without SSE4.1, adding 2^23 pushes the fraction out
+			 * and anything that large is integral already
+			 */
+			static auto round( const V a )->V
+			{
+				const auto magic   = _mm_set1_ps( 8388608.F );
+				const auto rounded = _mm_sub_ps( _mm_add_ps( abs( a ), magic ), magic );
+				return select( lt( abs( a ), magic ), copysign( rounded, a ), a );
+			}
+
+			static auto lt( const V a, const V b )->M { return _mm_cmplt_ps( a, b ); }
+			static auto gt( const V a, const V b )->M { return _mm_cmpgt_ps( a, b ); }
+			static auto ge( const V a, const V b )->M { return _mm_cmpge_ps( a, b ); }
+			static auto eq( const V a, const V b )->M { return _mm_cmpeq_ps( a, b ); }
+			static auto neq( const V a, const V b )->M { return _mm_cmpneq_ps( a, b ); }
+			static auto is_finite( const V a )->M { return _mm_cmplt_ps( abs( a ), _mm_set1_ps( std::numeric_limits<float>::infinity( ) ) ); }
+			static auto land( const M a, const M b )->M { return _mm_and_ps( a, b ); }
+			static auto select( const M m, const V a, const V b )->V { return _mm_or_ps( _mm_and_ps( m, a ), _mm_andnot_ps( m, b ) ); }
+			static auto bits( const M m )->uint32_t { return static_cast<uint32_t>( _mm_movemask_ps( m ) ); }
+		};
+
+#include "kernels.inl"
+	}
+
+#if defined( __clang__ )
+#pragma float_control( pop )
+#pragma clang attribute pop
+#elif defined( __GNUC__ )
+#pragma GCC pop_options
+#endif
+
+	//	============================================================================================
+	//	AVX2
+	//	============================================================================================
+
+#if defined( __clang__ )
+#pragma clang attribute push( __attribute__( ( target( "avx,avx2" ) ) ), apply_to = function )
+#pragma float_control( push )
+#pragma clang fp contract( off )
+#elif defined( __GNUC__ )
+#pragma GCC push_options
+#pragma GCC target( "avx,avx2" )
+#pragma GCC optimize( "fp-contract=off" )
+#endif
+
+	namespace avx2
+	{
+		constexpr auto Isa = isa_t::avx2;
+
+		struct vec
+		{
+			using V                       = __m256;
+			using M                       = __m256;
+			constexpr static size_t Width = 8;
+
+			static auto zero( )->V { return _mm256_setzero_ps( ); }
+			static auto set( const float v )->V { return _mm256_set1_ps( v ); }
+			static auto load( const float *p )->V { return _mm256_loadu_ps( p ); }
+			static auto store( float *p, const V v )->void { _mm256_storeu_ps( p, v ); }
+
+			static auto get_tail_mask( const size_t count )->__m256i
+			{
+				return _mm256_cmpgt_epi32( _mm256_set1_epi32( static_cast<int>( count ) ), _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 ) );
+			}
+
+			static auto load_partial( const float *p, const size_t count )->V
+			{
+				return _mm256_maskload_ps( p, get_tail_mask( count ) );
+			}
+
+			static auto store_partial( float *p, const V v, const size_t count )->void
+			{
+				_mm256_maskstore_ps( p, get_tail_mask( count ), v );
+			}
+
+			static auto add( const V a, const V b )->V { return _mm256_add_ps( a, b ); }
+			static auto sub( const V a, const V b )->V { return _mm256_sub_ps( a, b ); }
+			static auto mul( const V a, const V b )->V { return _mm256_mul_ps( a, b ); }
+			static auto div( const V a, const V b )->V { return _mm256_div_ps( a, b ); }
+			static auto sqrt( const V a )->V { return _mm256_sqrt_ps( a ); }
+			static auto min( const V a, const V b )->V { return _mm256_min_ps( a, b ); }
+			static auto max( const V a, const V b )->V { return _mm256_max_ps( a, b ); }
+			static auto abs( const V a )->V { return _mm256_andnot_ps( _mm256_set1_ps( -0.F ), a ); }
+
+			static auto copysign( const V magnitude, const V sign )->V
+			{
+				const auto mask = _mm256_set1_ps( -0.F );
+				return _mm256_or_ps( _mm256_andnot_ps( mask, magnitude ), _mm256_and_ps( mask, sign ) );
+			}
+
+			static auto round( const V a )->V { return _mm256_round_ps( a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC ); }
+
+			static auto lt( const V a, const V b )->M { return _mm256_cmp_ps( a, b, _CMP_LT_OQ ); }
+			static auto gt( const V a, const V b )->M { return _mm256_cmp_ps( a, b, _CMP_GT_OQ ); }
+			static auto ge( const V a, const V b )->M { return _mm256_cmp_ps( a, b, _CMP_GE_OQ ); }
+			static auto eq( const V a, const V b )->M { return _mm256_cmp_ps( a, b, _CMP_EQ_OQ ); }
+			static auto neq( const V a, const V b )->M { return _mm256_cmp_ps( a, b, _CMP_NEQ_UQ ); }
+			static auto is_finite( const V a )->M { return _mm256_cmp_ps( abs( a ), _mm256_set1_ps( std::numeric_limits<float>::infinity( ) ), _CMP_LT_OQ ); }
+			static auto land( const M a, const M b )->M { return _mm256_and_ps( a, b ); }
+			static auto select( const M m, const V a, const V b )->V { return _mm256_blendv_ps( b, a, m ); }
+			static auto bits( const M m )->uint32_t { return static_cast<uint32_t>( _mm256_movemask_ps( m ) ); }
+		};
+
+#include "kernels.inl"
+	}
+
+#if defined( __clang__ )
+#pragma float_control( pop )
+#pragma clang attribute pop
+#elif defined( __GNUC__ )
+#pragma GCC pop_options
+#endif
+
+	//	============================================================================================
+	//	AVX-512F
+	//	Tails use mask registers instead of a blend or scalar loop
+	//	============================================================================================
+
+#if defined( __clang__ )
+#pragma clang attribute push( __attribute__( ( target( "avx,avx2,avx512f" ) ) ), apply_to = function )
+#pragma float_control( push )
+#pragma clang fp contract( off )
+#elif defined( __GNUC__ )
+#pragma GCC push_options
+#pragma GCC target( "avx,avx2,avx512f" )
+#pragma GCC optimize( "fp-contract=off" )
+//	GCC 12 flags the deliberately undefined pass through operand of the unmasked AVX-512
+//	intrinsics once they inline here
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+	namespace avx512
+	{
+		constexpr auto Isa = isa_t::avx512;
+
+		struct vec
+		{
+			using V                       = __m512;
+			using M                       = __mmask16;
+			constexpr static size_t Width = 16;
+
+			static auto zero( )->V { return _mm512_setzero_ps( ); }
+			static auto set( const float v )->V { return _mm512_set1_ps( v ); }
+			static auto load( const float *p )->V { return _mm512_loadu_ps( p ); }
+			static auto store( float *p, const V v )->void { _mm512_storeu_ps( p, v ); }
+
+			static auto get_tail_mask( const size_t count )->M
+			{
+				return static_cast<M>( ( 1U << count ) - 1U );
+			}
+
+			static auto load_partial( const float *p, const size_t count )->V
+			{
+				return _mm512_maskz_loadu_ps( get_tail_mask( count ), p );
+			}
+
+			static auto store_partial( float *p, const V v, const size_t count )->void
+			{
+				_mm512_mask_storeu_ps( p, get_tail_mask( count ), v );
+			}
+
+			static auto add( const V a, const V b )->V { return _mm512_add_ps( a, b ); }
+			static auto sub( const V a, const V b )->V { return _mm512_sub_ps( a, b ); }
+			static auto mul( const V a, const V b )->V { return _mm512_mul_ps( a, b ); }
+			static auto div( const V a, const V b )->V { return _mm512_div_ps( a, b ); }
+			static auto sqrt( const V a )->V { return _mm512_sqrt_ps( a ); }
+			static auto min( const V a, const V b )->V { return _mm512_min_ps( a, b ); }
+			static auto max( const V a, const V b )->V { return _mm512_max_ps( a, b ); }
+			static auto abs( const V a )->V { return _mm512_abs_ps( a ); }
+
+			/**
+			 * AVX-512F has no float and / or, only the DQ extension adds them
+			 */
+			static auto copysign( const V magnitude, const V sign )->V
+			{
+				const auto mask = _mm512_set1_epi32( static_cast<int>( 0x80000000U ) );
+				const auto bits = _mm512_or_si512( _mm512_andnot_si512( mask, _mm512_castps_si512( magnitude ) ),
+												   _mm512_and_si512( mask, _mm512_castps_si512( sign ) ) );
+				return _mm512_castsi512_ps( bits );
+			}
+
+			static auto round( const V a )->V { return _mm512_roundscale_ps( a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC ); }
+
+			static auto lt( const V a, const V b )->M { return _mm512_cmp_ps_mask( a, b, _CMP_LT_OQ ); }
+			static auto gt( const V a, const V b )->M { return _mm512_cmp_ps_mask( a, b, _CMP_GT_OQ ); }
+			static auto ge( const V a, const V b )->M { return _mm512_cmp_ps_mask( a, b, _CMP_GE_OQ ); }
+			static auto eq( const V a, const V b )->M { return _mm512_cmp_ps_mask( a, b, _CMP_EQ_OQ ); }
+			static auto neq( const V a, const V b )->M { return _mm512_cmp_ps_mask( a, b, _CMP_NEQ_UQ ); }
+			static auto is_finite( const V a )->M { return _mm512_cmp_ps_mask( abs( a ), _mm512_set1_ps( std::numeric_limits<float>::infinity( ) ), _CMP_LT_OQ ); }
+			static auto land( const M a, const M b )->M { return static_cast<M>( a & b ); }
+			static auto select( const M m, const V a, const V b )->V { return _mm512_mask_blend_ps( m, b, a ); }
+			static auto bits( const M m )->uint32_t { return static_cast<uint32_t>( m ); }
+		};
+
+#include "kernels.inl"
+	}
+
+#if defined( __clang__ )
+#pragma float_control( pop )
+#pragma clang attribute pop
+#elif defined( __GNUC__ )
+#pragma GCC diagnostic pop
+#pragma GCC pop_options
+#endif
+
+#endif
+}
@@ -0,0 +1,1147 @@
+//	============================================================================================
+//	Batched float kernels, written once against vec
+//
+//	Included by kernels.hh once per instruction set, inside a namespace that provides vec
+//	and Isa and, on GCC / Clang, inside a matching target region. No include guard on purpose.
+//	All variants evaluate the same operations in the same order so results do not depend
+//	on which one the dispatcher picked.
+//	============================================================================================
+
+using V = vec::V;
+using M = vec::M;
+
+constexpr auto Width = vec::Width;
+
+inline auto load_n( const float *p, const size_t count )->V
+{
+	return count == Width ? vec::load( p ) : vec::load_partial( p, count );
+}
+
+inline auto store_n( float *p, const V v, const size_t count )->void
+{
+	if( count == Width )
+	{
+		vec::store( p, v );
+	}
+	else
+	{
+		vec::store_partial( p, v, count );
+	}
+}
+
+/**
+ * Hand n lanes of a mask out as one byte per element and / or the indices of set lanes,
+ * either output may be null
+ *
+ * \return set lanes
+ */
+inline auto emit_mask( const M mask, const size_t i, const size_t n, uint8_t *visible, uint32_t *indices )->size_t
+{
+	auto bits = vec::bits( mask ) & ( ( uint32_t{ 1 } << n ) - 1U );
+
+	if( visible != nullptr )
+	{
+		for( auto l = size_t{ 0 }; l < n; ++l )
+		{
+			visible[ i + l ] = static_cast<uint8_t>( ( bits >> l ) & 1U );
+		}
+	}
+
+	const auto found = static_cast<size_t>( std::popcount( bits ) );
+
+	if( indices != nullptr )
+	{
+		for( ; bits != 0; bits &= bits - 1U )
+		{
+			*indices++ = static_cast<uint32_t>( i + std::countr_zero( bits ) );
+		}
+	}
+
+	return found;
+}
+
+/**
+ * Cephes style arctangent in [ 0, pi ], sign applied from y
+ *
+ * \param y
+ * \param x
+ * \return
+ */
+inline auto atan2( const V y, const V x )->V
+{
+	const auto ax   = vec::abs( x );
+	const auto ay   = vec::abs( y );
+	const auto swap = vec::gt( ay, ax );
+
+	const auto ratio = vec::div( vec::select( swap, ax, ay ), vec::select( swap, ay, ax ) );
+	const auto large = vec::gt( ratio, vec::set( 0.414213562373095F ) );
+	const auto one   = vec::set( 1.F );
+	const auto t     = vec::select( large, vec::div( vec::sub( ratio, one ), vec::add( ratio, one ) ), ratio );
+	const auto z     = vec::mul( t, t );
+
+	auto p = vec::set( 8.05374449538e-2F );
+	p      = vec::sub( vec::mul( p, z ), vec::set( 1.38776856032e-1F ) );
+	p      = vec::add( vec::mul( p, z ), vec::set( 1.99777106478e-1F ) );
+	p      = vec::sub( vec::mul( p, z ), vec::set( 3.33329491539e-1F ) );
+	p      = vec::add( vec::mul( vec::mul( p, z ), t ), t );
+
+	auto result = vec::add( vec::select( large, vec::set( 0.785398163397448F ), vec::zero( ) ), p );
+	result      = vec::select( swap, vec::sub( vec::set( 1.57079632679490F ), result ), result );
+	result      = vec::select( vec::lt( x, vec::zero( ) ), vec::sub( vec::set( 3.14159265358979F ), result ), result );
+
+	return vec::copysign( result, y );
+}
+
+/**
+ * std::remainderf( x, 360 ), see detail::wrap_degrees
+ *
+ * \param x
+ * \return
+ */
+inline auto wrap_degrees( const V x )->V
+{
+	const auto half  = vec::set( 180.F );
+	const auto whole = vec::set( 360.F );
+	const auto turns = vec::round( vec::mul( x, vec::set( 1.F / 360.F ) ) );
+
+	auto result = vec::sub( x, vec::mul( turns, whole ) );
+	result      = vec::select( vec::gt( result, half ), vec::sub( result, whole ), result );
+	result      = vec::select( vec::lt( result, vec::set( -180.F ) ), vec::add( result, whole ), result );
+
+	return vec::select( vec::is_finite( x ), result, vec::zero( ) );
+}
+
+//	============================================================================================
+//	Kernels
+//	============================================================================================
+
+inline auto get_dot( const float *const *lanes, const size_t len, float *destination, const size_t count )->void
+{
+	for( auto i = size_t{ 0 }; i < count; i += Width )
+	{
+		const auto n = count - i < Width ? count - i : Width;
+		auto result  = vec::zero( );
+
+		for( auto c = size_t{ 0 }; c < len; ++c )
+		{
+			const auto component = load_n( lanes[ c ] + i, n );
+			result               = vec::add( result, vec::mul( component, component ) );
+		}
+
+		store_n( destination + i, result, n );
+	}
+}
+
+inline auto get_length( const float *const *lanes, const size_t len, float *destination, const size_t count )->void
+{
+	for( auto i = size_t{ 0 }; i < count; i += Width )
+	{
+		const auto n = count - i < Width ? count - i : Width;
+		auto result  = vec::zero( );
+
+		for( auto c = size_t{ 0 }; c < len; ++c )
+		{
+			const auto component = load_n( lanes[ c ] + i, n );
+			result               = vec::add( result, vec::mul( component, component ) );
+		}
+
+		store_n( destination + i, vec::sqrt( result ), n );
+	}
+}
+
+/**
+ * Zero length turns into the last axis
+ */
+inline auto normalize_length( float *const *lanes, const size_t len, const size_t count )->void
+{
+	for( auto i = size_t{ 0 }; i < count; i += Width )
+	{
+		const auto n = count - i < Width ? count - i : Width;
+		auto dot     = vec::zero( );
+
+		for( auto c = size_t{ 0 }; c < len; ++c )
+		{
+			const auto component = load_n( lanes[ c ] + i, n );
+			dot                  = vec::add( dot, vec::mul( component, component ) );
+		}
+
+		const auto length = vec::sqrt( dot );
+		const auto valid  = vec::neq( length, vec::zero( ) );
+
+		for( auto c = size_t{ 0 }; c < len; ++c )
+		{
+			const auto fallback = c + 1 == len ? vec::set( 1.F ) : vec::zero( );
+			store_n( lanes[ c ] + i, vec::select( valid, vec::div( load_n( lanes[ c ] + i, n ), length ), fallback ), n );
+		}
+	}
+}
+
+inline auto normalize_angle( float *pitch, float *yaw, float *roll, const size_t count )->void
+{
+	for( auto i = size_t{ 0 }; i < count; i += Width )
+	{
+		const auto n = count - i < Width ? count - i : Width;
+
+		store_n( pitch + i, wrap_degrees( load_n( pitch + i, n ) ), n );
+		store_n( yaw + i, wrap_degrees( load_n( yaw + i, n ) ), n );
+		store_n( roll + i, vec::zero( ), n );
+	}
+}
+
+inline auto clamp_angle( float *pitch, float *yaw, float *roll, const size_t count )->void
+{
+	for( auto i = size_t{ 0 }; i < count; i += Width )
+	{
+		const auto n = count - i < Width ? count - i : Width;
+
+		store_n( pitch + i, vec::min( vec::max( load_n( pitch + i, n ), vec::set( -89.F ) ), vec::set( 89.F ) ), n );
+		store_n( yaw + i, vec::min( vec::max( load_n( yaw + i, n ), vec::set( -180.F ) ), vec::set( 180.F ) ), n );
+		store_n( roll + i, vec::zero( ), n );
+	}
+}
+
+/**
+ * Same conventions as pack::get_angle, but both arctangents are the polynomial atan2
+ * above rather than std::atan2: angles are within 2.5e-5 degrees of the exact value,
+ * so they may differ from pack::get_angle in the last few bits
+ */
+inline auto get_angle( const float *x, const float *y, const float *z, float *pitch, float *yaw, float *roll, const size_t count )->void
+{
+	const auto degrees = vec::set( static_cast<float>( 180.0 / 3.14159265358979323846 ) );
+
+	for( auto i = size_t{ 0 }; i < count; i += Width )
+	{
+		const auto n  = count - i < Width ? count - i : Width;
+		const auto vx = load_n( x + i, n );
+		const auto vy = load_n( y + i, n );
+		const auto vz = load_n( z + i, n );
+
+		const auto vertical = vec::land( vec::eq( vx, vec::zero( ) ), vec::eq( vy, vec::zero( ) ) );
+		const auto planar   = vec::sqrt( vec::add( vec::mul( vx, vx ), vec::mul( vy, vy ) ) );
+
+		const auto up      = vec::mul( atan2( vec::sub( vec::zero( ), vz ), planar ), degrees );
+		const auto heading = vec::mul( atan2( vy, vx ), degrees );
+		const auto pole    = vec::select( vec::gt( vz, vec::zero( ) ), vec::set( -90.F ), vec::set( 90.F ) );
+
+		store_n( pitch + i, vec::select( vertical, pole, up ), n );
+		store_n( yaw + i, vec::select( vertical, vec::zero( ), heading ), n );
+		store_n( roll + i, vec::zero( ), n );
+	}
+}
+
+/**
+ * lanes += offset
+ */
+inline auto translate( float *const *lanes, const size_t len, const float *offset, const size_t count )->void
+{
+	for( auto c = size_t{ 0 }; c < len; ++c )
+	{
+		const auto delta = vec::set( offset[ c ] );
+
+		for( auto i = size_t{ 0 }; i < count; i += Width )
+		{
+			const auto n = count - i < Width ? count - i : Width;
+			store_n( lanes[ c ] + i, vec::add( load_n( lanes[ c ] + i, n ), delta ), n );
+		}
+	}
+}
+
+/**
+ * lanes += direction * scale
+ */
+inline auto add_scaled( float *const *lanes, const float *const *direction, const size_t len, const float scale, const size_t count )->void
+{
+	const auto factor = vec::set( scale );
+
+	for( auto c = size_t{ 0 }; c < len; ++c )
+	{
+		for( auto i = size_t{ 0 }; i < count; i += Width )
+		{
+			const auto n      = count - i < Width ? count - i : Width;
+			const auto scaled = vec::mul( load_n( direction[ c ] + i, n ), factor );
+
+			store_n( lanes[ c ] + i, vec::add( load_n( lanes[ c ] + i, n ), scaled ), n );
+		}
+	}
+}
+
+/**
+ * destination = a x b, destination may alias either input
+ */
+inline auto cross( const float *const *a, const float *const *b, float *const *destination, const size_t count )->void
+{
+	for( auto i = size_t{ 0 }; i < count; i += Width )
+	{
+		const auto n  = count - i < Width ? count - i : Width;
+		const auto ax = load_n( a[ 0 ] + i, n );
+		const auto ay = load_n( a[ 1 ] + i, n );
+		const auto az = load_n( a[ 2 ] + i, n );
+		const auto bx = load_n( b[ 0 ] + i, n );
+		const auto by = load_n( b[ 1 ] + i, n );
+		const auto bz = load_n( b[ 2 ] + i, n );
+
+		store_n( destination[ 0 ] + i, vec::sub( vec::mul( ay, bz ), vec::mul( az, by ) ), n );
+		store_n( destination[ 1 ] + i, vec::sub( vec::mul( az, bx ), vec::mul( ax, bz ) ), n );
+		store_n( destination[ 2 ] + i, vec::sub( vec::mul( ax, by ), vec::mul( ay, bx ) ), n );
+	}
+}
+
+/**
+ * Same as pack::project, destination may alias source
+ */
+inline auto project( const float *const *source, const float *const *onto, float *const *destination, const size_t len, const size_t count )->void
+{
+	for( auto i = size_t{ 0 }; i < count; i += Width )
+	{
+		const auto n = count - i < Width ? count - i : Width;
+		auto length  = vec::zero( );
+		auto along   = vec::zero( );
+
+		for( auto c = size_t{ 0 }; c < len; ++c )
+		{
+			const auto direction = load_n( onto[ c ] + i, n );
+
+			length = vec::add( length, vec::mul( direction, direction ) );
+			along  = vec::add( along, vec::mul( load_n( source[ c ] + i, n ), direction ) );
+		}
+
+		const auto valid = vec::neq( length, vec::zero( ) );
+		const auto scale = vec::div( along, length );
+
+		for( auto c = size_t{ 0 }; c < len; ++c )
+		{
+			store_n( destination[ c ] + i, vec::select( valid, vec::mul( load_n( onto[ c ] + i, n ), scale ), vec::zero( ) ), n );
+		}
+	}
+}
+
+/**
+ * Same as pack::get_plane_distance against one plane
+ */
+inline auto get_plane_distance( const float *const *lanes, const size_t len, const float *normal, const float distance, float *destination, const size_t count )->void
+{
+	const auto offset = vec::set( distance );
+
+	for( auto i = size_t{ 0 }; i < count; i += Width )
+	{
+		const auto n = count - i < Width ? count - i : Width;
+		auto result  = vec::zero( );
+
+		for( auto c = size_t{ 0 }; c < len; ++c )
+		{
+			result = vec::add( result, vec::mul( load_n( lanes[ c ] + i, n ), vec::set( normal[ c ] ) ) );
+		}
+
+		store_n( destination + i, vec::sub( result, offset ), n );
+	}
+}
+
+/**
+ * Same as pack::reflect, destination may alias source
+ */
+inline auto reflect( const float *const *source, const float *const *normal, float *const *destination, const size_t len, const size_t count )->void
+{
+	for( auto i = size_t{ 0 }; i < count; i += Width )
+	{
+		const auto n = count - i < Width ? count - i : Width;
+		auto along   = vec::zero( );
+
+		for( auto c = size_t{ 0 }; c < len; ++c )
+		{
+			along = vec::add( along, vec::mul( load_n( source[ c ] + i, n ), load_n( normal[ c ] + i, n ) ) );
+		}
+
+		const auto twice = vec::add( along, along );
+
+		for( auto c = size_t{ 0 }; c < len; ++c )
+		{
+			const auto reflected = vec::sub( load_n( source[ c ] + i, n ), vec::mul( load_n( normal[ c ] + i, n ), twice ) );
+			store_n( destination[ c ] + i, reflected, n );
+		}
+	}
+}
+
+/**
+ * One tick of ballistic motion, Source style: the move carries half a tick of gravity,
+ * velocity takes the whole tick. end = position + move
+ */
+inline auto toss_move( const float *const *position, float *const *velocity, float *const *end, const float interval, const float gravity, const size_t count )->void
+{
+	const auto dt   = vec::set( interval );
+	const auto fall = vec::set( 0.5F * gravity * interval * interval );
+	const auto pull = vec::set( gravity * interval );
+
+	for( auto i = size_t{ 0 }; i < count; i += Width )
+	{
+		const auto n  = count - i < Width ? count - i : Width;
+		const auto vz = load_n( velocity[ 2 ] + i, n );
+
+		store_n( end[ 0 ] + i, vec::add( load_n( position[ 0 ] + i, n ), vec::mul( load_n( velocity[ 0 ] + i, n ), dt ) ), n );
+		store_n( end[ 1 ] + i, vec::add( load_n( position[ 1 ] + i, n ), vec::mul( load_n( velocity[ 1 ] + i, n ), dt ) ), n );
+		store_n( end[ 2 ] + i, vec::sub( vec::add( load_n( position[ 2 ] + i, n ), vec::mul( vz, dt ) ), fall ), n );
+		store_n( velocity[ 2 ] + i, vec::sub( vz, pull ), n );
+	}
+}
+
+/**
+ * Clip segments start -> end against the solid half space dot( normal, x ) < distance.
+ * Lanes entering it closer than their current fraction take the new fraction, backed
+ * off by epsilon, and the plane normal
+ */
+inline auto clip_plane( const float *const *start, const float *const *end, const float *normal, const float distance, float *fraction,
+						float *const *hit, const size_t count )->void
+{
+	const auto nx      = vec::set( normal[ 0 ] );
+	const auto ny      = vec::set( normal[ 1 ] );
+	const auto nz      = vec::set( normal[ 2 ] );
+	const auto offset  = vec::set( distance );
+	const auto epsilon = vec::set( 0.03125F );
+
+	for( auto i = size_t{ 0 }; i < count; i += Width )
+	{
+		const auto n = count - i < Width ? count - i : Width;
+
+		auto front = vec::mul( load_n( start[ 0 ] + i, n ), nx );
+		front      = vec::add( front, vec::mul( load_n( start[ 1 ] + i, n ), ny ) );
+		front      = vec::sub( vec::add( front, vec::mul( load_n( start[ 2 ] + i, n ), nz ) ), offset );
+
+		auto back = vec::mul( load_n( end[ 0 ] + i, n ), nx );
+		back      = vec::add( back, vec::mul( load_n( end[ 1 ] + i, n ), ny ) );
+		back      = vec::sub( vec::add( back, vec::mul( load_n( end[ 2 ] + i, n ), nz ) ), offset );
+
+		const auto current  = load_n( fraction + i, n );
+		const auto crossing = vec::land( vec::ge( front, vec::zero( ) ), vec::lt( back, vec::zero( ) ) );
+		const auto entry    = vec::max( vec::div( vec::sub( front, epsilon ), vec::sub( front, back ) ), vec::zero( ) );
+		const auto closer   = vec::land( crossing, vec::lt( entry, current ) );
+
+		store_n( fraction + i, vec::select( closer, entry, current ), n );
+		store_n( hit[ 0 ] + i, vec::select( closer, nx, load_n( hit[ 0 ] + i, n ) ), n );
+		store_n( hit[ 1 ] + i, vec::select( closer, ny, load_n( hit[ 1 ] + i, n ) ), n );
+		store_n( hit[ 2 ] + i, vec::select( closer, nz, load_n( hit[ 2 ] + i, n ) ), n );
+	}
+}
+
+/**
+ * Advance to the traced fraction of the move, lanes that hit something get their
+ * velocity reflected about the hit normal and scaled by elasticity
+ */
+inline auto toss_bounce( float *const *position, float *const *velocity, const float *const *end, const float *fraction, const float *const *normal,
+						 const float elasticity, const size_t count )->void
+{
+	const auto one    = vec::set( 1.F );
+	const auto factor = vec::set( elasticity );
+
+	for( auto i = size_t{ 0 }; i < count; i += Width )
+	{
+		const auto n   = count - i < Width ? count - i : Width;
+		const auto t   = load_n( fraction + i, n );
+		const auto hit = vec::lt( t, one );
+
+		const auto px = load_n( position[ 0 ] + i, n );
+		const auto py = load_n( position[ 1 ] + i, n );
+		const auto pz = load_n( position[ 2 ] + i, n );
+		const auto vx = load_n( velocity[ 0 ] + i, n );
+		const auto vy = load_n( velocity[ 1 ] + i, n );
+		const auto vz = load_n( velocity[ 2 ] + i, n );
+		const auto nx = load_n( normal[ 0 ] + i, n );
+		const auto ny = load_n( normal[ 1 ] + i, n );
+		const auto nz = load_n( normal[ 2 ] + i, n );
+
+		store_n( position[ 0 ] + i, vec::add( px, vec::mul( vec::sub( load_n( end[ 0 ] + i, n ), px ), t ) ), n );
+		store_n( position[ 1 ] + i, vec::add( py, vec::mul( vec::sub( load_n( end[ 1 ] + i, n ), py ), t ) ), n );
+		store_n( position[ 2 ] + i, vec::add( pz, vec::mul( vec::sub( load_n( end[ 2 ] + i, n ), pz ), t ) ), n );
+
+		const auto along = vec::add( vec::add( vec::mul( vx, nx ), vec::mul( vy, ny ) ), vec::mul( vz, nz ) );
+		const auto twice = vec::add( along, along );
+
+		store_n( velocity[ 0 ] + i, vec::select( hit, vec::mul( vec::sub( vx, vec::mul( nx, twice ) ), factor ), vx ), n );
+		store_n( velocity[ 1 ] + i, vec::select( hit, vec::mul( vec::sub( vy, vec::mul( ny, twice ) ), factor ), vy ), n );
+		store_n( velocity[ 2 ] + i, vec::select( hit, vec::mul( vec::sub( vz, vec::mul( nz, twice ) ), factor ), vz ), n );
+	}
+}
+
+/**
+ * Sweep a hull from start along delta against count boxes, each one Minkowski expanded
+ * by the hull and clipped with slabs. Keeps the earliest entry, boxes the hull starts
+ * in are ignored. Leaves fraction 1 and index count when nothing is hit
+ */
+inline auto sweep_boxes( const float *const *mins, const float *const *maxs, const float *start, const float *delta, const float *hull_mins,
+						 const float *hull_maxs, const size_t count, float *fraction, size_t *index, float *normal )->void
+{
+	constexpr float Lanes[ 16 ] = { 0.F, 1.F, 2.F, 3.F, 4.F, 5.F, 6.F, 7.F, 8.F, 9.F, 10.F, 11.F, 12.F, 13.F, 14.F, 15.F };
+
+	const auto zero     = vec::zero( );
+	const auto one      = vec::set( 1.F );
+	const auto total    = vec::set( static_cast<float>( count ) );
+	const auto step     = vec::set( static_cast<float>( Width ) );
+	const auto infinity = vec::set( std::numeric_limits<float>::infinity( ) );
+
+	//	Box index and entry axis are carried as floats, exact for any sane box count
+	auto best      = one;
+	auto best_box  = total;
+	auto best_axis = zero;
+	auto box       = vec::load( Lanes );
+
+	for( auto i = size_t{ 0 }; i < count; i += Width )
+	{
+		const auto n = count - i < Width ? count - i : Width;
+
+		auto entry = vec::sub( zero, infinity );
+		auto exit  = infinity;
+		auto axis  = zero;
+
+		for( auto c = size_t{ 0 }; c < 3; ++c )
+		{
+			const auto low  = vec::sub( load_n( mins[ c ] + i, n ), vec::set( start[ c ] + hull_maxs[ c ] ) );
+			const auto high = vec::sub( load_n( maxs[ c ] + i, n ), vec::set( start[ c ] + hull_mins[ c ] ) );
+
+			if( delta[ c ] == 0.F )
+			{
+				//	Parallel to the slab, inside it for the whole sweep or never
+				exit = vec::select( vec::gt( low, zero ), vec::sub( zero, infinity ), exit );
+				exit = vec::select( vec::lt( high, zero ), vec::sub( zero, infinity ), exit );
+				continue;
+			}
+
+			const auto inverse = vec::set( 1.F / delta[ c ] );
+			const auto into    = vec::mul( delta[ c ] > 0.F ? low : high, inverse );
+			const auto out     = vec::mul( delta[ c ] > 0.F ? high : low, inverse );
+
+			axis  = vec::select( vec::gt( into, entry ), vec::set( static_cast<float>( c ) ), axis );
+			entry = vec::max( entry, into );
+			exit  = vec::min( exit, out );
+		}
+
+		const auto valid  = vec::land( vec::lt( box, total ), vec::ge( exit, entry ) );
+		const auto closer = vec::land( valid, vec::land( vec::ge( entry, zero ), vec::lt( entry, best ) ) );
+
+		best      = vec::select( closer, entry, best );
+		best_box  = vec::select( closer, box, best_box );
+		best_axis = vec::select( closer, axis, best_axis );
+		box       = vec::add( box, step );
+	}
+
+	float entries[ Width ];
+	float boxes[ Width ];
+	float axes[ Width ];
+
+	vec::store( entries, best );
+	vec::store( boxes, best_box );
+	vec::store( axes, best_axis );
+
+	//	Lowest box wins ties so every variant agrees
+	auto lane = size_t{ 0 };
+
+	for( auto l = size_t{ 1 }; l < Width; ++l )
+	{
+		if( entries[ l ] < entries[ lane ] || ( entries[ l ] == entries[ lane ] && boxes[ l ] < boxes[ lane ] ) )
+		{
+			lane = l;
+		}
+	}
+
+	normal[ 0 ] = normal[ 1 ] = normal[ 2 ] = 0.F;
+
+	if( entries[ lane ] >= 1.F )
+	{
+		*fraction = 1.F;
+		*index    = count;
+		return;
+	}
+
+	//	Hull stops DIST_EPSILON short of the face it entered through
+	const auto c = static_cast<size_t>( axes[ lane ] );
+
+	normal[ c ] = delta[ c ] > 0.F ? -1.F : 1.F;
+	*fraction   = entries[ lane ] - 0.03125F / std::fabs( delta[ c ] );
+	*fraction   = *fraction > 0.F ? *fraction : 0.F;
+	*index      = static_cast<size_t>( boxes[ lane ] );
+}
+
+/**
+ * Entry and exit of a packet of segments through box i of a struct of arrays set, exit
+ * below entry on a miss. Same slab arithmetic as sweep_boxes with a zero hull, per lane
+ * instead of per box. Lanes parallel to a slab are only handled when flat is set
+ */
+inline auto clip_slabs( const float *const *mins, const float *const *maxs, const size_t i, const V *origin, const V *delta, const V *inverse, const bool flat,
+						V &entry, V &exit, V &axis )->void
+{
+	const auto zero     = vec::zero( );
+	const auto infinity = vec::set( std::numeric_limits<float>::infinity( ) );
+
+	entry = vec::sub( zero, infinity );
+	exit  = infinity;
+	axis  = zero;
+
+	for( auto c = size_t{ 0 }; c < 3; ++c )
+	{
+		const auto low  = vec::sub( vec::set( mins[ c ][ i ] ), origin[ c ] );
+		const auto high = vec::sub( vec::set( maxs[ c ][ i ] ), origin[ c ] );
+
+		//	Picks the same products as choosing by the sign of delta
+		const auto near = vec::mul( low, inverse[ c ] );
+		const auto far  = vec::mul( high, inverse[ c ] );
+		const auto into = vec::min( near, far );
+		const auto out  = vec::max( near, far );
+
+		if( !flat )
+		{
+			axis  = vec::select( vec::gt( into, entry ), vec::set( static_cast<float>( c ) ), axis );
+			entry = vec::max( entry, into );
+			exit  = vec::min( exit, out );
+			continue;
+		}
+
+		//	Parallel lanes are inside the slab for the whole segment or never
+		const auto moving  = vec::neq( delta[ c ], zero );
+		const auto outside = vec::select( moving, exit, vec::sub( zero, infinity ) );
+
+		exit = vec::select( vec::gt( low, zero ), outside, exit );
+		exit = vec::select( vec::lt( high, zero ), outside, exit );
+
+		axis  = vec::select( vec::land( moving, vec::gt( into, entry ) ), vec::set( static_cast<float>( c ) ), axis );
+		entry = vec::select( moving, vec::max( entry, into ), entry );
+		exit  = vec::select( moving, vec::min( exit, out ), exit );
+	}
+}
+
+/**
+ * Point sweeps through a box hierarchy, one packet of segments at a time. A node is
+ * skipped once no lane reaches it before its closest hit so far, node bounds contain
+ * their boxes so nothing a lane could hit is skipped. Same results as sweep_boxes with
+ * a zero hull per segment, lowest insertion index winning ties
+ */
+inline auto trace_boxes( const box_tree_t &tree, const float *const *start, const float *const *end, float *fraction, float *const *normal,
+						 const size_t count )->void
+{
+	constexpr float Lanes[ 16 ] = { 0.F, 1.F, 2.F, 3.F, 4.F, 5.F, 6.F, 7.F, 8.F, 9.F, 10.F, 11.F, 12.F, 13.F, 14.F, 15.F };
+
+	//	Halving splits, one slot per level and one for the sibling
+	constexpr auto Depth = size_t{ 64 };
+
+	const auto zero  = vec::zero( );
+	const auto one   = vec::set( 1.F );
+	const auto lanes = vec::load( Lanes );
+
+	for( auto i = size_t{ 0 }; i < count; i += Width )
+	{
+		const auto n      = count - i < Width ? count - i : Width;
+		const auto active = vec::lt( lanes, vec::set( static_cast<float>( n ) ) );
+
+		V origin[ 3 ];
+		V delta[ 3 ];
+		V inverse[ 3 ];
+
+		auto flat = false;
+
+		for( auto c = size_t{ 0 }; c < 3; ++c )
+		{
+			origin[ c ]  = load_n( start[ c ] + i, n );
+			delta[ c ]   = vec::sub( load_n( end[ c ] + i, n ), origin[ c ] );
+			inverse[ c ] = vec::div( one, delta[ c ] );
+			flat         = flat || vec::bits( vec::land( active, vec::eq( delta[ c ], zero ) ) ) != 0;
+		}
+
+		auto best      = one;
+		auto best_box  = vec::set( std::numeric_limits<float>::infinity( ) );
+		auto best_axis = zero;
+
+		uint32_t stack[ Depth ];
+		auto top = size_t{ 0 };
+
+		if( tree.nodes != 0 )
+		{
+			stack[ top++ ] = 0;
+		}
+
+		while( top != 0 )
+		{
+			const auto node = stack[ --top ];
+
+			auto entry = zero;
+			auto exit  = zero;
+			auto axis  = zero;
+
+			clip_slabs( tree.node_mins, tree.node_maxs, node, origin, delta, inverse, flat, entry, exit, axis );
+
+			const auto reached = vec::land( vec::land( active, vec::ge( exit, entry ) ), vec::land( vec::ge( exit, zero ), vec::ge( best, entry ) ) );
+
+			if( vec::bits( reached ) == 0 )
+			{
+				continue;
+			}
+
+			//	Nearer child first for the first lane still going, its hits cut the other short
+			if( tree.count[ node ] == 0 )
+			{
+				const auto l       = i + static_cast<size_t>( std::countr_zero( vec::bits( reached ) ) );
+				const auto c       = tree.split[ node ];
+				const auto forward = end[ c ][ l ] > start[ c ][ l ];
+
+				stack[ top++ ] = forward ? tree.first[ node ] : node + 1;
+				stack[ top++ ] = forward ? node + 1 : tree.first[ node ];
+				continue;
+			}
+
+			for( auto b = tree.first[ node ]; b < tree.first[ node ] + tree.count[ node ]; ++b )
+			{
+				clip_slabs( tree.mins, tree.maxs, b, origin, delta, inverse, flat, entry, exit, axis );
+
+				const auto box    = vec::set( tree.index[ b ] );
+				const auto valid  = vec::land( reached, vec::land( vec::ge( exit, entry ), vec::ge( entry, zero ) ) );
+				const auto nearer = vec::land( valid, vec::lt( entry, best ) );
+				const auto tied   = vec::land( valid, vec::land( vec::eq( entry, best ), vec::lt( box, best_box ) ) );
+
+				best_box  = vec::select( tied, box, best_box );
+				best_axis = vec::select( tied, axis, best_axis );
+
+				best      = vec::select( nearer, entry, best );
+				best_box  = vec::select( nearer, box, best_box );
+				best_axis = vec::select( nearer, axis, best_axis );
+			}
+		}
+
+		float entries[ Width ];
+		float axes[ Width ];
+
+		vec::store( entries, best );
+		vec::store( axes, best_axis );
+
+		for( auto l = size_t{ 0 }; l < n; ++l )
+		{
+			const auto r = i + l;
+
+			normal[ 0 ][ r ] = normal[ 1 ][ r ] = normal[ 2 ][ r ] = 0.F;
+
+			if( entries[ l ] >= 1.F )
+			{
+				fraction[ r ] = 1.F;
+				continue;
+			}
+
+			//	Stops DIST_EPSILON short of the face it entered through, as in sweep_boxes
+			const auto c    = static_cast<size_t>( axes[ l ] );
+			const auto move = end[ c ][ r ] - start[ c ][ r ];
+
+			normal[ c ][ r ] = move > 0.F ? -1.F : 1.F;
+			fraction[ r ]    = entries[ l ] - 0.03125F / std::fabs( move );
+			fraction[ r ]    = fraction[ r ] > 0.F ? fraction[ r ] : 0.F;
+		}
+	}
+}
+
+/**
+ * Source's WorldToScreen through a row major 4x4 view projection matrix.
+ * Lanes closer than the near clip get a zero screen position, visible
+ * lanes are in front and inside the viewport
+ */
+inline auto world_to_screen( const float *const *position, const float *matrix, const float width, const float height, float *const *screen,
+							 uint8_t *visible, const size_t count )->void
+{
+	const auto zero        = vec::zero( );
+	const auto one         = vec::set( 1.F );
+	const auto clip        = vec::set( 0.001F );
+	const auto right       = vec::set( width );
+	const auto bottom      = vec::set( height );
+	const auto half_width  = vec::set( width * 0.5F );
+	const auto half_height = vec::set( height * 0.5F );
+
+	//	Rows 0, 1 and 3, row 2 only feeds depth
+	V m[ 12 ];
+
+	for( auto k = size_t{ 0 }; k < 8; ++k )
+	{
+		m[ k ] = vec::set( matrix[ k ] );
+	}
+
+	for( auto k = size_t{ 0 }; k < 4; ++k )
+	{
+		m[ 8 + k ] = vec::set( matrix[ 12 + k ] );
+	}
+
+	for( auto i = size_t{ 0 }; i < count; i += Width )
+	{
+		const auto n = count - i < Width ? count - i : Width;
+		const auto x = load_n( position[ 0 ] + i, n );
+		const auto y = load_n( position[ 1 ] + i, n );
+		const auto z = load_n( position[ 2 ] + i, n );
+
+		auto sx = vec::add( vec::add( vec::add( vec::mul( m[ 0 ], x ), vec::mul( m[ 1 ], y ) ), vec::mul( m[ 2 ], z ) ), m[ 3 ] );
+		auto sy = vec::add( vec::add( vec::add( vec::mul( m[ 4 ], x ), vec::mul( m[ 5 ], y ) ), vec::mul( m[ 6 ], z ) ), m[ 7 ] );
+
+		const auto w     = vec::add( vec::add( vec::add( vec::mul( m[ 8 ], x ), vec::mul( m[ 9 ], y ) ), vec::mul( m[ 10 ], z ) ), m[ 11 ] );
+		const auto front = vec::ge( w, clip );
+
+		//	One reciprocal shared by both coordinates, lanes behind are masked off below
+		const auto inverse = vec::div( one, vec::select( front, w, one ) );
+
+		sx = vec::add( half_width, vec::mul( half_width, vec::mul( sx, inverse ) ) );
+		sy = vec::sub( half_height, vec::mul( half_height, vec::mul( sy, inverse ) ) );
+		sx = vec::select( front, sx, zero );
+		sy = vec::select( front, sy, zero );
+
+		const auto horizontal = vec::land( vec::ge( sx, zero ), vec::ge( right, sx ) );
+		const auto vertical   = vec::land( vec::ge( sy, zero ), vec::ge( bottom, sy ) );
+
+		store_n( screen[ 0 ] + i, sx, n );
+		store_n( screen[ 1 ] + i, sy, n );
+
+		emit_mask( vec::land( front, vec::land( horizontal, vertical ) ), i, n, visible, nullptr );
+	}
+}
+
+/**
+ * Spheres against planes given as ( normal, distance ) quads with the normals pointing in,
+ * a sphere survives unless it is entirely behind one plane
+ *
+ * \return survivors, their indices are compacted into indices
+ */
+inline auto cull_spheres( const float *const *center, const float *radius, const float *planes, const size_t plane_count, uint8_t *visible,
+						  uint32_t *indices, const size_t count )->size_t
+{
+	auto found = size_t{ 0 };
+
+	for( auto i = size_t{ 0 }; i < count; i += Width )
+	{
+		const auto n = count - i < Width ? count - i : Width;
+		const auto x = load_n( center[ 0 ] + i, n );
+		const auto y = load_n( center[ 1 ] + i, n );
+		const auto z = load_n( center[ 2 ] + i, n );
+		const auto r = load_n( radius + i, n );
+
+		//	Smallest signed clearance over all planes, no branch per plane
+		auto margin = vec::set( std::numeric_limits<float>::infinity( ) );
+
+		for( auto p = size_t{ 0 }; p < plane_count; ++p )
+		{
+			const auto *plane = planes + p * 4;
+
+			auto distance = vec::mul( x, vec::set( plane[ 0 ] ) );
+			distance      = vec::add( distance, vec::mul( y, vec::set( plane[ 1 ] ) ) );
+			distance      = vec::sub( vec::add( distance, vec::mul( z, vec::set( plane[ 2 ] ) ) ), vec::set( plane[ 3 ] ) );
+			margin        = vec::min( margin, vec::add( distance, r ) );
+		}
+
+		found += emit_mask( vec::ge( margin, vec::zero( ) ), i, n, visible, indices == nullptr ? nullptr : indices + found );
+	}
+
+	return found;
+}
+
+/**
+ * Boxes against the same planes, each plane tests the corner furthest along its normal
+ *
+ * \return survivors, their indices are compacted into indices
+ */
+inline auto cull_boxes( const float *const *mins, const float *const *maxs, const float *planes, const size_t plane_count, uint8_t *visible,
+						uint32_t *indices, const size_t count )->size_t
+{
+	auto found = size_t{ 0 };
+
+	for( auto i = size_t{ 0 }; i < count; i += Width )
+	{
+		const auto n = count - i < Width ? count - i : Width;
+
+		const V low[ 3 ]  = { load_n( mins[ 0 ] + i, n ), load_n( mins[ 1 ] + i, n ), load_n( mins[ 2 ] + i, n ) };
+		const V high[ 3 ] = { load_n( maxs[ 0 ] + i, n ), load_n( maxs[ 1 ] + i, n ), load_n( maxs[ 2 ] + i, n ) };
+
+		auto margin = vec::set( std::numeric_limits<float>::infinity( ) );
+
+		for( auto p = size_t{ 0 }; p < plane_count; ++p )
+		{
+			const auto *plane = planes + p * 4;
+
+			//	Normal signs are uniform across lanes, the corner pick is a scalar choice
+			auto distance = vec::mul( plane[ 0 ] >= 0.F ? high[ 0 ] : low[ 0 ], vec::set( plane[ 0 ] ) );
+			distance      = vec::add( distance, vec::mul( plane[ 1 ] >= 0.F ? high[ 1 ] : low[ 1 ], vec::set( plane[ 1 ] ) ) );
+			distance      = vec::add( distance, vec::mul( plane[ 2 ] >= 0.F ? high[ 2 ] : low[ 2 ], vec::set( plane[ 2 ] ) ) );
+			margin        = vec::min( margin, vec::sub( distance, vec::set( plane[ 3 ] ) ) );
+		}
+
+		found += emit_mask( vec::ge( margin, vec::zero( ) ), i, n, visible, indices == nullptr ? nullptr : indices + found );
+	}
+
+	return found;
+}
+
+//	============================================================================================
+//	Oriented boxes
+//	15 lanes per box: center, half extents, then the three unit axes one after another
+//	============================================================================================
+
+/**
+ * One segment from start along delta against count oriented boxes, slabs in each box's
+ * frame. fraction gets the entry, 0 when starting inside and 1 on a miss
+ *
+ * \return boxes hit, their indices are compacted into indices
+ */
+inline auto ray_obbs( const float *const *obb, const float *start, const float *delta, float *fraction, uint8_t *hit, uint32_t *indices,
+					  const size_t count )->size_t
+{
+	const auto zero     = vec::zero( );
+	const auto one      = vec::set( 1.F );
+	const auto infinity = vec::set( std::numeric_limits<float>::infinity( ) );
+
+	auto found = size_t{ 0 };
+
+	for( auto i = size_t{ 0 }; i < count; i += Width )
+	{
+		const auto n = count - i < Width ? count - i : Width;
+
+		const V offset[ 3 ] = { vec::sub( vec::set( start[ 0 ] ), load_n( obb[ 0 ] + i, n ) ), vec::sub( vec::set( start[ 1 ] ), load_n( obb[ 1 ] + i, n ) ),
+								vec::sub( vec::set( start[ 2 ] ), load_n( obb[ 2 ] + i, n ) ) };
+
+		auto entry = vec::sub( zero, infinity );
+		auto exit  = infinity;
+
+		for( auto k = size_t{ 0 }; k < 3; ++k )
+		{
+			const auto extent = load_n( obb[ 3 + k ] + i, n );
+			const auto ax     = load_n( obb[ 6 + k * 3 ] + i, n );
+			const auto ay     = load_n( obb[ 7 + k * 3 ] + i, n );
+			const auto az     = load_n( obb[ 8 + k * 3 ] + i, n );
+
+			//	Start and direction in the box frame
+			const auto e = vec::add( vec::add( vec::mul( offset[ 0 ], ax ), vec::mul( offset[ 1 ], ay ) ), vec::mul( offset[ 2 ], az ) );
+			const auto f = vec::add( vec::add( vec::mul( vec::set( delta[ 0 ] ), ax ), vec::mul( vec::set( delta[ 1 ] ), ay ) ), vec::mul( vec::set( delta[ 2 ] ), az ) );
+
+			const auto parallel = vec::eq( f, zero );
+			const auto inside   = vec::ge( extent, vec::abs( e ) );
+			const auto inverse  = vec::div( one, vec::select( parallel, one, f ) );
+
+			const auto t1 = vec::mul( vec::sub( vec::sub( zero, extent ), e ), inverse );
+			const auto t2 = vec::mul( vec::sub( extent, e ), inverse );
+
+			//	Parallel to the slab, inside it for the whole segment or never
+			const auto into = vec::select( parallel, vec::select( inside, vec::sub( zero, infinity ), infinity ), vec::min( t1, t2 ) );
+			const auto out  = vec::select( parallel, vec::select( inside, infinity, vec::sub( zero, infinity ) ), vec::max( t1, t2 ) );
+
+			entry = vec::max( entry, into );
+			exit  = vec::min( exit, out );
+		}
+
+		const auto touched = vec::land( vec::ge( exit, entry ), vec::land( vec::ge( exit, zero ), vec::lt( entry, one ) ) );
+
+		store_n( fraction + i, vec::select( touched, vec::max( entry, zero ), one ), n );
+
+		found += emit_mask( touched, i, n, hit, indices == nullptr ? nullptr : indices + found );
+	}
+
+	return found;
+}
+
+/**
+ * One oriented box, 15 floats in lane order, against count others with the 15 axis
+ * separating axis test
+ *
+ * \return boxes overlapping, their indices are compacted into indices
+ */
+inline auto overlap_obbs( const float *const *obb, const float *box, uint8_t *overlap, uint32_t *indices, const size_t count )->size_t
+{
+	//	Keeps near parallel edges, whose cross axis degenerates, from separating anything
+	constexpr auto Epsilon = 1e-6F;
+
+	const auto zero    = vec::zero( );
+	const auto epsilon = vec::set( Epsilon );
+
+	const V extent_a[ 3 ] = { vec::set( box[ 3 ] ), vec::set( box[ 4 ] ), vec::set( box[ 5 ] ) };
+
+	auto found = size_t{ 0 };
+
+	for( auto i = size_t{ 0 }; i < count; i += Width )
+	{
+		const auto n = count - i < Width ? count - i : Width;
+
+		const V extent_b[ 3 ] = { load_n( obb[ 3 ] + i, n ), load_n( obb[ 4 ] + i, n ), load_n( obb[ 5 ] + i, n ) };
+		const V offset[ 3 ]   = { vec::sub( load_n( obb[ 0 ] + i, n ), vec::set( box[ 0 ] ) ), vec::sub( load_n( obb[ 1 ] + i, n ), vec::set( box[ 1 ] ) ),
+								  vec::sub( load_n( obb[ 2 ] + i, n ), vec::set( box[ 2 ] ) ) };
+
+		V r[ 3 ][ 3 ];
+		V abs_r[ 3 ][ 3 ];
+		V t[ 3 ];
+
+		//	b's axes and the offset in a's frame
+		for( auto j = size_t{ 0 }; j < 3; ++j )
+		{
+			const auto bx = load_n( obb[ 6 + j * 3 ] + i, n );
+			const auto by = load_n( obb[ 7 + j * 3 ] + i, n );
+			const auto bz = load_n( obb[ 8 + j * 3 ] + i, n );
+
+			for( auto k = size_t{ 0 }; k < 3; ++k )
+			{
+				const auto *axis = box + 6 + k * 3;
+
+				r[ k ][ j ]     = vec::add( vec::add( vec::mul( vec::set( axis[ 0 ] ), bx ), vec::mul( vec::set( axis[ 1 ] ), by ) ), vec::mul( vec::set( axis[ 2 ] ), bz ) );
+				abs_r[ k ][ j ] = vec::add( vec::abs( r[ k ][ j ] ), epsilon );
+			}
+		}
+
+		for( auto k = size_t{ 0 }; k < 3; ++k )
+		{
+			const auto *axis = box + 6 + k * 3;
+
+			t[ k ] = vec::add( vec::add( vec::mul( offset[ 0 ], vec::set( axis[ 0 ] ) ), vec::mul( offset[ 1 ], vec::set( axis[ 1 ] ) ) ),
+							   vec::mul( offset[ 2 ], vec::set( axis[ 2 ] ) ) );
+		}
+
+		//	Overlapping while no axis separates, the projection distance never exceeds both radii
+		auto overlapping = vec::eq( zero, zero );
+
+		const auto test = [ &overlapping ]( const V ra, const V rb, const V distance )
+		{
+			overlapping = vec::land( overlapping, vec::ge( vec::add( ra, rb ), vec::abs( distance ) ) );
+		};
+
+		//	a's axes
+		for( auto k = size_t{ 0 }; k < 3; ++k )
+		{
+			const auto rb = vec::add( vec::add( vec::mul( extent_b[ 0 ], abs_r[ k ][ 0 ] ), vec::mul( extent_b[ 1 ], abs_r[ k ][ 1 ] ) ), vec::mul( extent_b[ 2 ], abs_r[ k ][ 2 ] ) );
+			test( extent_a[ k ], rb, t[ k ] );
+		}
+
+		//	b's axes
+		for( auto j = size_t{ 0 }; j < 3; ++j )
+		{
+			const auto ra       = vec::add( vec::add( vec::mul( extent_a[ 0 ], abs_r[ 0 ][ j ] ), vec::mul( extent_a[ 1 ], abs_r[ 1 ][ j ] ) ), vec::mul( extent_a[ 2 ], abs_r[ 2 ][ j ] ) );
+			const auto distance = vec::add( vec::add( vec::mul( t[ 0 ], r[ 0 ][ j ] ), vec::mul( t[ 1 ], r[ 1 ][ j ] ) ), vec::mul( t[ 2 ], r[ 2 ][ j ] ) );
+			test( ra, extent_b[ j ], distance );
+		}
+
+		//	Edge cross products
+		for( auto k = size_t{ 0 }; k < 3; ++k )
+		{
+			const auto k1 = ( k + 1 ) % 3;
+			const auto k2 = ( k + 2 ) % 3;
+
+			for( auto j = size_t{ 0 }; j < 3; ++j )
+			{
+				const auto j1 = ( j + 1 ) % 3;
+				const auto j2 = ( j + 2 ) % 3;
+
+				const auto ra       = vec::add( vec::mul( extent_a[ k1 ], abs_r[ k2 ][ j ] ), vec::mul( extent_a[ k2 ], abs_r[ k1 ][ j ] ) );
+				const auto rb       = vec::add( vec::mul( extent_b[ j1 ], abs_r[ k ][ j2 ] ), vec::mul( extent_b[ j2 ], abs_r[ k ][ j1 ] ) );
+				const auto distance = vec::sub( vec::mul( t[ k2 ], r[ k1 ][ j ] ), vec::mul( t[ k1 ], r[ k2 ][ j ] ) );
+				test( ra, rb, distance );
+			}
+		}
+
+		found += emit_mask( overlapping, i, n, overlap, indices == nullptr ? nullptr : indices + found );
+	}
+
+	return found;
+}
+
+/**
+ * One tick of CGameMovement::FullWalkMove without collision, lanes with a non zero
+ * ground value walk ( friction, Accelerate, speed clamp ), the others fly ( AirAccelerate,
+ * gravity in two halves ). wish is the wish velocity, its length the wish speed
+ */
+inline auto move_step( float *const *origin, float *const *velocity, const float *const *wish, const float *ground, const movement_params_t &params,
+					   const size_t count )->void
+{
+	const auto zero     = vec::zero( );
+	const auto one      = vec::set( 1.F );
+	const auto dt       = vec::set( params.interval );
+	const auto fall     = vec::set( 0.5F * params.gravity * params.interval );
+	const auto stop     = vec::set( params.stop_speed );
+	const auto friction = vec::set( params.friction * params.surface_friction * params.interval );
+	const auto maximum  = vec::set( params.max_speed );
+	const auto air_cap  = vec::set( params.air_speed_cap );
+	const auto walk     = vec::set( params.accelerate * params.interval * params.surface_friction );
+	const auto fly      = vec::set( params.air_accelerate * params.interval * params.surface_friction );
+	const auto minimum  = vec::set( 0.1F );
+
+	for( auto i = size_t{ 0 }; i < count; i += Width )
+	{
+		const auto n        = count - i < Width ? count - i : Width;
+		const auto grounded = vec::neq( load_n( ground + i, n ), zero );
+
+		auto vx = load_n( velocity[ 0 ] + i, n );
+		auto vy = load_n( velocity[ 1 ] + i, n );
+		auto vz = load_n( velocity[ 2 ] + i, n );
+
+		//	StartGravity in the air, velocity stays planar on the ground
+		vz = vec::select( grounded, zero, vec::sub( vz, fall ) );
+
+		//	Friction
+		const auto speed   = vec::sqrt( vec::add( vec::add( vec::mul( vx, vx ), vec::mul( vy, vy ) ), vec::mul( vz, vz ) ) );
+		const auto drop    = vec::mul( vec::max( speed, stop ), friction );
+		const auto slowed  = vec::div( vec::max( vec::sub( speed, drop ), zero ), speed );
+		const auto sliding = vec::land( grounded, vec::ge( speed, minimum ) );
+		const auto scale   = vec::select( sliding, slowed, one );
+
+		vx = vec::mul( vx, scale );
+		vy = vec::mul( vy, scale );
+		vz = vec::mul( vz, scale );
+
+		//	Accelerate / AirAccelerate
+		const auto wx         = load_n( wish[ 0 ] + i, n );
+		const auto wy         = load_n( wish[ 1 ] + i, n );
+		const auto wz         = load_n( wish[ 2 ] + i, n );
+		const auto wish_speed = vec::sqrt( vec::add( vec::add( vec::mul( wx, wx ), vec::mul( wy, wy ) ), vec::mul( wz, wz ) ) );
+		const auto wishing    = vec::gt( wish_speed, zero );
+		const auto inverse    = vec::select( wishing, vec::div( one, wish_speed ), zero );
+		const auto dx         = vec::mul( wx, inverse );
+		const auto dy         = vec::mul( wy, inverse );
+		const auto dz         = vec::mul( wz, inverse );
+		const auto capped     = vec::min( wish_speed, maximum );
+
+		const auto target  = vec::select( grounded, capped, vec::min( capped, air_cap ) );
+		const auto current = vec::add( vec::add( vec::mul( vx, dx ), vec::mul( vy, dy ) ), vec::mul( vz, dz ) );
+		const auto missing = vec::sub( target, current );
+		const auto gain    = vec::mul( vec::select( grounded, walk, fly ), capped );
+		const auto boost   = vec::select( vec::gt( missing, zero ), vec::min( gain, missing ), zero );
+
+		vx = vec::add( vx, vec::mul( dx, boost ) );
+		vy = vec::add( vy, vec::mul( dy, boost ) );
+		vz = vec::select( grounded, zero, vec::add( vz, vec::mul( dz, boost ) ) );
+
+		//	WalkMove clamps to max speed
+		const auto length  = vec::sqrt( vec::add( vec::add( vec::mul( vx, vx ), vec::mul( vy, vy ) ), vec::mul( vz, vz ) ) );
+		const auto clamped = vec::land( grounded, vec::gt( length, maximum ) );
+		const auto limit   = vec::select( clamped, vec::div( maximum, length ), one );
+
+		vx = vec::mul( vx, limit );
+		vy = vec::mul( vy, limit );
+		vz = vec::mul( vz, limit );
+
+		store_n( origin[ 0 ] + i, vec::add( load_n( origin[ 0 ] + i, n ), vec::mul( vx, dt ) ), n );
+		store_n( origin[ 1 ] + i, vec::add( load_n( origin[ 1 ] + i, n ), vec::mul( vy, dt ) ), n );
+		store_n( origin[ 2 ] + i, vec::add( load_n( origin[ 2 ] + i, n ), vec::mul( vz, dt ) ), n );
+
+		//	FinishGravity
+		store_n( velocity[ 0 ] + i, vx, n );
+		store_n( velocity[ 1 ] + i, vy, n );
+		store_n( velocity[ 2 ] + i, vec::select( grounded, vz, vec::sub( vz, fall ) ), n );
+	}
+}
+
+inline auto get_table( )->kernel_table_t
+{
+	return kernel_table_t{
+		Isa,
+		&get_dot,
+		&get_length,
+		&normalize_length,
+		&normalize_angle,
+		&clamp_angle,
+		&get_angle,
+		&translate,
+		&add_scaled,
+		&cross,
+		&project,
+		&get_plane_distance,
+		&reflect,
+		&toss_move,
+		&clip_plane,
+		&toss_bounce,
+		&sweep_boxes,
+		&trace_boxes,
+		&world_to_screen,
+		&cull_spheres,
+		&cull_boxes,
+		&ray_obbs,
+		&overlap_obbs,
+		&move_step,
+	};
+}
@@ -0,0 +1,385 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "batch.hh"
+#include "dispatch.hh"
+#include "instrument.hh"
+#include "vector.hh"
+
+//	============================================================================================
+//	Matrices
+//
+//	Row major like Source's VMatrix and matrix3x4_t, so matrices read out of the engine
+//	drop in as is. Rows are v4 packs, a row against a point is one pack dot
+//	============================================================================================
+
+struct matrix4x4_t
+{
+	public:
+	using v2   = vector_t<float>::v2;
+	using v3   = vector_t<float>::v3;
+	using v4   = vector_t<float>::v4;
+	using Rows = std::array<v4, 4>;
+
+	//	============================================================================================
+
+	explicit matrix4x4_t( ) = default;
+
+	auto initialize( const v4 &r0, const v4 &r1, const v4 &r2, const v4 &r3 )->void
+	{
+		m_rows = Rows{ r0, r1, r2, r3 };
+	}
+
+	explicit matrix4x4_t( const v4 &r0, const v4 &r1, const v4 &r2, const v4 &r3 )
+	{
+		initialize( r0, r1, r2, r3 );
+	}
+
+	static auto identity( )->matrix4x4_t
+	{
+		return matrix4x4_t{ v4{ 1.F, 0.F, 0.F, 0.F }, v4{ 0.F, 1.F, 0.F, 0.F }, v4{ 0.F, 0.F, 1.F, 0.F }, v4{ 0.F, 0.F, 0.F, 1.F } };
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	Operational methods
+	//	============================================================================================
+
+	auto operator[ ]( const size_t row )const->const v4 &
+	{
+		return m_rows[ row ];
+	}
+
+	auto operator[ ]( const size_t row )->v4 &
+	{
+		return m_rows[ row ];
+	}
+
+	auto get_column( const size_t column )const->v4
+	{
+		return v4{ m_rows[ 0 ][ column ], m_rows[ 1 ][ column ], m_rows[ 2 ][ column ], m_rows[ 3 ][ column ] };
+	}
+
+	/**
+	 * Row major copy of all 16 entries, the layout kernels take
+	 *
+	 * \return
+	 */
+	auto get_contents( )const->std::array<float, 16>
+	{
+		auto result = std::array<float, 16>{ };
+
+		for( auto r = size_t{ 0 }; r < 4; ++r )
+		{
+			for( auto c = size_t{ 0 }; c < 4; ++c )
+			{
+				result[ r * 4 + c ] = m_rows[ r ][ c ];
+			}
+		}
+
+		return result;
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	Mathematical methods
+	//	============================================================================================
+
+	auto transposed( )const->matrix4x4_t
+	{
+		return matrix4x4_t{ get_column( 0 ), get_column( 1 ), get_column( 2 ), get_column( 3 ) };
+	}
+
+	/**
+	 * this * arg, applying the result applies arg first
+	 *
+	 * \param arg
+	 * \return
+	 */
+	auto multiply( const matrix4x4_t &arg )const->matrix4x4_t
+	{
+		const auto columns = arg.transposed( );
+		auto result        = matrix4x4_t{ };
+
+		for( auto r = size_t{ 0 }; r < 4; ++r )
+		{
+			for( auto c = size_t{ 0 }; c < 4; ++c )
+			{
+				result[ r ][ c ] = m_rows[ r ].dot( columns[ c ] );
+			}
+		}
+
+		return result;
+	}
+
+	/**
+	 * this * arg with arg as a column vector
+	 *
+	 * \param arg
+	 * \return
+	 */
+	auto transform( const v4 &arg )const->v4
+	{
+		return v4{ m_rows[ 0 ].dot( arg ), m_rows[ 1 ].dot( arg ), m_rows[ 2 ].dot( arg ), m_rows[ 3 ].dot( arg ) };
+	}
+
+	/**
+	 * Source's WorldToScreen, same formula as the batched kernel
+	 *
+	 * \param position
+	 * \param width
+	 * \param height
+	 * \param screen	left untouched when the position is behind the near clip
+	 * \return in front and inside the viewport
+	 */
+	auto world_to_screen( const v3 &position, const float width, const float height, v2 &screen )const->bool
+	{
+		const auto point = v4{ position[ 0 ], position[ 1 ], position[ 2 ], 1.F };
+		const auto w     = m_rows[ 3 ].dot( point );
+
+		if( w < 0.001F )
+		{
+			return false;
+		}
+
+		const auto inverse = 1.F / w;
+
+		screen[ 0 ] = width * 0.5F + width * 0.5F * ( m_rows[ 0 ].dot( point ) * inverse );
+		screen[ 1 ] = height * 0.5F - height * 0.5F * ( m_rows[ 1 ].dot( point ) * inverse );
+
+		return screen[ 0 ] >= 0.F && screen[ 0 ] <= width && screen[ 1 ] >= 0.F && screen[ 1 ] <= height;
+	}
+
+	//	============================================================================================
+
+	private:
+	Rows m_rows = Rows{ v4{ }, v4{ }, v4{ }, v4{ } };
+};
+
+/**
+ * Source's matrix3x4_t, a rotation in the first three columns and a translation in the
+ * last. Columns 0, 1 and 2 are forward, left and up, the way bone and entity matrices
+ * come out of the engine
+ */
+struct matrix3x4_t
+{
+	public:
+	using v3   = vector_t<float>::v3;
+	using v4   = vector_t<float>::v4;
+	using Rows = std::array<v4, 3>;
+
+	//	============================================================================================
+
+	explicit matrix3x4_t( ) = default;
+
+	auto initialize( const v4 &r0, const v4 &r1, const v4 &r2 )->void
+	{
+		m_rows = Rows{ r0, r1, r2 };
+	}
+
+	explicit matrix3x4_t( const v4 &r0, const v4 &r1, const v4 &r2 )
+	{
+		initialize( r0, r1, r2 );
+	}
+
+	static auto identity( )->matrix3x4_t
+	{
+		return matrix3x4_t{ v4{ 1.F, 0.F, 0.F, 0.F }, v4{ 0.F, 1.F, 0.F, 0.F }, v4{ 0.F, 0.F, 1.F, 0.F } };
+	}
+
+	/**
+	 * MatrixSetColumn for all four columns
+	 *
+	 * \param x
+	 * \param y
+	 * \param z
+	 * \param origin
+	 * \return
+	 */
+	static auto from_columns( const v3 &x, const v3 &y, const v3 &z, const v3 &origin )->matrix3x4_t
+	{
+		return matrix3x4_t{
+			v4{ x[ 0 ], y[ 0 ], z[ 0 ], origin[ 0 ] },
+			v4{ x[ 1 ], y[ 1 ], z[ 1 ], origin[ 1 ] },
+			v4{ x[ 2 ], y[ 2 ], z[ 2 ], origin[ 2 ] } };
+	}
+
+	/**
+	 * AngleMatrix
+	 *
+	 * \param angles	pitch / yaw / roll, degrees
+	 * \param origin
+	 * \return
+	 */
+	static auto from_angles( const v3 &angles, const v3 &origin = v3{ } )->matrix3x4_t
+	{
+		auto forward = v3{ };
+		auto right   = v3{ };
+		auto up      = v3{ };
+
+		angles.angle_vectors( forward, right, up );
+
+		return from_columns( forward, v3{ -right[ 0 ], -right[ 1 ], -right[ 2 ] }, up, origin );
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	Operational methods
+	//	============================================================================================
+
+	auto operator[ ]( const size_t row )const->const v4 &
+	{
+		return m_rows[ row ];
+	}
+
+	auto operator[ ]( const size_t row )->v4 &
+	{
+		return m_rows[ row ];
+	}
+
+	auto get_column( const size_t column )const->v3
+	{
+		return v3{ m_rows[ 0 ][ column ], m_rows[ 1 ][ column ], m_rows[ 2 ][ column ] };
+	}
+
+	auto get_origin( )const->v3
+	{
+		return get_column( 3 );
+	}
+
+	/**
+	 * Row major copy of all 12 entries, the layout kernels take
+	 *
+	 * \return
+	 */
+	auto get_contents( )const->std::array<float, 12>
+	{
+		auto result = std::array<float, 12>{ };
+
+		for( auto r = size_t{ 0 }; r < 3; ++r )
+		{
+			for( auto c = size_t{ 0 }; c < 4; ++c )
+			{
+				result[ r * 4 + c ] = m_rows[ r ][ c ];
+			}
+		}
+
+		return result;
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	Mathematical methods
+	//	============================================================================================
+
+	/**
+	 * ConcatTransforms, this * arg with the implied fourth row ( 0, 0, 0, 1 )
+	 *
+	 * \param arg
+	 * \return
+	 */
+	auto multiply( const matrix3x4_t &arg )const->matrix3x4_t
+	{
+		auto result = matrix3x4_t{ };
+
+		for( auto c = size_t{ 0 }; c < 4; ++c )
+		{
+			const auto column = v4{ arg[ 0 ][ c ], arg[ 1 ][ c ], arg[ 2 ][ c ], c == 3 ? 1.F : 0.F };
+
+			for( auto r = size_t{ 0 }; r < 3; ++r )
+			{
+				result[ r ][ c ] = m_rows[ r ].dot( column );
+			}
+		}
+
+		return result;
+	}
+
+	/**
+	 * VectorTransform
+	 *
+	 * \param arg
+	 * \return
+	 */
+	auto transform( const v3 &arg )const->v3
+	{
+		const auto point = v4{ arg[ 0 ], arg[ 1 ], arg[ 2 ], 1.F };
+		return v3{ m_rows[ 0 ].dot( point ), m_rows[ 1 ].dot( point ), m_rows[ 2 ].dot( point ) };
+	}
+
+	/**
+	 * VectorRotate, translation ignored
+	 *
+	 * \param arg
+	 * \return
+	 */
+	auto rotate( const v3 &arg )const->v3
+	{
+		const auto direction = v4{ arg[ 0 ], arg[ 1 ], arg[ 2 ], 0.F };
+		return v3{ m_rows[ 0 ].dot( direction ), m_rows[ 1 ].dot( direction ), m_rows[ 2 ].dot( direction ) };
+	}
+
+	/**
+	 * VectorIRotate, exact for rotations only
+	 *
+	 * \param arg
+	 * \return
+	 */
+	auto inverse_rotate( const v3 &arg )const->v3
+	{
+		return v3{ get_column( 0 ).dot( arg ), get_column( 1 ).dot( arg ), get_column( 2 ).dot( arg ) };
+	}
+
+	/**
+	 * VectorITransform, exact for rotations only
+	 *
+	 * \param arg
+	 * \return
+	 */
+	auto inverse_transform( const v3 &arg )const->v3
+	{
+		const auto origin = get_origin( );
+		return inverse_rotate( v3{ arg[ 0 ] - origin[ 0 ], arg[ 1 ] - origin[ 1 ], arg[ 2 ] - origin[ 2 ] } );
+	}
+
+	//	============================================================================================
+
+	private:
+	Rows m_rows = Rows{ v4{ }, v4{ }, v4{ } };
+};
+
+/**
+ * Project every position to the screen, one kernel pass
+ * Positions behind the near clip land on zero, visible is 1 for positions
+ * in front and inside the viewport
+ *
+ * \param positions
+ * \param matrix	view projection, e.g. IVEngineClient::WorldToScreenMatrix
+ * \param width
+ * \param height
+ * \param screen
+ * \param visible
+ */
+inline auto world_to_screen( const soa_batch_t<vector_t<float>::v3> &positions, const matrix4x4_t &matrix, const float width, const float height,
+							 soa_batch_t<vector_t<float>::v2> &screen, std::span<uint8_t> visible )->void
+{
+	assert( visible.size( ) >= positions.get_size( ) );
+
+	PACK_TIME( batch_world_to_screen );
+
+	screen.resize( positions.get_size( ) );
+
+	const auto contents = matrix.get_contents( );
+	const auto position = detail::get_lanes( positions );
+	const auto lanes    = detail::get_lanes( screen );
+
+	get_kernels( ).world_to_screen( position.data( ), contents.data( ), width, height, lanes.data( ), visible.data( ), positions.get_size( ) );
+}
@@ -0,0 +1,383 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+#include "batch.hh"
+#include "dispatch.hh"
+#include "instrument.hh"
+#include "simd.hh"
+#include "vector.hh"
+
+//	============================================================================================
+//	Morton order
+//
+//	Positions are quantized inside their bounds and their bits interleaved x, y, z from
+//	the bottom up, so points close in space get close keys. Sorting a batch by key puts
+//	neighbours next to each other in memory for every spatial pass that follows
+//	============================================================================================
+
+#if defined( PACK_X86 ) && ( defined( _M_X64 ) || defined( __x86_64__ ) )
+#define PACK_PDEP 1
+#endif
+
+namespace detail
+{
+	//	Every third bit from bit 0, 21 bits per axis fill 63
+	constexpr auto Morton_mask = uint64_t{ 0x1249249249249249 };
+
+	/**
+	 * Spread the low 21 bits to every third bit, shift and mask fallback for PDEP
+	 *
+	 * \param value
+	 * \return
+	 */
+	constexpr auto spread_bits( const uint32_t value )->uint64_t
+	{
+		auto result = uint64_t{ value } & 0x1FFFFFU;
+
+		result = ( result | result << 32 ) & 0x001F00000000FFFFU;
+		result = ( result | result << 16 ) & 0x001F0000FF0000FFU;
+		result = ( result | result << 8 ) & 0x100F00F00F00F00FU;
+		result = ( result | result << 4 ) & 0x10C30C30C30C30C3U;
+		result = ( result | result << 2 ) & Morton_mask;
+
+		return result;
+	}
+
+	constexpr auto compact_bits( const uint64_t value )->uint32_t
+	{
+		auto result = value & Morton_mask;
+
+		result = ( result ^ ( result >> 2 ) ) & 0x10C30C30C30C30C3U;
+		result = ( result ^ ( result >> 4 ) ) & 0x100F00F00F00F00FU;
+		result = ( result ^ ( result >> 8 ) ) & 0x001F0000FF0000FFU;
+		result = ( result ^ ( result >> 16 ) ) & 0x001F00000000FFFFU;
+		result = ( result ^ ( result >> 32 ) ) & 0x1FFFFFU;
+
+		return static_cast<uint32_t>( result );
+	}
+
+	/**
+	 * Grid cell of value, NaN and anything below low lands on 0
+	 */
+	inline auto quantize( const float value, const float low, const float scale, const float cells )->uint32_t
+	{
+		const auto cell = ( value - low ) * scale;
+		return static_cast<uint32_t>( cell > 0.F ? ( cell < cells ? cell : cells ) : 0.F );
+	}
+
+	//	============================================================================================
+
+	inline auto morton_keys_portable( const float *const *lanes, const float *low, const float *scale, const float cells, uint64_t *keys,
+									  const size_t count )->void
+	{
+		for( auto i = size_t{ 0 }; i < count; ++i )
+		{
+			keys[ i ] = spread_bits( quantize( lanes[ 0 ][ i ], low[ 0 ], scale[ 0 ], cells ) ) |
+						spread_bits( quantize( lanes[ 1 ][ i ], low[ 1 ], scale[ 1 ], cells ) ) << 1 |
+						spread_bits( quantize( lanes[ 2 ][ i ], low[ 2 ], scale[ 2 ], cells ) ) << 2;
+		}
+	}
+
+#if defined( PACK_PDEP )
+
+#if defined( __clang__ )
+#pragma clang attribute push( __attribute__( ( target( "bmi2" ) ) ), apply_to = function )
+#elif defined( __GNUC__ )
+#pragma GCC push_options
+#pragma GCC target( "bmi2" )
+#endif
+
+	inline auto morton_keys_pdep( const float *const *lanes, const float *low, const float *scale, const float cells, uint64_t *keys,
+								  const size_t count )->void
+	{
+		for( auto i = size_t{ 0 }; i < count; ++i )
+		{
+			keys[ i ] = _pdep_u64( quantize( lanes[ 0 ][ i ], low[ 0 ], scale[ 0 ], cells ), Morton_mask ) |
+						_pdep_u64( quantize( lanes[ 1 ][ i ], low[ 1 ], scale[ 1 ], cells ), Morton_mask << 1 ) |
+						_pdep_u64( quantize( lanes[ 2 ][ i ], low[ 2 ], scale[ 2 ], cells ), Morton_mask << 2 );
+		}
+	}
+
+#if defined( __clang__ )
+#pragma clang attribute pop
+#elif defined( __GNUC__ )
+#pragma GCC pop_options
+#endif
+
+#endif
+}
+
+/**
+ * Interleave three 21 bit cell coordinates, x in the lowest bit
+ *
+ * \param x
+ * \param y
+ * \param z
+ * \return
+ */
+constexpr auto morton_encode( const uint32_t x, const uint32_t y, const uint32_t z )->uint64_t
+{
+	return detail::spread_bits( x ) | detail::spread_bits( y ) << 1 | detail::spread_bits( z ) << 2;
+}
+
+constexpr auto morton_decode( const uint64_t key )->std::array<uint32_t, 3>
+{
+	return { detail::compact_bits( key ), detail::compact_bits( key >> 1 ), detail::compact_bits( key >> 2 ) };
+}
+
+//	============================================================================================
+
+/**
+ * Keys and the sorting permutation of a position batch, scratch is kept between calls.
+ * sort( ) decides the order, apply( ) moves any batch of the same size into it
+ */
+struct morton_sorter_t
+{
+	public:
+	using v3 = vector_t<float>::v3;
+
+	constexpr static uint32_t Max_bits = 21;
+
+	//	============================================================================================
+
+	/**
+	 * \param bits		per axis, 10 resolves 1024 cells along the widest side and sorts in 4 passes
+	 * \param resource
+	 */
+	explicit morton_sorter_t( const uint32_t bits = 10, std::pmr::memory_resource *resource = std::pmr::get_default_resource( ) )
+		: m_bits( std::clamp<uint32_t>( bits, 1, Max_bits ) ), m_keys( resource ), m_order( resource ), m_key_scratch( resource ), m_order_scratch( resource )
+	{
+	}
+
+	//	============================================================================================
+
+	auto get_bits( )const->uint32_t
+	{
+		return m_bits;
+	}
+
+	/**
+	 * Sorted keys
+	 *
+	 * \return
+	 */
+	auto get_keys( )const->std::span<const uint64_t>
+	{
+		return m_keys;
+	}
+
+	/**
+	 * order[ i ] is the original index of what is now at i
+	 *
+	 * \return
+	 */
+	auto get_order( )const->std::span<const uint32_t>
+	{
+		return m_order;
+	}
+
+	/**
+	 * Key every position within the bounds of the batch and sort, stable for equal keys
+	 *
+	 * \param positions
+	 */
+	auto sort( const soa_batch_t<v3> &positions )->void
+	{
+		auto mins = v3{ };
+		auto maxs = v3{ };
+
+		get_bounds( positions, mins, maxs );
+		sort( positions, mins, maxs );
+	}
+
+	/**
+	 * Same with fixed bounds, e.g. the map's, so keys compare across batches and ticks.
+	 * Positions outside are clamped onto the bounds
+	 *
+	 * \param positions
+	 * \param mins
+	 * \param maxs
+	 */
+	auto sort( const soa_batch_t<v3> &positions, const v3 &mins, const v3 &maxs )->void
+	{
+		PACK_TIME( morton_sort );
+
+		const auto count = positions.get_size( );
+
+		m_keys.resize( count );
+		m_order.resize( count );
+		m_key_scratch.resize( count );
+		m_order_scratch.resize( count );
+
+		encode( positions, mins, maxs );
+
+		for( auto i = size_t{ 0 }; i < count; ++i )
+		{
+			m_order[ i ] = static_cast<uint32_t>( i );
+		}
+
+		radix_sort( );
+	}
+
+	/**
+	 * Reorder a struct of arrays batch into the last sort's order
+	 *
+	 * \param batch
+	 */
+	template <detail::pack_t P>
+	auto apply( soa_batch_t<P> &batch )const->void
+	{
+		assert( batch.get_size( ) == m_order.size( ) );
+
+		auto scratch = std::pmr::vector<typename P::Type>( m_order.size( ), batch.get_resource( ) );
+
+		for( auto c = size_t{ 0 }; c < P::Len; ++c )
+		{
+			gather( std::span<typename P::Type>{ batch.lane( c ), m_order.size( ) }, scratch );
+		}
+	}
+
+	/**
+	 * Reorder any other array, e.g. an array of structs batch or entity indices
+	 *
+	 * \param values
+	 */
+	template <typename T>
+	auto apply( std::span<T> values )const->void
+	{
+		assert( values.size( ) == m_order.size( ) );
+
+		auto scratch = std::pmr::vector<T>( m_order.size( ), m_order.get_allocator( ).resource( ) );
+		gather( values, scratch );
+	}
+
+	//	============================================================================================
+
+	private:
+	static auto get_bounds( const soa_batch_t<v3> &positions, v3 &mins, v3 &maxs )->void
+	{
+		if( positions.get_size( ) == 0 )
+		{
+			return;
+		}
+
+		for( auto c = size_t{ 0 }; c < 3; ++c )
+		{
+			const auto *lane  = positions.lane( c );
+			const auto bounds = std::minmax_element( lane, lane + positions.get_size( ) );
+
+			mins[ c ] = *bounds.first;
+			maxs[ c ] = *bounds.second;
+		}
+	}
+
+	/**
+	 * One scale for all axes so cells stay cubes and the key order follows distance
+	 */
+	auto encode( const soa_batch_t<v3> &positions, const v3 &mins, const v3 &maxs )->void
+	{
+		const auto cells  = static_cast<float>( ( 1U << m_bits ) - 1U );
+		const auto extent = std::max( { maxs[ 0 ] - mins[ 0 ], maxs[ 1 ] - mins[ 1 ], maxs[ 2 ] - mins[ 2 ] } );
+		const auto factor = extent > 0.F ? cells / extent : 0.F;
+
+		const auto lanes = detail::get_lanes( positions );
+		const auto low   = mins.get_contents( );
+		const auto scale = std::array<float, 3>{ factor, factor, factor };
+
+#if defined( PACK_PDEP )
+		if( has_fast_pdep( ) )
+		{
+			detail::morton_keys_pdep( lanes.data( ), low.data( ), scale.data( ), cells, m_keys.data( ), m_keys.size( ) );
+			return;
+		}
+#endif
+
+		detail::morton_keys_portable( lanes.data( ), low.data( ), scale.data( ), cells, m_keys.data( ), m_keys.size( ) );
+	}
+
+	/**
+	 * Least significant digit first, 8 bits a pass. All histograms come from one read of
+	 * the keys and passes whose digit is the same for every key are skipped
+	 */
+	auto radix_sort( )->void
+	{
+		constexpr auto Digits = size_t{ 8 };
+		constexpr auto Radix  = size_t{ 256 };
+
+		const auto count  = m_keys.size( );
+		const auto passes = ( m_bits * 3 + 7 ) / 8;
+
+		auto histograms = std::array<std::array<uint32_t, Radix>, Digits>{ };
+
+		for( const auto key : m_keys )
+		{
+			for( auto d = size_t{ 0 }; d < passes; ++d )
+			{
+				++histograms[ d ][ ( key >> ( d * 8 ) ) & 0xFFU ];
+			}
+		}
+
+		for( auto d = size_t{ 0 }; d < passes; ++d )
+		{
+			auto &histogram  = histograms[ d ];
+			const auto shift = d * 8;
+
+			if( histogram[ ( m_keys.empty( ) ? 0 : m_keys[ 0 ] >> shift ) & 0xFFU ] == count )
+			{
+				continue;
+			}
+
+			//	Counts to starting offsets
+			auto offset = uint32_t{ 0 };
+
+			for( auto &bucket : histogram )
+			{
+				const auto size = bucket;
+				bucket          = offset;
+				offset += size;
+			}
+
+			//	Plain pointers, stores through the vectors would reload their data every element
+			const auto *keys  = m_keys.data( );
+			const auto *order = m_order.data( );
+			auto *key_out     = m_key_scratch.data( );
+			auto *order_out   = m_order_scratch.data( );
+
+			for( auto i = size_t{ 0 }; i < count; ++i )
+			{
+				const auto target = histogram[ ( keys[ i ] >> shift ) & 0xFFU ]++;
+
+				key_out[ target ]   = keys[ i ];
+				order_out[ target ] = order[ i ];
+			}
+
+			m_keys.swap( m_key_scratch );
+			m_order.swap( m_order_scratch );
+		}
+	}
+
+	template <typename T>
+	auto gather( std::span<T> values, std::pmr::vector<T> &scratch )const->void
+	{
+		for( auto i = size_t{ 0 }; i < m_order.size( ); ++i )
+		{
+			scratch[ i ] = values[ m_order[ i ] ];
+		}
+
+		std::copy( scratch.begin( ), scratch.end( ), values.begin( ) );
+	}
+
+	uint32_t m_bits;
+
+	std::pmr::vector<uint64_t> m_keys;
+	std::pmr::vector<uint32_t> m_order;
+	std::pmr::vector<uint64_t> m_key_scratch;
+	std::pmr::vector<uint32_t> m_order_scratch;
+};
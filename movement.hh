@@ -0,0 +1,120 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+#include "batch.hh"
+#include "dispatch.hh"
+#include "instrument.hh"
+#include "vector.hh"
+
+//	============================================================================================
+//	Player movement prediction
+//
+//	Replicates CGameMovement friction, Accelerate and AirAccelerate over struct of arrays
+//	state. Every bot is expanded into one lane per candidate wish velocity, so a whole
+//	tick of bots x candidates is a single kernel call. Collision is not part of this step
+//	============================================================================================
+
+struct movement_predictor_t
+{
+	public:
+	using v3 = vector_t<float>::v3;
+
+	//	============================================================================================
+
+	explicit movement_predictor_t( const movement_params_t &params = { }, std::pmr::memory_resource *resource = std::pmr::get_default_resource( ) )
+		: m_params( params ), m_wishes( resource ), m_ground( resource )
+	{
+	}
+
+	//	============================================================================================
+
+	auto get_params( )const->const movement_params_t &
+	{
+		return m_params;
+	}
+
+	/**
+	 * Predict every bot under every candidate for a number of ticks
+	 * Results are bot major, bot b under candidate k lands in b * candidates + k
+	 *
+	 * \param origins		one per bot
+	 * \param velocities	one per bot
+	 * \param ground		one per bot, non zero when standing on ground
+	 * \param wishes		world space wish velocities ( forward * fmove + right * smove, z = 0 ),
+	 *						either candidates shared by every bot or candidates per bot
+	 * \param candidates	wish velocities per bot
+	 * \param ticks
+	 * \param out_origins
+	 * \param out_velocities
+	 */
+	auto predict( const soa_batch_t<v3> &origins, const soa_batch_t<v3> &velocities, std::span<const uint8_t> ground, const soa_batch_t<v3> &wishes,
+				  const size_t candidates, const size_t ticks, soa_batch_t<v3> &out_origins, soa_batch_t<v3> &out_velocities )->void
+	{
+		const auto bots  = origins.get_size( );
+		const auto count = bots * candidates;
+
+		assert( velocities.get_size( ) >= bots );
+		assert( ground.size( ) >= bots );
+		assert( wishes.get_size( ) == candidates || wishes.get_size( ) >= count );
+
+		PACK_TIME( movement_predict );
+
+		out_origins.resize( count );
+		out_velocities.resize( count );
+		m_ground.resize( count );
+
+		for( auto c = size_t{ 0 }; c < 3; ++c )
+		{
+			for( auto b = size_t{ 0 }; b < bots; ++b )
+			{
+				std::fill_n( out_origins.lane( c ) + b * candidates, candidates, origins.lane( c )[ b ] );
+				std::fill_n( out_velocities.lane( c ) + b * candidates, candidates, velocities.lane( c )[ b ] );
+			}
+		}
+
+		for( auto b = size_t{ 0 }; b < bots; ++b )
+		{
+			std::fill_n( m_ground.begin( ) + b * candidates, candidates, ground[ b ] != 0 ? 1.F : 0.F );
+		}
+
+		//	A shared candidate set is tiled so the kernel sees one wish per lane
+		const auto *lanes = &wishes;
+
+		if( wishes.get_size( ) == candidates && bots > 1 )
+		{
+			m_wishes.resize( count );
+
+			for( auto c = size_t{ 0 }; c < 3; ++c )
+			{
+				for( auto b = size_t{ 0 }; b < bots; ++b )
+				{
+					std::copy_n( wishes.lane( c ), candidates, m_wishes.lane( c ) + b * candidates );
+				}
+			}
+
+			lanes = &m_wishes;
+		}
+
+		const auto &kernels = get_kernels( );
+		const auto origin   = detail::get_lanes( out_origins );
+		const auto velocity = detail::get_lanes( out_velocities );
+		const auto wish     = detail::get_lanes( *lanes );
+
+		for( auto tick = size_t{ 0 }; tick < ticks; ++tick )
+		{
+			kernels.move_step( origin.data( ), velocity.data( ), wish.data( ), m_ground.data( ), m_params, count );
+		}
+	}
+
+	//	============================================================================================
+
+	private:
+	movement_params_t m_params;
+	soa_batch_t<v3> m_wishes;
+	std::pmr::vector<float> m_ground;
+};
@@ -0,0 +1,374 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <span>
+#include "batch.hh"
+#include "dispatch.hh"
+#include "instrument.hh"
+#include "matrix.hh"
+#include "vector.hh"
+
+//	============================================================================================
+//	Oriented boxes
+//
+//	Hitboxes and rotated props, a box in the frame of a matrix3x4_t. Batches keep every
+//	component of every box in its own lane so the kernels test a full register of boxes,
+//	each with its own rotation, per step
+//	============================================================================================
+
+/**
+ * Center, half extents and three unit axes
+ */
+struct obb_t
+{
+	public:
+	using v3 = vector_t<float>::v3;
+
+	//	Floats per box in kernel order
+	constexpr static size_t Lanes = 15;
+
+	v3 center              = v3{ };
+	v3 extents             = v3{ };
+	std::array<v3, 3> axes = { v3{ 1.F, 0.F, 0.F }, v3{ 0.F, 1.F, 0.F }, v3{ 0.F, 0.F, 1.F } };
+
+	//	============================================================================================
+
+	/**
+	 * Box given by bounds in a rotated frame, e.g. a hitbox's bbmin / bbmax in its bone
+	 * matrix. The matrix must not scale
+	 *
+	 * \param matrix
+	 * \param mins
+	 * \param maxs
+	 * \return
+	 */
+	static auto from_matrix( const matrix3x4_t &matrix, const v3 &mins, const v3 &maxs )->obb_t
+	{
+		auto result = obb_t{ };
+
+		result.center  = matrix.transform( v3{ ( mins[ 0 ] + maxs[ 0 ] ) * 0.5F, ( mins[ 1 ] + maxs[ 1 ] ) * 0.5F, ( mins[ 2 ] + maxs[ 2 ] ) * 0.5F } );
+		result.extents = v3{ ( maxs[ 0 ] - mins[ 0 ] ) * 0.5F, ( maxs[ 1 ] - mins[ 1 ] ) * 0.5F, ( maxs[ 2 ] - mins[ 2 ] ) * 0.5F };
+		result.axes    = { matrix.get_column( 0 ), matrix.get_column( 1 ), matrix.get_column( 2 ) };
+
+		return result;
+	}
+
+	/**
+	 * Frame of the box, axes as columns and the center as origin
+	 *
+	 * \return
+	 */
+	auto get_matrix( )const->matrix3x4_t
+	{
+		return matrix3x4_t::from_columns( axes[ 0 ], axes[ 1 ], axes[ 2 ], center );
+	}
+
+	/**
+	 * Every component in kernel lane order
+	 *
+	 * \return
+	 */
+	auto get_contents( )const->std::array<float, Lanes>
+	{
+		return {
+			center[ 0 ], center[ 1 ], center[ 2 ],
+			extents[ 0 ], extents[ 1 ], extents[ 2 ],
+			axes[ 0 ][ 0 ], axes[ 0 ][ 1 ], axes[ 0 ][ 2 ],
+			axes[ 1 ][ 0 ], axes[ 1 ][ 1 ], axes[ 1 ][ 2 ],
+			axes[ 2 ][ 0 ], axes[ 2 ][ 1 ], axes[ 2 ][ 2 ] };
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	Single tests
+	//	Same operations in the same order as the kernels. The kernels never contract, so
+	//	these agree lane for lane when built with -ffp-contract=off as the README does, and
+	//	otherwise only to within rounding
+	//	============================================================================================
+
+	/**
+	 * \param start
+	 * \param delta
+	 * \return entry fraction, 0 when starting inside and 1 on a miss
+	 */
+	auto intersect_ray( const v3 &start, const v3 &delta )const->float
+	{
+		constexpr auto Infinity = std::numeric_limits<float>::infinity( );
+
+		const auto offset = v3{ start[ 0 ] - center[ 0 ], start[ 1 ] - center[ 1 ], start[ 2 ] - center[ 2 ] };
+
+		auto entry = -Infinity;
+		auto exit  = Infinity;
+
+		for( auto k = size_t{ 0 }; k < 3; ++k )
+		{
+			const auto &axis = axes[ k ];
+
+			const auto e = offset[ 0 ] * axis[ 0 ] + offset[ 1 ] * axis[ 1 ] + offset[ 2 ] * axis[ 2 ];
+			const auto f = delta[ 0 ] * axis[ 0 ] + delta[ 1 ] * axis[ 1 ] + delta[ 2 ] * axis[ 2 ];
+
+			auto into = 0.F;
+			auto out  = 0.F;
+
+			if( f == 0.F )
+			{
+				const auto inside = extents[ k ] >= std::fabs( e );
+
+				into = inside ? -Infinity : Infinity;
+				out  = inside ? Infinity : -Infinity;
+			}
+			else
+			{
+				const auto inverse = 1.F / f;
+				const auto t1      = ( -extents[ k ] - e ) * inverse;
+				const auto t2      = ( extents[ k ] - e ) * inverse;
+
+				into = t1 < t2 ? t1 : t2;
+				out  = t1 > t2 ? t1 : t2;
+			}
+
+			entry = entry > into ? entry : into;
+			exit  = exit < out ? exit : out;
+		}
+
+		if( exit >= entry && exit >= 0.F && entry < 1.F )
+		{
+			return entry > 0.F ? entry : 0.F;
+		}
+
+		return 1.F;
+	}
+
+	/**
+	 * Separating axis test over the 3 + 3 face and 9 edge axes
+	 *
+	 * \param arg
+	 * \return
+	 */
+	auto intersects( const obb_t &arg )const->bool
+	{
+		constexpr auto Epsilon = 1e-6F;
+
+		const auto offset = v3{ arg.center[ 0 ] - center[ 0 ], arg.center[ 1 ] - center[ 1 ], arg.center[ 2 ] - center[ 2 ] };
+
+		float r[ 3 ][ 3 ];
+		float abs_r[ 3 ][ 3 ];
+		float t[ 3 ];
+
+		for( auto j = size_t{ 0 }; j < 3; ++j )
+		{
+			for( auto k = size_t{ 0 }; k < 3; ++k )
+			{
+				r[ k ][ j ]     = axes[ k ][ 0 ] * arg.axes[ j ][ 0 ] + axes[ k ][ 1 ] * arg.axes[ j ][ 1 ] + axes[ k ][ 2 ] * arg.axes[ j ][ 2 ];
+				abs_r[ k ][ j ] = std::fabs( r[ k ][ j ] ) + Epsilon;
+			}
+		}
+
+		for( auto k = size_t{ 0 }; k < 3; ++k )
+		{
+			t[ k ] = offset[ 0 ] * axes[ k ][ 0 ] + offset[ 1 ] * axes[ k ][ 1 ] + offset[ 2 ] * axes[ k ][ 2 ];
+		}
+
+		const auto &a = extents;
+		const auto &b = arg.extents;
+
+		for( auto k = size_t{ 0 }; k < 3; ++k )
+		{
+			if( a[ k ] + ( b[ 0 ] * abs_r[ k ][ 0 ] + b[ 1 ] * abs_r[ k ][ 1 ] + b[ 2 ] * abs_r[ k ][ 2 ] ) < std::fabs( t[ k ] ) )
+			{
+				return false;
+			}
+		}
+
+		for( auto j = size_t{ 0 }; j < 3; ++j )
+		{
+			const auto distance = t[ 0 ] * r[ 0 ][ j ] + t[ 1 ] * r[ 1 ][ j ] + t[ 2 ] * r[ 2 ][ j ];
+
+			if( ( a[ 0 ] * abs_r[ 0 ][ j ] + a[ 1 ] * abs_r[ 1 ][ j ] + a[ 2 ] * abs_r[ 2 ][ j ] ) + b[ j ] < std::fabs( distance ) )
+			{
+				return false;
+			}
+		}
+
+		for( auto k = size_t{ 0 }; k < 3; ++k )
+		{
+			const auto k1 = ( k + 1 ) % 3;
+			const auto k2 = ( k + 2 ) % 3;
+
+			for( auto j = size_t{ 0 }; j < 3; ++j )
+			{
+				const auto j1 = ( j + 1 ) % 3;
+				const auto j2 = ( j + 2 ) % 3;
+
+				const auto ra       = a[ k1 ] * abs_r[ k2 ][ j ] + a[ k2 ] * abs_r[ k1 ][ j ];
+				const auto rb       = b[ j1 ] * abs_r[ k ][ j2 ] + b[ j2 ] * abs_r[ k ][ j1 ];
+				const auto distance = t[ k2 ] * r[ k1 ][ j ] - t[ k1 ] * r[ k2 ][ j ];
+
+				if( ra + rb < std::fabs( distance ) )
+				{
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+};
+
+/**
+ * Struct of arrays set of oriented boxes
+ */
+struct obb_batch_t
+{
+	public:
+	using v3 = vector_t<float>::v3;
+
+	//	============================================================================================
+
+	explicit obb_batch_t( std::pmr::memory_resource *resource = std::pmr::get_default_resource( ) )
+		: m_centers( resource ), m_extents( resource ), m_axes{ soa_batch_t<v3>{ resource }, soa_batch_t<v3>{ resource }, soa_batch_t<v3>{ resource } }
+	{
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	Operational methods
+	//	============================================================================================
+
+	/**
+	 * Add a box, index is the insertion order
+	 *
+	 * \param box
+	 */
+	auto add( const obb_t &box )->void
+	{
+		m_centers.push_back( box.center );
+		m_extents.push_back( box.extents );
+
+		for( auto k = size_t{ 0 }; k < 3; ++k )
+		{
+			m_axes[ k ].push_back( box.axes[ k ] );
+		}
+	}
+
+	auto get( const size_t i )const->obb_t
+	{
+		auto result = obb_t{ };
+
+		result.center  = m_centers.get( i );
+		result.extents = m_extents.get( i );
+		result.axes    = { m_axes[ 0 ].get( i ), m_axes[ 1 ].get( i ), m_axes[ 2 ].get( i ) };
+
+		return result;
+	}
+
+	auto get_size( )const->size_t
+	{
+		return m_centers.get_size( );
+	}
+
+	auto clear( )->void
+	{
+		m_centers.clear( );
+		m_extents.clear( );
+
+		for( auto &axis : m_axes )
+		{
+			axis.clear( );
+		}
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	Batched tests
+	//	hit / overlap gets 1 / 0 per box, indices the boxes hit in order,
+	//	leave either empty to skip it
+	//	============================================================================================
+
+	/**
+	 * One segment against every box
+	 *
+	 * \param start
+	 * \param delta
+	 * \param fractions	entry per box, 0 when starting inside and 1 on a miss
+	 * \param hit
+	 * \param indices
+	 * \return boxes hit
+	 */
+	auto intersect_ray( const v3 &start, const v3 &delta, std::span<float> fractions, std::span<uint8_t> hit = { },
+						std::span<uint32_t> indices = { } )const->size_t
+	{
+		const auto count = get_size( );
+
+		assert( fractions.size( ) >= count );
+		assert( hit.empty( ) || hit.size( ) >= count );
+		assert( indices.empty( ) || indices.size( ) >= count );
+
+		PACK_TIME( obb_ray );
+
+		const auto lanes  = get_lanes( );
+		const auto origin = start.get_contents( );
+		const auto move   = delta.get_contents( );
+
+		return get_kernels( ).ray_obbs( lanes.data( ), origin.data( ), move.data( ), fractions.data( ), hit.empty( ) ? nullptr : hit.data( ),
+										indices.empty( ) ? nullptr : indices.data( ), count );
+	}
+
+	/**
+	 * One box against every box
+	 *
+	 * \param box
+	 * \param overlap
+	 * \param indices
+	 * \return boxes overlapping
+	 */
+	auto intersect( const obb_t &box, std::span<uint8_t> overlap = { }, std::span<uint32_t> indices = { } )const->size_t
+	{
+		const auto count = get_size( );
+
+		assert( overlap.empty( ) || overlap.size( ) >= count );
+		assert( indices.empty( ) || indices.size( ) >= count );
+
+		PACK_TIME( obb_overlap );
+
+		const auto lanes    = get_lanes( );
+		const auto contents = box.get_contents( );
+
+		return get_kernels( ).overlap_obbs( lanes.data( ), contents.data( ), overlap.empty( ) ? nullptr : overlap.data( ),
+											indices.empty( ) ? nullptr : indices.data( ), count );
+	}
+
+	//	============================================================================================
+
+	private:
+	auto get_lanes( )const->std::array<const float *, obb_t::Lanes>
+	{
+		auto result = std::array<const float *, obb_t::Lanes>{ };
+
+		for( auto c = size_t{ 0 }; c < 3; ++c )
+		{
+			result[ c ]     = m_centers.lane( c );
+			result[ 3 + c ] = m_extents.lane( c );
+
+			for( auto k = size_t{ 0 }; k < 3; ++k )
+			{
+				result[ 6 + k * 3 + c ] = m_axes[ k ].lane( c );
+			}
+		}
+
+		return result;
+	}
+
+	soa_batch_t<v3> m_centers;
+	soa_batch_t<v3> m_extents;
+	std::array<soa_batch_t<v3>, 3> m_axes;
+};
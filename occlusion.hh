@@ -0,0 +1,404 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+#include "batch.hh"
+#include "dispatch.hh"
+#include "frustum.hh"
+#include "instrument.hh"
+#include "trace.hh"
+#include "vector.hh"
+
+//	============================================================================================
+//	Server side occlusion culling
+//
+//	Decides per tick which players each player could possibly see, everything else need
+//	not be transmitted. Three stages, each one only handing survivors to the next:
+//	a generous view frustum against target hulls, one ray to the hull point that was last
+//	seen, then rays to every other hull point. All rays of a stage go to the geometry as
+//	a single trace batch, a viewer's rays next to each other so geometry tracing packets
+//	of neighbouring segments, e.g. a built box_geometry_t, shares work between them.
+//
+//	Hidden pairs cost all of a hull's rays, the history is what keeps a tick cheap:
+//	visible pairs are trusted for a few ticks and try their last seen point first,
+//	hidden pairs between players that did not move are not traced again
+//	============================================================================================
+
+struct occlusion_params_t
+{
+	//	Wider than any client setting so turning within a tick is covered
+	float fov          = 120.F;
+	float aspect       = 16.F / 9.F;
+	float max_distance = 8192.F;
+
+	//	Standing player hull
+	vector_t<float>::v3 hull_mins = vector_t<float>::v3{ -16.F, -16.F, 0.F };
+	vector_t<float>::v3 hull_maxs = vector_t<float>::v3{ 16.F, 16.F, 72.F };
+
+	//	Grown on every side, covers a tick of movement and interpolation
+	float padding = 8.F;
+
+	//	A pair stays visible this many ticks after its last clear ray without tracing,
+	//	saves work and keeps models from popping at corners
+	uint32_t keep_ticks = 8;
+
+	//	Players moving less than this count as standing still, a hidden pair of two
+	//	players standing still stays hidden without tracing
+	float still_distance = 0.01F;
+};
+
+template <detail::geometry_t G>
+struct occlusion_culler_t
+{
+	public:
+	using v3 = vector_t<float>::v3;
+
+	//	Hull center first, then the 8 corners
+	constexpr static size_t Points = 9;
+
+	//	============================================================================================
+
+	explicit occlusion_culler_t( const G &geometry, const occlusion_params_t &params = { }, std::pmr::memory_resource *resource = std::pmr::get_default_resource( ) )
+		: m_geometry( geometry ), m_params( params ), m_last_visible( resource ), m_last_hidden( resource ), m_hint( resource ),
+		  m_last_eyes( resource ), m_last_origins( resource ), m_still( resource ), m_mins( resource ), m_maxs( resource ),
+		  m_points( resource ), m_candidates( resource ), m_start( resource ), m_end( resource ), m_normal( resource ), m_fraction( resource ),
+		  m_pair( resource ), m_point( resource ), m_resolved( resource )
+	{
+	}
+
+	//	============================================================================================
+
+	auto get_params( )const->const occlusion_params_t &
+	{
+		return m_params;
+	}
+
+	/**
+	 * Rays traced during the last update
+	 *
+	 * \return
+	 */
+	auto get_traces( )const->size_t
+	{
+		return m_traces;
+	}
+
+	/**
+	 * Forget all history, e.g. on round restart
+	 */
+	auto reset( )->void
+	{
+		m_last_visible.clear( );
+		m_last_hidden.clear( );
+		m_hint.clear( );
+		m_last_eyes.clear( );
+		m_last_origins.clear( );
+		m_tick = 0;
+	}
+
+	/**
+	 * Advance one tick and decide who can see whom
+	 * visible is viewer major, viewer v sees target t at v * players + t
+	 *
+	 * \param eyes		eye positions
+	 * \param angles	view angles
+	 * \param origins	hull origins
+	 * \param relevant	optional, viewer major, pairs to test, e.g. enemies only. Untested
+	 *					pairs and a player against itself come out visible
+	 * \param visible
+	 */
+	auto update( const soa_batch_t<v3> &eyes, const soa_batch_t<v3> &angles, const soa_batch_t<v3> &origins, std::span<const uint8_t> relevant,
+				 std::span<uint8_t> visible )->void
+	{
+		const auto players = origins.get_size( );
+		const auto pairs   = players * players;
+
+		assert( eyes.get_size( ) >= players );
+		assert( angles.get_size( ) >= players );
+		assert( relevant.empty( ) || relevant.size( ) >= pairs );
+		assert( visible.size( ) >= pairs );
+
+		PACK_TIME( occlusion_update );
+
+		++m_tick;
+		m_traces = 0;
+
+		if( m_last_visible.size( ) != pairs )
+		{
+			m_last_visible.assign( pairs, 0 );
+			m_last_hidden.assign( pairs, 0 );
+			m_hint.assign( pairs, 0 );
+		}
+
+		prepare( eyes, origins );
+		clear_rays( );
+
+		//	Frustum, then history, what is left gets a ray to its last seen point
+		for( auto v = size_t{ 0 }; v < players; ++v )
+		{
+			const auto eye     = eyes.get( v );
+			const auto frustum = frustum_t::from_angles( eye, angles.get( v ), m_params.fov, m_params.aspect, 0.F, m_params.max_distance );
+			const auto found   = frustum.cull_boxes( m_mins, m_maxs, { }, m_candidates );
+
+			for( auto t = size_t{ 0 }; t < players; ++t )
+			{
+				const auto pair = v * players + t;
+				visible[ pair ] = t == v || ( !relevant.empty( ) && relevant[ pair ] == 0 ) ? 1 : 0;
+			}
+
+			//	Room for every candidate, trimmed to the rays actually added
+			auto ray = m_pair.size( );
+			resize_rays( ray + found );
+
+			for( auto k = size_t{ 0 }; k < found; ++k )
+			{
+				const auto t    = static_cast<size_t>( m_candidates[ k ] );
+				const auto pair = v * players + t;
+
+				if( visible[ pair ] != 0 )
+				{
+					continue;
+				}
+
+				if( m_last_visible[ pair ] != 0 && m_tick - m_last_visible[ pair ] <= m_params.keep_ticks )
+				{
+					visible[ pair ] = 1;
+					continue;
+				}
+
+				if( m_last_hidden[ pair ] + 1 == m_tick && m_still[ v ] != 0 && m_still[ t ] != 0 )
+				{
+					m_last_hidden[ pair ] = m_tick;
+					continue;
+				}
+
+				set_ray( ray++, eye, pair, t, m_hint[ pair ] );
+			}
+
+			resize_rays( ray );
+		}
+
+		trace_rays( visible );
+
+		//	Hint hinted, try the rest of the hull. Every pair left gets the same number of
+		//	rays, so the ray lanes are sized once
+		const auto hinted = m_pair.size( );
+		const auto left   = hinted - static_cast<size_t>( std::count( m_resolved.begin( ), m_resolved.end( ), uint8_t{ 1 } ) );
+
+		resize_rays( hinted + left * ( Points - 1 ) );
+
+		auto ray = hinted;
+
+		for( auto r = size_t{ 0 }; r < hinted; ++r )
+		{
+			if( m_resolved[ r ] != 0 )
+			{
+				continue;
+			}
+
+			const auto pair = static_cast<size_t>( m_pair[ r ] );
+			const auto eye  = eyes.get( pair / players );
+
+			for( auto point = uint8_t{ 0 }; point < Points; ++point )
+			{
+				if( point != m_point[ r ] )
+				{
+					set_ray( ray++, eye, pair, pair % players, point );
+				}
+			}
+		}
+
+		//	The second batch sits behind the first in the ray lanes
+		trace_rays( visible, hinted );
+
+		for( auto r = size_t{ 0 }; r < hinted; ++r )
+		{
+			if( visible[ m_pair[ r ] ] == 0 )
+			{
+				m_last_hidden[ m_pair[ r ] ] = m_tick;
+			}
+		}
+	}
+
+	//	============================================================================================
+
+	private:
+	/**
+	 * Who stood still since the last tick, padded target hulls for the frustum and
+	 * their test points
+	 *
+	 * \param eyes
+	 * \param origins
+	 */
+	auto prepare( const soa_batch_t<v3> &eyes, const soa_batch_t<v3> &origins )->void
+	{
+		const auto players = origins.get_size( );
+
+		m_still.assign( players, 0 );
+
+		if( m_last_origins.get_size( ) == players )
+		{
+			const auto limit = m_params.still_distance * m_params.still_distance;
+
+			const auto moved = [ limit ]( const v3 &now, const v3 &last )
+			{
+				const auto delta = v3{ now[ 0 ] - last[ 0 ], now[ 1 ] - last[ 1 ], now[ 2 ] - last[ 2 ] };
+				return delta.get_dot( ) > limit;
+			};
+
+			for( auto i = size_t{ 0 }; i < players; ++i )
+			{
+				m_still[ i ] = moved( eyes.get( i ), m_last_eyes.get( i ) ) || moved( origins.get( i ), m_last_origins.get( i ) ) ? 0 : 1;
+			}
+		}
+
+		m_last_eyes.resize( players );
+		m_last_origins.resize( players );
+
+		for( auto i = size_t{ 0 }; i < players; ++i )
+		{
+			m_last_eyes.set( i, eyes.get( i ) );
+			m_last_origins.set( i, origins.get( i ) );
+		}
+
+		m_mins.resize( players );
+		m_maxs.resize( players );
+		m_points.resize( players * Points );
+		m_candidates.resize( players );
+
+		for( auto c = size_t{ 0 }; c < 3; ++c )
+		{
+			const auto low    = m_params.hull_mins[ c ] - m_params.padding;
+			const auto high   = m_params.hull_maxs[ c ] + m_params.padding;
+			const auto center = ( m_params.hull_mins[ c ] + m_params.hull_maxs[ c ] ) * 0.5F;
+
+			const auto *origin = origins.lane( c );
+			auto *mins         = m_mins.lane( c );
+			auto *maxs         = m_maxs.lane( c );
+			auto *points       = m_points.lane( c );
+
+			for( auto t = size_t{ 0 }; t < players; ++t )
+			{
+				mins[ t ] = origin[ t ] + low;
+				maxs[ t ] = origin[ t ] + high;
+			}
+
+			//	Corners sit on the unpadded hull, padding only widens the frustum test
+			for( auto t = size_t{ 0 }; t < players; ++t )
+			{
+				points[ t * Points ] = origin[ t ] + center;
+
+				for( auto corner = size_t{ 0 }; corner < 8; ++corner )
+				{
+					points[ t * Points + 1 + corner ] = origin[ t ] + ( ( corner >> c ) & 1U ? m_params.hull_maxs[ c ] : m_params.hull_mins[ c ] );
+				}
+			}
+		}
+	}
+
+	auto clear_rays( )->void
+	{
+		resize_rays( 0 );
+	}
+
+	auto resize_rays( const size_t count )->void
+	{
+		m_start.resize( count );
+		m_end.resize( count );
+		m_pair.resize( count );
+		m_point.resize( count );
+	}
+
+	auto set_ray( const size_t ray, const v3 &eye, const size_t pair, const size_t target, const uint8_t point )->void
+	{
+		m_start.set( ray, eye );
+		m_end.set( ray, m_points.get( target * Points + point ) );
+		m_pair[ ray ]  = static_cast<uint32_t>( pair );
+		m_point[ ray ] = point;
+	}
+
+	/**
+	 * Trace rays first onwards, a clear one makes its pair visible and becomes its hint
+	 *
+	 * \param visible
+	 * \param first
+	 */
+	auto trace_rays( std::span<uint8_t> visible, const size_t first = 0 )->void
+	{
+		const auto total = m_pair.size( );
+		const auto count = total - first;
+
+		m_resolved.resize( total );
+
+		if( count == 0 )
+		{
+			return;
+		}
+
+		m_normal.resize( count );
+		m_fraction.resize( count );
+		m_traces += count;
+
+		const auto start  = detail::get_lanes( m_start );
+		const auto end    = detail::get_lanes( m_end );
+		const auto normal = detail::get_lanes( m_normal );
+
+		m_geometry.trace( trace_batch_t{
+			{ start[ 0 ] + first, start[ 1 ] + first, start[ 2 ] + first },
+			{ end[ 0 ] + first, end[ 1 ] + first, end[ 2 ] + first },
+			m_fraction.data( ),
+			{ normal[ 0 ], normal[ 1 ], normal[ 2 ] },
+			count } );
+
+		for( auto r = size_t{ 0 }; r < count; ++r )
+		{
+			const auto pair  = m_pair[ first + r ];
+			const auto clear = m_fraction[ r ] >= 1.F;
+
+			m_resolved[ first + r ] = clear ? 1 : 0;
+
+			if( clear && visible[ pair ] == 0 )
+			{
+				visible[ pair ]        = 1;
+				m_last_visible[ pair ] = m_tick;
+				m_hint[ pair ]         = m_point[ first + r ];
+			}
+		}
+	}
+
+	const G &m_geometry;
+	occlusion_params_t m_params;
+
+	uint32_t m_tick = 0;
+	size_t m_traces = 0;
+
+	//	Per pair history
+	std::pmr::vector<uint32_t> m_last_visible;
+	std::pmr::vector<uint32_t> m_last_hidden;
+	std::pmr::vector<uint8_t> m_hint;
+
+	//	Per player
+	soa_batch_t<v3> m_last_eyes;
+	soa_batch_t<v3> m_last_origins;
+	std::pmr::vector<uint8_t> m_still;
+
+	//	Per target
+	soa_batch_t<v3> m_mins;
+	soa_batch_t<v3> m_maxs;
+	soa_batch_t<v3> m_points;
+	std::pmr::vector<uint32_t> m_candidates;
+
+	//	Per ray
+	soa_batch_t<v3> m_start;
+	soa_batch_t<v3> m_end;
+	soa_batch_t<v3> m_normal;
+	std::pmr::vector<float> m_fraction;
+	std::pmr::vector<uint32_t> m_pair;
+	std::pmr::vector<uint8_t> m_point;
+	std::pmr::vector<uint8_t> m_resolved;
+};
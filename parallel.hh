@@ -0,0 +1,398 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "batch.hh"
+#include "vector.hh"
+
+namespace detail
+{
+	constexpr auto CacheLine = size_t{ 64 };
+
+	/**
+	 * Chunk range still owned by a worker, begin in the low half and end in the high half
+	 * The owner eats from the front, thieves split off the back half
+	 */
+	struct alignas( CacheLine ) steal_range_t
+	{
+		std::atomic<uint64_t> bounds = 0;
+
+		static auto make( const uint32_t begin, const uint32_t end )->uint64_t
+		{
+			return uint64_t{ begin } | ( uint64_t{ end } << 32 );
+		}
+
+		static auto get_begin( const uint64_t bounds )->uint32_t
+		{
+			return static_cast<uint32_t>( bounds );
+		}
+
+		static auto get_end( const uint64_t bounds )->uint32_t
+		{
+			return static_cast<uint32_t>( bounds >> 32 );
+		}
+
+		/**
+		 * Chunks left, a snapshot that may be stale by the time it is used
+		 *
+		 * \return
+		 */
+		auto get_remaining( )const->uint32_t
+		{
+			const auto current = bounds.load( std::memory_order_relaxed );
+			return get_begin( current ) < get_end( current ) ? get_end( current ) - get_begin( current ) : 0;
+		}
+
+		/**
+		 * Owner side, take one chunk off the front
+		 *
+		 * \param chunk
+		 * \return
+		 */
+		auto pop( uint32_t &chunk )->bool
+		{
+			auto current = bounds.load( std::memory_order_relaxed );
+
+			while( get_begin( current ) < get_end( current ) )
+			{
+				if( bounds.compare_exchange_weak( current, make( get_begin( current ) + 1, get_end( current ) ), std::memory_order_relaxed ) )
+				{
+					chunk = get_begin( current );
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		/**
+		 * Thief side, take the back half ( at least one chunk )
+		 *
+		 * \param begin
+		 * \param end
+		 * \return
+		 */
+		auto steal( uint32_t &begin, uint32_t &end )->bool
+		{
+			auto current = bounds.load( std::memory_order_relaxed );
+
+			while( get_begin( current ) < get_end( current ) )
+			{
+				const auto remaining = get_end( current ) - get_begin( current );
+				const auto split     = get_end( current ) - std::max<uint32_t>( remaining / 2, 1 );
+
+				if( bounds.compare_exchange_weak( current, make( get_begin( current ), split ), std::memory_order_relaxed ) )
+				{
+					begin = split;
+					end   = get_end( current );
+					return true;
+				}
+			}
+
+			return false;
+		}
+	};
+}
+
+/**
+ * Elements per chunk for data touching bytes_per_element bytes per element
+ * Lands near a quarter of L1 and on a multiple of a cache line per lane
+ * for the smallest component, so chunk edges never share a line
+ *
+ * \param bytes_per_element
+ * \param component
+ * \return
+ */
+constexpr auto get_grain( const size_t bytes_per_element, const size_t component = sizeof( float ) )->size_t
+{
+	constexpr auto Budget = size_t{ 8 * 1024 };
+
+	const auto line  = std::max<size_t>( detail::CacheLine / component, 1 );
+	const auto count = std::max<size_t>( Budget / std::max<size_t>( bytes_per_element, 1 ), 1 );
+
+	return std::max( line, count / line * line );
+}
+
+/**
+ * Work stealing pool for batch kernels
+ *
+ * Every call splits the chunk space into one contiguous slice per worker,
+ * the same worker gets the same slice on every call so pages it first
+ * touched stay local without pinning anything to a node. Idle workers
+ * steal the back half of the fullest slice they find.
+ * The calling thread participates as worker 0.
+ */
+struct thread_pool_t
+{
+	public:
+	explicit thread_pool_t( const size_t threads = std::max( std::thread::hardware_concurrency( ), 1U ) )
+		: m_size( std::max<size_t>( threads, 1 ) ), m_ranges( new detail::steal_range_t[ m_size ] )
+	{
+		m_workers.reserve( m_size - 1 );
+
+		for( auto i = size_t{ 1 }; i < m_size; ++i )
+		{
+			m_workers.emplace_back( [ this, i ]( )
+			{
+				work( i );
+			} );
+		}
+	}
+
+	~thread_pool_t( )
+	{
+		{
+			const auto lock = std::lock_guard{ m_mutex };
+			m_stop          = true;
+		}
+
+		m_wake.notify_all( );
+
+		for( auto &worker : m_workers )
+		{
+			worker.join( );
+		}
+	}
+
+	thread_pool_t( const thread_pool_t & )                    = delete;
+	auto operator=( const thread_pool_t & )->thread_pool_t & = delete;
+
+	//	============================================================================================
+
+	/**
+	 * Workers including the calling thread
+	 *
+	 * \return
+	 */
+	auto get_size( )const->size_t
+	{
+		return m_size;
+	}
+
+	/**
+	 * Run fn( begin, end ) over [ 0, count ) in grain sized chunks and wait
+	 * fn must not throw and must not call back into the same pool
+	 *
+	 * \param count
+	 * \param grain
+	 * \param fn
+	 */
+	template <typename F>
+	auto parallel_for( const size_t count, const size_t grain, F &&fn )->void
+	{
+		if( count == 0 )
+		{
+			return;
+		}
+
+		const auto step   = std::max<size_t>( grain, 1 );
+		const auto chunks = ( count + step - 1 ) / step;
+
+		if( m_size == 1 || chunks == 1 )
+		{
+			fn( size_t{ 0 }, count );
+			return;
+		}
+
+		assert( chunks <= UINT32_MAX );
+
+		const auto lock = std::lock_guard{ m_submit };
+		auto body       = [ & ]( const size_t chunk )
+		{
+			const auto begin = chunk * step;
+			fn( begin, std::min( begin + step, count ) );
+		};
+
+		m_job = job_t{ &body, &invoke<decltype( body )> };
+
+		for( auto i = size_t{ 0 }; i < m_size; ++i )
+		{
+			const auto begin = static_cast<uint32_t>( chunks * i / m_size );
+			const auto end   = static_cast<uint32_t>( chunks * ( i + 1 ) / m_size );
+
+			m_ranges[ i ].bounds.store( detail::steal_range_t::make( begin, end ), std::memory_order_relaxed );
+		}
+
+		m_active.store( m_size - 1, std::memory_order_relaxed );
+
+		{
+			const auto wake = std::lock_guard{ m_mutex };
+			++m_generation;
+		}
+
+		m_wake.notify_all( );
+
+		run( 0 );
+
+		for( auto active = m_active.load( std::memory_order_acquire ); active != 0; active = m_active.load( std::memory_order_acquire ) )
+		{
+			m_active.wait( active, std::memory_order_acquire );
+		}
+	}
+
+	//	============================================================================================
+
+	private:
+	struct job_t
+	{
+		void *context                    = nullptr;
+		void ( *function )( void *, size_t ) = nullptr;
+	};
+
+	template <typename B>
+	static auto invoke( void *context, const size_t chunk )->void
+	{
+		( *static_cast<B *>( context ) )( chunk );
+	}
+
+	/**
+	 * Drain own slice, then steal until every slice is empty
+	 *
+	 * \param self
+	 */
+	auto run( const size_t self )->void
+	{
+		auto chunk = uint32_t{ };
+
+		while( m_ranges[ self ].pop( chunk ) )
+		{
+			m_job.function( m_job.context, chunk );
+		}
+
+		while( true )
+		{
+			//	Fullest slice, ties go to the nearest in ring order from self
+			auto victim  = m_size;
+			auto largest = uint32_t{ 0 };
+
+			for( auto offset = size_t{ 1 }; offset < m_size; ++offset )
+			{
+				const auto other     = ( self + offset ) % m_size;
+				const auto remaining = m_ranges[ other ].get_remaining( );
+
+				if( remaining > largest )
+				{
+					victim  = other;
+					largest = remaining;
+				}
+			}
+
+			if( victim == m_size )
+			{
+				return;
+			}
+
+			auto begin = uint32_t{ };
+			auto end   = uint32_t{ };
+
+			//	Drained since the scan, look again
+			if( !m_ranges[ victim ].steal( begin, end ) )
+			{
+				continue;
+			}
+
+			//	Publish the stolen tail as own slice so others can split it again
+			m_ranges[ self ].bounds.store( detail::steal_range_t::make( begin, end ), std::memory_order_relaxed );
+
+			while( m_ranges[ self ].pop( chunk ) )
+			{
+				m_job.function( m_job.context, chunk );
+			}
+		}
+	}
+
+	auto work( const size_t self )->void
+	{
+		auto seen = uint64_t{ 0 };
+
+		while( true )
+		{
+			{
+				auto lock = std::unique_lock{ m_mutex };
+				m_wake.wait( lock, [ & ]( )
+				{
+					return m_stop || m_generation != seen;
+				} );
+
+				if( m_stop )
+				{
+					return;
+				}
+
+				seen = m_generation;
+			}
+
+			run( self );
+
+			if( m_active.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+			{
+				m_active.notify_one( );
+			}
+		}
+	}
+
+	size_t m_size = 0;
+	std::unique_ptr<detail::steal_range_t[ ]> m_ranges;
+	std::vector<std::thread> m_workers;
+
+	job_t m_job;
+	std::mutex m_submit;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	uint64_t m_generation = 0;
+	bool m_stop           = false;
+
+	alignas( detail::CacheLine ) std::atomic<size_t> m_active = 0;
+};
+
+//	============================================================================================
+//	Batch helpers
+//	============================================================================================
+
+/**
+ * Apply fn( pack & ) to every pack of an array of structs batch
+ *
+ * \param pool
+ * \param batch
+ * \param fn
+ */
+template <detail::pack_t P, typename F>
+auto parallel_for_each( thread_pool_t &pool, std::span<P> batch, F &&fn )->void
+{
+	pool.parallel_for( batch.size( ), get_grain( sizeof( P ), sizeof( typename P::Type ) ), [ & ]( const size_t begin, const size_t end )
+	{
+		for( auto i = begin; i < end; ++i )
+		{
+			fn( batch[ i ] );
+		}
+	} );
+}
+
+/**
+ * Apply fn( batch, begin, end ) over blocks of a struct of arrays batch,
+ * fn reads and writes lanes directly
+ *
+ * \param pool
+ * \param batch
+ * \param fn
+ */
+template <detail::pack_t P, typename F>
+auto parallel_for_each( thread_pool_t &pool, soa_batch_t<P> &batch, F &&fn )->void
+{
+	using T = typename P::Type;
+
+	pool.parallel_for( batch.get_size( ), get_grain( sizeof( T ) * P::Len, sizeof( T ) ), [ & ]( const size_t begin, const size_t end )
+	{
+		fn( batch, begin, end );
+	} );
+}
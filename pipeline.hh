@@ -0,0 +1,306 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <span>
+#include <tuple>
+#include <utility>
+#include "algorithm.hh"
+#include "batch.hh"
+#include "parallel.hh"
+#include "vector.hh"
+
+//	============================================================================================
+//	Fused batch pipelines
+//
+//	Stages are collected lazily and only run by run( ), as one loop per L1 sized block with
+//	every stage applied to an element while it is still in registers, e.g.
+//
+//		const auto aim = make_pipeline<v3>( ).subtract( eye ).get_angle( ).normalize_angle( ).clamp_angle( ).delta_angle( view );
+//		aim.run( positions, deltas );
+//
+//	leaves in deltas the pitch / yaw turn from view to aim at each position from eye
+//	============================================================================================
+
+namespace stages
+{
+	template <detail::pack_t P>
+	struct subtract_t
+	{
+		P origin;
+
+		auto operator( )( P &p )const noexcept->void
+		{
+			for( auto c = size_t{ 0 }; c < P::Len; ++c )
+			{
+				p[ c ] -= origin[ c ];
+			}
+		}
+	};
+
+	/**
+	 * Wrapped angular distance from view to the incoming angles
+	 */
+	template <detail::pack_t P>
+	struct delta_angle_t
+	{
+		P view;
+
+		auto operator( )( P &p )const noexcept->void
+		{
+			for( auto c = size_t{ 0 }; c < P::Len; ++c )
+			{
+				p[ c ] -= view[ c ];
+			}
+
+			ops::normalize_angle( p );
+		}
+	};
+
+	/**
+	 * Pitch / yaw looking along the incoming direction, see ops::get_angle
+	 */
+	struct get_angle_t
+	{
+		template <detail::pack_t P>
+		auto operator( )( P &p )const noexcept->void
+		{
+			p = ops::get_angle( p );
+		}
+	};
+
+	template <typename F>
+	struct map_t
+	{
+		F function;
+
+		template <detail::pack_t P>
+		auto operator( )( P &p )const noexcept->void
+		{
+			function( p );
+		}
+	};
+}
+
+template <detail::pack_t P, typename... Stages>
+struct pipeline_t
+{
+	public:
+	using Type                  = typename P::Type;
+	constexpr static size_t Len = P::Len;
+
+	//	Input and output block share half of a 32KB L1, in whole cache lines
+	constexpr static size_t Block = std::max<size_t>( 16 * 1024 / ( sizeof( Type ) * Len * 2 ) / 64 * 64, 64 );
+
+	//	============================================================================================
+
+	pipeline_t( ) = default;
+
+	explicit pipeline_t( std::tuple<Stages...> stages ) : m_stages( std::move( stages ) )
+	{
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	Builder
+	//	Each call returns a longer pipeline, nothing is evaluated
+	//	============================================================================================
+
+	template <typename S>
+	auto then( S stage )const->pipeline_t<P, Stages..., S>
+	{
+		return pipeline_t<P, Stages..., S>{ std::tuple_cat( m_stages, std::tuple<S>{ std::move( stage ) } ) };
+	}
+
+	auto subtract( const P &origin )const
+	{
+		return then( stages::subtract_t<P>{ origin } );
+	}
+
+	auto get_angle( )const
+	{
+		return then( stages::get_angle_t{ } );
+	}
+
+	auto normalize_angle( )const
+	{
+		return then( ops::normalize_angle );
+	}
+
+	auto normalize_length( )const
+	{
+		return then( ops::normalize_length );
+	}
+
+	auto clamp_angle( )const
+	{
+		return then( ops::clamp_angle );
+	}
+
+	auto delta_angle( const P &view )const
+	{
+		return then( stages::delta_angle_t<P>{ view } );
+	}
+
+	/**
+	 * Custom stage, f( P & ) must not throw
+	 *
+	 * \param f
+	 * \return
+	 */
+	template <typename F>
+	auto map( F f )const
+	{
+		return then( stages::map_t<F>{ std::move( f ) } );
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	Evaluation
+	//	source and destination may be the same batch
+	//	============================================================================================
+
+	/**
+	 * Run every stage over source into destination
+	 *
+	 * \param source
+	 * \param destination
+	 */
+	auto run( const soa_batch_t<P> &source, soa_batch_t<P> &destination )const->void
+	{
+		destination.resize( source.get_size( ) );
+
+		for( auto begin = size_t{ 0 }; begin < source.get_size( ); begin += Block )
+		{
+			run_block( source, destination, begin, std::min( begin + Block, source.get_size( ) ) );
+		}
+	}
+
+	/**
+	 * Run every stage and keep only the length of the result,
+	 * e.g. field of view distance after delta_angle
+	 *
+	 * \param source
+	 * \param destination
+	 */
+	auto run( const soa_batch_t<P> &source, std::span<Type> destination )const->void
+	{
+		assert( destination.size( ) >= source.get_size( ) );
+
+		for( auto begin = size_t{ 0 }; begin < source.get_size( ); begin += Block )
+		{
+			run_block( source, destination, begin, std::min( begin + Block, source.get_size( ) ) );
+		}
+	}
+
+	/**
+	 * Same as run, blocks spread over a pool
+	 *
+	 * \param pool
+	 * \param source
+	 * \param destination
+	 */
+	template <typename D>
+	auto run( thread_pool_t &pool, const soa_batch_t<P> &source, D &&destination )const->void
+	{
+		if constexpr( std::is_same_v<std::remove_cvref_t<D>, soa_batch_t<P>> )
+		{
+			destination.resize( source.get_size( ) );
+		}
+		else
+		{
+			assert( std::size( destination ) >= source.get_size( ) );
+		}
+
+		pool.parallel_for( source.get_size( ), Block, [ & ]( const size_t begin, const size_t end )
+		{
+			if constexpr( std::is_same_v<std::remove_cvref_t<D>, soa_batch_t<P>> )
+			{
+				run_block( source, destination, begin, end );
+			}
+			else
+			{
+				run_block( source, std::span<Type>{ destination }, begin, end );
+			}
+		} );
+	}
+
+	//	============================================================================================
+
+	private:
+	auto apply( P &p )const noexcept->void
+	{
+		std::apply( [ & ]( const auto &...stage )
+		{
+			( stage( p ), ... );
+		}, m_stages );
+	}
+
+	auto run_block( const soa_batch_t<P> &source, soa_batch_t<P> &destination, const size_t begin, const size_t end )const->void
+	{
+		const Type *input[ Len ];
+		Type *output[ Len ];
+
+		for( auto c = size_t{ 0 }; c < Len; ++c )
+		{
+			input[ c ]  = source.lane( c );
+			output[ c ] = destination.lane( c );
+		}
+
+		for( auto i = begin; i < end; ++i )
+		{
+			auto p = P{ };
+
+			for( auto c = size_t{ 0 }; c < Len; ++c )
+			{
+				p[ c ] = input[ c ][ i ];
+			}
+
+			apply( p );
+
+			for( auto c = size_t{ 0 }; c < Len; ++c )
+			{
+				output[ c ][ i ] = p[ c ];
+			}
+		}
+	}
+
+	auto run_block( const soa_batch_t<P> &source, std::span<Type> destination, const size_t begin, const size_t end )const->void
+	{
+		const Type *input[ Len ];
+
+		for( auto c = size_t{ 0 }; c < Len; ++c )
+		{
+			input[ c ] = source.lane( c );
+		}
+
+		for( auto i = begin; i < end; ++i )
+		{
+			auto p = P{ };
+
+			for( auto c = size_t{ 0 }; c < Len; ++c )
+			{
+				p[ c ] = input[ c ][ i ];
+			}
+
+			apply( p );
+
+			destination[ i ] = ops::get_length( p );
+		}
+	}
+
+	std::tuple<Stages...> m_stages;
+};
+
+/**
+ * Empty pipeline to build on
+ *
+ * \return
+ */
+template <detail::pack_t P>
+auto make_pipeline( )->pipeline_t<P>
+{
+	return pipeline_t<P>{ };
+}
@@ -0,0 +1,278 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "instrument.hh"
+#include "parallel.hh"
+
+//	============================================================================================
+//	Stage queues
+//
+//	Bounded lock-free rings between pipeline threads. They carry handles, e.g. a
+//	std::unique_ptr<soa_batch_t<v3>> or an index into a pool of batches, so a batch changes
+//	hands without its contents being touched. Producer and consumer indices live on their
+//	own cache lines, next to a cached copy of the other side's index so the shared lines
+//	are only read when the ring looks full or empty. Both are try_ only, a stage spins,
+//	yields or parks as it sees fit
+//	============================================================================================
+
+namespace detail
+{
+	template <typename T>
+	concept handle_t = std::is_default_constructible_v<T> && std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>;
+
+	inline auto get_ring_size( const size_t capacity )->size_t
+	{
+		return std::bit_ceil( std::max<size_t>( capacity, 2 ) );
+	}
+
+	/**
+	 * Head first, it never passes tail, so a consumer moving in between can only make the
+	 * result stale and never wrap it. A producer moving in between can push it past the
+	 * capacity, hence the clamp
+	 */
+	inline auto get_ring_used( const std::atomic<size_t> &head, const std::atomic<size_t> &tail, const size_t mask )->size_t
+	{
+		const auto first = head.load( std::memory_order_acquire );
+		const auto last  = tail.load( std::memory_order_acquire );
+
+		return std::min( last - first, mask + 1 );
+	}
+}
+
+/**
+ * One producer thread, one consumer thread
+ */
+template <detail::handle_t T>
+struct spsc_queue_t
+{
+	public:
+	/**
+	 * \param capacity	rounded up to a power of two
+	 */
+	explicit spsc_queue_t( const size_t capacity )
+		: m_mask( detail::get_ring_size( capacity ) - 1 ), m_slots( std::make_unique<T[ ]>( m_mask + 1 ) )
+	{
+	}
+
+	spsc_queue_t( const spsc_queue_t & )                    = delete;
+	auto operator=( const spsc_queue_t & )->spsc_queue_t & = delete;
+
+	//	============================================================================================
+
+	auto get_capacity( )const->size_t
+	{
+		return m_mask + 1;
+	}
+
+	/**
+	 * Exact only while neither side is running
+	 *
+	 * \return
+	 */
+	auto get_size( )const->size_t
+	{
+		return detail::get_ring_used( m_head, m_tail, m_mask );
+	}
+
+	/**
+	 * Producer side
+	 *
+	 * \param value	moved from only on success
+	 * \return false when full
+	 */
+	auto try_push( T &&value )->bool
+	{
+		const auto tail = m_tail.load( std::memory_order_relaxed );
+
+		if( tail - m_cached_head > m_mask )
+		{
+			m_cached_head = m_head.load( std::memory_order_acquire );
+
+			if( tail - m_cached_head > m_mask )
+			{
+				PACK_COUNT( queue_full );
+				return false;
+			}
+		}
+
+		m_slots[ tail & m_mask ] = std::move( value );
+		m_tail.store( tail + 1, std::memory_order_release );
+
+		return true;
+	}
+
+	/**
+	 * Consumer side
+	 *
+	 * \param value
+	 * \return false when empty
+	 */
+	auto try_pop( T &value )->bool
+	{
+		const auto head = m_head.load( std::memory_order_relaxed );
+
+		if( head == m_cached_tail )
+		{
+			m_cached_tail = m_tail.load( std::memory_order_acquire );
+
+			if( head == m_cached_tail )
+			{
+				return false;
+			}
+		}
+
+		value = std::move( m_slots[ head & m_mask ] );
+		m_head.store( head + 1, std::memory_order_release );
+
+		return true;
+	}
+
+	//	============================================================================================
+
+	private:
+	//	Read only after construction
+	const size_t m_mask;
+	const std::unique_ptr<T[ ]> m_slots;
+
+	//	Producer line
+	alignas( detail::CacheLine ) std::atomic<size_t> m_tail = 0;
+	size_t m_cached_head                                    = 0;
+
+	//	Consumer line
+	alignas( detail::CacheLine ) std::atomic<size_t> m_head = 0;
+	size_t m_cached_tail                                    = 0;
+};
+
+/**
+ * Any number of producer threads, one consumer thread. Every slot carries a sequence
+ * number telling whose turn it is, producers claim slots with a compare exchange on the
+ * tail and publish them out of order, the consumer takes them in claim order
+ */
+template <detail::handle_t T>
+struct mpsc_queue_t
+{
+	public:
+	/**
+	 * \param capacity	rounded up to a power of two
+	 */
+	explicit mpsc_queue_t( const size_t capacity )
+		: m_mask( detail::get_ring_size( capacity ) - 1 ), m_slots( std::make_unique<slot_t[ ]>( m_mask + 1 ) )
+	{
+		for( auto i = size_t{ 0 }; i <= m_mask; ++i )
+		{
+			m_slots[ i ].sequence.store( i, std::memory_order_relaxed );
+		}
+	}
+
+	mpsc_queue_t( const mpsc_queue_t & )                    = delete;
+	auto operator=( const mpsc_queue_t & )->mpsc_queue_t & = delete;
+
+	//	============================================================================================
+
+	auto get_capacity( )const->size_t
+	{
+		return m_mask + 1;
+	}
+
+	/**
+	 * Claimed slots, including ones still being written. Exact only while nobody is running
+	 *
+	 * \return
+	 */
+	auto get_size( )const->size_t
+	{
+		return detail::get_ring_used( m_head, m_tail, m_mask );
+	}
+
+	/**
+	 * Producer side, any thread
+	 *
+	 * \param value	moved from only on success
+	 * \return false when full
+	 */
+	auto try_push( T &&value )->bool
+	{
+		auto tail = m_tail.load( std::memory_order_relaxed );
+
+		while( true )
+		{
+			auto &slot          = m_slots[ tail & m_mask ];
+			const auto sequence = slot.sequence.load( std::memory_order_acquire );
+			const auto lag      = static_cast<std::ptrdiff_t>( sequence - tail );
+
+			if( lag == 0 )
+			{
+				if( m_tail.compare_exchange_weak( tail, tail + 1, std::memory_order_relaxed ) )
+				{
+					slot.value = std::move( value );
+					slot.sequence.store( tail + 1, std::memory_order_release );
+
+					return true;
+				}
+			}
+			else if( lag < 0 )
+			{
+				//	Consumer has not freed this slot from the previous lap
+				PACK_COUNT( queue_full );
+				return false;
+			}
+			else
+			{
+				//	Another producer claimed it first
+				tail = m_tail.load( std::memory_order_relaxed );
+			}
+		}
+	}
+
+	/**
+	 * Consumer side
+	 *
+	 * \param value
+	 * \return false when empty or the next slot is claimed but not written yet
+	 */
+	auto try_pop( T &value )->bool
+	{
+		const auto head = m_head.load( std::memory_order_relaxed );
+		auto &slot      = m_slots[ head & m_mask ];
+
+		if( slot.sequence.load( std::memory_order_acquire ) != head + 1 )
+		{
+			return false;
+		}
+
+		value = std::move( slot.value );
+
+		//	Free for the producer one lap ahead. Release on head so get_size( ) reading it
+		//	also sees the tail claim behind this slot
+		slot.sequence.store( head + m_mask + 1, std::memory_order_release );
+		m_head.store( head + 1, std::memory_order_release );
+
+		return true;
+	}
+
+	//	============================================================================================
+
+	private:
+	struct slot_t
+	{
+		std::atomic<size_t> sequence = 0;
+		T value                      = T{ };
+	};
+
+	//	Read only after construction
+	const size_t m_mask;
+	const std::unique_ptr<slot_t[ ]> m_slots;
+
+	//	Producers' line
+	alignas( detail::CacheLine ) std::atomic<size_t> m_tail = 0;
+
+	//	Consumer line
+	alignas( detail::CacheLine ) std::atomic<size_t> m_head = 0;
+};
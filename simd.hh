@@ -0,0 +1,38 @@
+#pragma once
+
+//	============================================================================================
+//	Instruction set availability
+//	What the translation unit is compiled for, runtime selection lives in dispatch.hh
+//	============================================================================================
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __x86_64__ ) || defined( __i386__ )
+#include <immintrin.h>
+
+//	Runtime dispatched variants are built whenever the target is x86
+#define PACK_X86 1
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define PACK_SSE2 1
+#endif
+
+#if defined( __AVX2__ )
+#define PACK_AVX2 1
+#endif
+
+//	MSVC has no F16C switch, /arch:AVX2 implies it
+#if defined( __F16C__ ) || ( defined( _MSC_VER ) && defined( __AVX2__ ) )
+#define PACK_F16C 1
+#endif
+
+#if defined( __AVX512F__ )
+#define PACK_AVX512 1
+#endif
+#endif
+
+#if defined( PACK_NO_SIMD )
+#undef PACK_X86
+#undef PACK_SSE2
+#undef PACK_AVX2
+#undef PACK_F16C
+#undef PACK_AVX512
+#endif
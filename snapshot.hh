@@ -0,0 +1,217 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <tuple>
+#include <utility>
+#include "batch.hh"
+#include "instrument.hh"
+#include "parallel.hh"
+#include "vector.hh"
+
+//	============================================================================================
+//	Snapshot publication
+//
+//	One writer hands whole batches to any number of readers without either side taking
+//	a lock. Two slots, each behind a sequence counter: the writer fills the slot readers
+//	are not looking at and then flips the version, a reader copies the latest slot and
+//	retries only if the writer came round to that same slot mid copy. The writer never
+//	looks at readers, so its cost does not grow with them
+//	============================================================================================
+
+namespace detail
+{
+	//	Slot contents are read while they may be written, relaxed atomics keep that defined.
+	//	On x86 these are plain moves
+
+	template <typename T>
+	auto store_relaxed( T *destination, const T *source, const size_t count )->void
+	{
+		for( auto i = size_t{ 0 }; i < count; ++i )
+		{
+			std::atomic_ref<T>{ destination[ i ] }.store( source[ i ], std::memory_order_relaxed );
+		}
+	}
+
+	template <typename T>
+	auto load_relaxed( T *destination, const T *source, const size_t count )->void
+	{
+		for( auto i = size_t{ 0 }; i < count; ++i )
+		{
+			destination[ i ] = std::atomic_ref<T>{ const_cast<T &>( source[ i ] ) }.load( std::memory_order_relaxed );
+		}
+	}
+}
+
+/**
+ * Publishes one struct of arrays batch per pack type together, e.g. positions and angles,
+ * readers always see batches from the same publish
+ */
+template <detail::pack_t... P>
+	requires( sizeof...( P ) > 0 )
+struct snapshot_publisher_t
+{
+	public:
+	//	============================================================================================
+
+	/**
+	 * \param capacity	most elements a publish may carry, slots never grow so readers never see them move
+	 * \param resource
+	 */
+	explicit snapshot_publisher_t( const size_t capacity, std::pmr::memory_resource *resource = std::pmr::get_default_resource( ) )
+		: m_capacity( capacity ), m_slots{ slot_t{ capacity, resource }, slot_t{ capacity, resource } }
+	{
+	}
+
+	snapshot_publisher_t( const snapshot_publisher_t & )                    = delete;
+	auto operator=( const snapshot_publisher_t & )->snapshot_publisher_t & = delete;
+
+	//	============================================================================================
+
+	auto get_capacity( )const->size_t
+	{
+		return m_capacity;
+	}
+
+	/**
+	 * Publishes so far, 0 before the first
+	 *
+	 * \return
+	 */
+	auto get_version( )const->uint64_t
+	{
+		return m_version.load( std::memory_order_acquire );
+	}
+
+	/**
+	 * Writer side, one thread only. Batches must have the same size
+	 *
+	 * \param batches
+	 */
+	auto publish( const soa_batch_t<P> &...batches )->void
+	{
+		const auto size = std::get<0>( std::tie( batches... ) ).get_size( );
+
+		assert( ( ( batches.get_size( ) == size ) && ... ) );
+		assert( size <= m_capacity );
+
+		PACK_TIME( snapshot_publish );
+
+		//	The slot after the published one, readers only land on it once it is published
+		const auto version  = m_version.load( std::memory_order_relaxed ) + 1;
+		auto &slot          = m_slots[ version & 1U ];
+		const auto sequence = slot.sequence.load( std::memory_order_relaxed );
+
+		//	Odd while writing, the fence keeps the contents below from moving above it
+		slot.sequence.store( sequence + 1, std::memory_order_relaxed );
+		std::atomic_thread_fence( std::memory_order_release );
+
+		copy_in( slot, size, std::index_sequence_for<P...>{ }, batches... );
+		slot.size.store( size, std::memory_order_relaxed );
+		slot.version.store( version, std::memory_order_relaxed );
+
+		//	Version first, a reader that copied this slot must not then find the older
+		//	version and read back in time. One that follows the new version here finds the
+		//	slot still odd and retries until the store below
+		m_version.store( version, std::memory_order_release );
+		slot.sequence.store( sequence + 2, std::memory_order_release );
+	}
+
+	/**
+	 * Reader side, any number of threads. Copies the latest snapshot, batches are resized
+	 * to it and left alone before the first publish
+	 *
+	 * \param batches
+	 * \return version read, 0 when nothing was published yet
+	 */
+	auto read( soa_batch_t<P> &...batches )const->uint64_t
+	{
+		PACK_TIME( snapshot_read );
+
+		while( true )
+		{
+			const auto version = m_version.load( std::memory_order_acquire );
+
+			if( version == 0 )
+			{
+				return 0;
+			}
+
+			const auto &slot  = m_slots[ version & 1U ];
+			const auto before = slot.sequence.load( std::memory_order_acquire );
+
+			//	Not being rewritten, copy and check it still was not afterwards
+			if( ( before & 1U ) == 0 )
+			{
+				const auto size = slot.size.load( std::memory_order_relaxed );
+
+				( batches.resize( size ), ... );
+				copy_out( slot, size, std::index_sequence_for<P...>{ }, batches... );
+
+				//	May be newer than version if the writer lapped the slot in between
+				const auto copied = slot.version.load( std::memory_order_relaxed );
+
+				std::atomic_thread_fence( std::memory_order_acquire );
+
+				if( slot.sequence.load( std::memory_order_relaxed ) == before )
+				{
+					return copied;
+				}
+			}
+
+			PACK_COUNT( snapshot_retry );
+		}
+	}
+
+	//	============================================================================================
+
+	private:
+	struct alignas( detail::CacheLine ) slot_t
+	{
+		explicit slot_t( const size_t capacity, std::pmr::memory_resource *resource ) : batches( soa_batch_t<P>( capacity, resource )... )
+		{
+		}
+
+		std::atomic<uint64_t> sequence = 0;
+		std::atomic<uint64_t> version  = 0;
+		std::atomic<size_t> size       = 0;
+		std::tuple<soa_batch_t<P>...> batches;
+	};
+
+	template <size_t... I>
+	static auto copy_in( slot_t &slot, const size_t size, std::index_sequence<I...>, const soa_batch_t<P> &...batches )->void
+	{
+		const auto copy = [ size ]<detail::pack_t Q>( soa_batch_t<Q> &destination, const soa_batch_t<Q> &source )
+		{
+			for( auto c = size_t{ 0 }; c < Q::Len; ++c )
+			{
+				detail::store_relaxed( destination.lane( c ), source.lane( c ), size );
+			}
+		};
+
+		( copy( std::get<I>( slot.batches ), batches ), ... );
+	}
+
+	template <size_t... I>
+	static auto copy_out( const slot_t &slot, const size_t size, std::index_sequence<I...>, soa_batch_t<P> &...batches )->void
+	{
+		const auto copy = [ size ]<detail::pack_t Q>( soa_batch_t<Q> &destination, const soa_batch_t<Q> &source )
+		{
+			for( auto c = size_t{ 0 }; c < Q::Len; ++c )
+			{
+				detail::load_relaxed( destination.lane( c ), source.lane( c ), size );
+			}
+		};
+
+		( copy( batches, std::get<I>( slot.batches ) ), ... );
+	}
+
+	size_t m_capacity;
+	std::array<slot_t, 2> m_slots;
+
+	alignas( detail::CacheLine ) std::atomic<uint64_t> m_version = 0;
+};
@@ -0,0 +1,412 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include "instrument.hh"
+#include "simd.hh"
+#include "vector.hh"
+
+namespace detail
+{
+	//	============================================================================================
+	//	Scalar conversions
+	//	============================================================================================
+
+	/**
+	 * IEEE binary16 narrowing, round to nearest even
+	 * Matches what F16C produces so tails agree with SIMD bodies
+	 *
+	 * \param value
+	 * \return
+	 */
+	inline auto float_to_half( const float value )->uint16_t
+	{
+		constexpr auto Infinity  = uint32_t{ 255 } << 23;
+		constexpr auto Maximum   = uint32_t{ 127 + 16 } << 23;
+		constexpr auto Denormal  = uint32_t{ ( 127 - 15 ) + ( 23 - 10 ) + 1 } << 23;
+		constexpr auto Subnormal = uint32_t{ 113 } << 23;
+
+		auto bits       = std::bit_cast<uint32_t>( value );
+		const auto sign = bits & 0x80000000U;
+		auto result     = uint32_t{ };
+
+		bits ^= sign;
+
+		if( bits >= Maximum )
+		{
+			result = bits > Infinity ? 0x7E00U : 0x7C00U;
+		}
+		else if( bits < Subnormal )
+		{
+			result = std::bit_cast<uint32_t>( std::bit_cast<float>( bits ) + std::bit_cast<float>( Denormal ) ) - Denormal;
+		}
+		else
+		{
+			const auto odd = ( bits >> 13 ) & 1U;
+
+			bits += ( uint32_t( 15 - 127 ) << 23 ) + 0xFFFU + odd;
+			result = bits >> 13;
+		}
+
+		return static_cast<uint16_t>( result | ( sign >> 16 ) );
+	}
+
+	/**
+	 * IEEE binary16 widening, exact
+	 *
+	 * \param half
+	 * \return
+	 */
+	inline auto half_to_float( const uint16_t half )->float
+	{
+		constexpr auto Exponent = uint32_t{ 0x7C00 } << 13;
+		constexpr auto Magic    = uint32_t{ 113 } << 23;
+
+		auto bits            = uint32_t{ half & 0x7FFFU } << 13;
+		const auto exponent  = bits & Exponent;
+
+		bits += uint32_t{ 127 - 15 } << 23;
+
+		if( exponent == Exponent )
+		{
+			bits += uint32_t{ 128 - 16 } << 23;
+		}
+		else if( exponent == 0 )
+		{
+			bits += uint32_t{ 1 } << 23;
+			bits = std::bit_cast<uint32_t>( std::bit_cast<float>( bits ) - std::bit_cast<float>( Magic ) );
+		}
+
+		return std::bit_cast<float>( bits | ( uint32_t{ half & 0x8000U } << 16 ) );
+	}
+
+	/**
+	 * Fixed point narrowing, saturating, NaN maps to the lower bound
+	 *
+	 * \param value
+	 * \param inverse_scale
+	 * \return
+	 */
+	inline auto float_to_fixed( const float value, const float inverse_scale )->int16_t
+	{
+		auto scaled = value * inverse_scale;
+
+		scaled = scaled > -32768.F ? scaled : -32768.F;
+		scaled = scaled < 32767.F ? scaled : 32767.F;
+
+		return static_cast<int16_t>( std::nearbyint( scaled ) );
+	}
+
+	inline auto fixed_to_float( const int16_t value, const float scale )->float
+	{
+		return static_cast<float>( value ) * scale;
+	}
+
+	//	============================================================================================
+	//	Batched conversions over flat component streams
+	//	============================================================================================
+
+	inline auto narrow_half( const float *source, uint16_t *destination, const size_t count )->void
+	{
+		auto i = size_t{ 0 };
+
+#if defined( PACK_F16C )
+		for( ; i + 8 <= count; i += 8 )
+		{
+			const auto half = _mm256_cvtps_ph( _mm256_loadu_ps( source + i ), _MM_FROUND_TO_NEAREST_INT );
+			_mm_storeu_si128( reinterpret_cast<__m128i *>( destination + i ), half );
+		}
+#endif
+
+		for( ; i < count; ++i )
+		{
+			destination[ i ] = float_to_half( source[ i ] );
+		}
+	}
+
+	inline auto widen_half( const uint16_t *source, float *destination, const size_t count )->void
+	{
+		auto i = size_t{ 0 };
+
+#if defined( PACK_F16C )
+		for( ; i + 8 <= count; i += 8 )
+		{
+			const auto half = _mm_loadu_si128( reinterpret_cast<const __m128i *>( source + i ) );
+			_mm256_storeu_ps( destination + i, _mm256_cvtph_ps( half ) );
+		}
+#endif
+
+		for( ; i < count; ++i )
+		{
+			destination[ i ] = half_to_float( source[ i ] );
+		}
+	}
+
+	/**
+	 * Takes the inverse scale itself, 1 / ( 1 / Units ) is not always Units in float
+	 * and would round some values one step away from float_to_fixed
+	 */
+	inline auto narrow_fixed( const float *source, int16_t *destination, const size_t count, const float inverse_scale )->void
+	{
+		auto i = size_t{ 0 };
+
+#if defined( PACK_SSE2 )
+		const auto inverse = _mm_set1_ps( inverse_scale );
+		const auto lower   = _mm_set1_ps( -32768.F );
+		const auto upper   = _mm_set1_ps( 32767.F );
+
+		for( ; i + 8 <= count; i += 8 )
+		{
+			const auto low  = _mm_min_ps( _mm_max_ps( _mm_mul_ps( _mm_loadu_ps( source + i ), inverse ), lower ), upper );
+			const auto high = _mm_min_ps( _mm_max_ps( _mm_mul_ps( _mm_loadu_ps( source + i + 4 ), inverse ), lower ), upper );
+
+			const auto packed = _mm_packs_epi32( _mm_cvtps_epi32( low ), _mm_cvtps_epi32( high ) );
+			_mm_storeu_si128( reinterpret_cast<__m128i *>( destination + i ), packed );
+		}
+#endif
+
+		for( ; i < count; ++i )
+		{
+			destination[ i ] = float_to_fixed( source[ i ], inverse_scale );
+		}
+	}
+
+	inline auto widen_fixed( const int16_t *source, float *destination, const size_t count, const float scale )->void
+	{
+		auto i = size_t{ 0 };
+
+#if defined( PACK_SSE2 )
+		const auto factor = _mm_set1_ps( scale );
+
+		for( ; i + 8 <= count; i += 8 )
+		{
+			const auto packed = _mm_loadu_si128( reinterpret_cast<const __m128i *>( source + i ) );
+
+			//	Sign extend by parking each word in the upper half and shifting back
+			const auto low  = _mm_srai_epi32( _mm_unpacklo_epi16( packed, packed ), 16 );
+			const auto high = _mm_srai_epi32( _mm_unpackhi_epi16( packed, packed ), 16 );
+
+			_mm_storeu_ps( destination + i, _mm_mul_ps( _mm_cvtepi32_ps( low ), factor ) );
+			_mm_storeu_ps( destination + i + 4, _mm_mul_ps( _mm_cvtepi32_ps( high ), factor ) );
+		}
+#endif
+
+		for( ; i < count; ++i )
+		{
+			destination[ i ] = fixed_to_float( source[ i ], scale );
+		}
+	}
+}
+
+//	============================================================================================
+//	Storage packs
+//	Not meant for math, widen back to the float pack first
+//	============================================================================================
+
+/**
+ * Binary16 storage of a float pack
+ */
+template <detail::float_pack_t P>
+struct half_pack_t
+{
+	public:
+	constexpr static size_t Len = P::Len;
+	using Bits                  = std::array<uint16_t, Len>;
+
+	//	============================================================================================
+
+	explicit half_pack_t( ) = default;
+
+	auto initialize( const P &value )->void
+	{
+		for( auto i = size_t{ 0 }; i < Len; ++i )
+		{
+			m_bits[ i ] = detail::float_to_half( value[ i ] );
+		}
+	}
+
+	explicit half_pack_t( const P &value )
+	{
+		initialize( value );
+	}
+
+	//	============================================================================================
+
+	auto get_bits( )const->const Bits
+	{
+		return m_bits;
+	}
+
+	/**
+	 * Widen back to the float pack
+	 *
+	 * \return
+	 */
+	auto get_pack( )const->P
+	{
+		auto result = P{ };
+
+		for( auto i = size_t{ 0 }; i < Len; ++i )
+		{
+			result[ i ] = detail::half_to_float( m_bits[ i ] );
+		}
+
+		return result;
+	}
+
+	//	============================================================================================
+
+	private:
+	Bits m_bits = Bits{};
+};
+
+/**
+ * Signed 16 bit fixed point storage of a float pack
+ * Units is the number of steps per 1.0, range is +-32768 / Units
+ *
+ * e.g. Units = 2 covers the whole map at half unit precision,
+ * Units = 128 covers angles at 1/128 of a degree
+ */
+template <detail::float_pack_t P, int Units = 8>
+struct fixed_pack_t
+{
+	public:
+	static_assert( Units > 0 );
+
+	constexpr static size_t Len  = P::Len;
+	constexpr static float Scale = 1.F / static_cast<float>( Units );
+	using Bits                   = std::array<int16_t, Len>;
+
+	//	============================================================================================
+
+	explicit fixed_pack_t( ) = default;
+
+	auto initialize( const P &value )->void
+	{
+		for( auto i = size_t{ 0 }; i < Len; ++i )
+		{
+			m_bits[ i ] = detail::float_to_fixed( value[ i ], static_cast<float>( Units ) );
+		}
+	}
+
+	explicit fixed_pack_t( const P &value )
+	{
+		initialize( value );
+	}
+
+	//	============================================================================================
+
+	auto get_bits( )const->const Bits
+	{
+		return m_bits;
+	}
+
+	/**
+	 * Widen back to the float pack
+	 *
+	 * \return
+	 */
+	auto get_pack( )const->P
+	{
+		auto result = P{ };
+
+		for( auto i = size_t{ 0 }; i < Len; ++i )
+		{
+			result[ i ] = detail::fixed_to_float( m_bits[ i ], Scale );
+		}
+
+		return result;
+	}
+
+	//	============================================================================================
+
+	private:
+	Bits m_bits = Bits{};
+};
+
+//	============================================================================================
+//	Batched conversions
+//	Packs are flat runs of components, so a batch converts as one stream
+//	============================================================================================
+
+/**
+ * Narrow a batch of float packs into binary16 storage
+ *
+ * \param source
+ * \param destination
+ */
+template <detail::float_pack_t P>
+auto compress( std::span<const P> source, std::span<half_pack_t<P>> destination )->void
+{
+	static_assert( sizeof( half_pack_t<P> ) == sizeof( uint16_t ) * P::Len );
+	assert( destination.size( ) >= source.size( ) );
+
+	PACK_TIME( storage_compress );
+
+	detail::narrow_half( reinterpret_cast<const float *>( source.data( ) ),
+						 reinterpret_cast<uint16_t *>( destination.data( ) ),
+						 source.size( ) * P::Len );
+}
+
+/**
+ * Widen a batch of binary16 storage into float packs
+ *
+ * \param source
+ * \param destination
+ */
+template <detail::float_pack_t P>
+auto widen( std::span<const half_pack_t<P>> source, std::span<P> destination )->void
+{
+	static_assert( sizeof( half_pack_t<P> ) == sizeof( uint16_t ) * P::Len );
+	assert( destination.size( ) >= source.size( ) );
+
+	PACK_TIME( storage_widen );
+
+	detail::widen_half( reinterpret_cast<const uint16_t *>( source.data( ) ),
+						reinterpret_cast<float *>( destination.data( ) ),
+						source.size( ) * P::Len );
+}
+
+/**
+ * Narrow a batch of float packs into fixed point storage
+ *
+ * \param source
+ * \param destination
+ */
+template <detail::float_pack_t P, int Units>
+auto compress( std::span<const P> source, std::span<fixed_pack_t<P, Units>> destination )->void
+{
+	static_assert( sizeof( fixed_pack_t<P, Units> ) == sizeof( int16_t ) * P::Len );
+	assert( destination.size( ) >= source.size( ) );
+
+	PACK_TIME( storage_compress );
+
+	detail::narrow_fixed( reinterpret_cast<const float *>( source.data( ) ),
+						  reinterpret_cast<int16_t *>( destination.data( ) ),
+						  source.size( ) * P::Len,
+						  static_cast<float>( Units ) );
+}
+
+/**
+ * Widen a batch of fixed point storage into float packs
+ *
+ * \param source
+ * \param destination
+ */
+template <detail::float_pack_t P, int Units>
+auto widen( std::span<const fixed_pack_t<P, Units>> source, std::span<P> destination )->void
+{
+	static_assert( sizeof( fixed_pack_t<P, Units> ) == sizeof( int16_t ) * P::Len );
+	assert( destination.size( ) >= source.size( ) );
+
+	PACK_TIME( storage_widen );
+
+	detail::widen_fixed( reinterpret_cast<const int16_t *>( source.data( ) ),
+						 reinterpret_cast<float *>( destination.data( ) ),
+						 source.size( ) * P::Len,
+						 fixed_pack_t<P, Units>::Scale );
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <concepts>
+#include <memory_resource>
+#include <vector>
+#include "dispatch.hh"
+#include "vector.hh"
+
+//	============================================================================================
+//	Batched traces against pluggable world geometry
+//
+//	Simulations hand a whole batch of segments to the geometry at once, the geometry
+//	fills in how far each one got and what it hit. Anything with a matching trace( )
+//	can be plugged in, e.g. a BVH over map brushes or a game engine trace wrapper
+//	============================================================================================
+
+/**
+ * Segments start -> end in struct of arrays form, fraction is 1 for lanes
+ * that hit nothing, normal is only meaningful where fraction < 1.
+ * Hits stop Source's DIST_EPSILON ( 1 / 32 ) in front of the surface
+ * so the next segment starts outside
+ */
+struct trace_batch_t
+{
+	const float *start[ 3 ];
+	const float *end[ 3 ];
+	float *fraction;
+	float *normal[ 3 ];
+	size_t count;
+};
+
+namespace detail
+{
+	template <typename G>
+	concept geometry_t = requires( const G &geometry, const trace_batch_t &batch )
+	{
+		{ geometry.trace( batch ) } -> std::same_as<void>;
+	};
+}
+
+/**
+ * Nothing to hit
+ */
+struct empty_geometry_t
+{
+	auto trace( const trace_batch_t &batch )const->void
+	{
+		std::fill_n( batch.fraction, batch.count, 1.F );
+	}
+};
+
+/**
+ * Set of solid half spaces, dot( normal, x ) < distance being inside
+ * Enough for flat ground and walls, mostly a reference for real geometry
+ */
+struct plane_geometry_t
+{
+	public:
+	struct plane_t
+	{
+		vector_t<float>::v3 normal;
+		float distance;
+	};
+
+	explicit plane_geometry_t( std::pmr::memory_resource *resource = std::pmr::get_default_resource( ) ) : m_planes( resource )
+	{
+	}
+
+	//	============================================================================================
+
+	/**
+	 * Add a solid half space, normal of unit length pointing out of the solid
+	 *
+	 * \param normal
+	 * \param distance
+	 */
+	auto add( const vector_t<float>::v3 &normal, const float distance )->void
+	{
+		m_planes.push_back( { normal, distance } );
+	}
+
+	auto get_size( )const->size_t
+	{
+		return m_planes.size( );
+	}
+
+	/**
+	 * Earliest entry into any plane per lane, segments starting inside are left alone
+	 *
+	 * \param batch
+	 */
+	auto trace( const trace_batch_t &batch )const->void
+	{
+		std::fill_n( batch.fraction, batch.count, 1.F );
+
+		const auto &kernels = get_kernels( );
+
+		for( const auto &plane : m_planes )
+		{
+			const auto normal = plane.normal.get_contents( );
+			kernels.clip_plane( batch.start, batch.end, normal.data( ), plane.distance, batch.fraction, batch.normal, batch.count );
+		}
+	}
+
+	//	============================================================================================
+
+	private:
+	std::pmr::vector<plane_t> m_planes;
+};
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <cstddef>
+#include "simd.hh"
+#include "vector.hh"
+
+//	============================================================================================
+//	Array of structs <-> struct of arrays transposition
+//
+//	Float packs of two to four components are moved four ( SSE2 ) or eight ( AVX ) elements
+//	at a time with in register shuffles, everything else and the remainder goes through
+//	a plain component loop
+//	============================================================================================
+
+namespace detail
+{
+	//	============================================================================================
+	//	Shuffle networks, four elements per 128 bit lane
+	//	Written against the 256 bit forms too, which shuffle each lane independently
+	//	============================================================================================
+
+#if defined( PACK_SSE2 )
+	/**
+	 * x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3 -> x0 x1 x2 x3 | y0 y1 y2 y3 | z0 z1 z2 z3
+	 */
+	inline auto deinterleave3( __m128 &a, __m128 &b, __m128 &c )->void
+	{
+		const auto high = _mm_shuffle_ps( b, c, _MM_SHUFFLE( 2, 1, 3, 2 ) );
+		const auto low  = _mm_shuffle_ps( a, b, _MM_SHUFFLE( 1, 0, 2, 1 ) );
+
+		const auto x = _mm_shuffle_ps( a, high, _MM_SHUFFLE( 2, 0, 3, 0 ) );
+		const auto y = _mm_shuffle_ps( low, high, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+		const auto z = _mm_shuffle_ps( low, c, _MM_SHUFFLE( 3, 0, 3, 1 ) );
+
+		a = x;
+		b = y;
+		c = z;
+	}
+
+	inline auto interleave3( __m128 &x, __m128 &y, __m128 &z )->void
+	{
+		const auto even_xy = _mm_shuffle_ps( x, y, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+		const auto odd_yz  = _mm_shuffle_ps( y, z, _MM_SHUFFLE( 3, 1, 3, 1 ) );
+		const auto zx      = _mm_shuffle_ps( z, x, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+
+		x = _mm_shuffle_ps( even_xy, zx, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+		y = _mm_shuffle_ps( odd_yz, even_xy, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+		z = _mm_shuffle_ps( zx, odd_yz, _MM_SHUFFLE( 3, 1, 3, 1 ) );
+	}
+#endif
+
+#if defined( PACK_AVX2 )
+	inline auto deinterleave3( __m256 &a, __m256 &b, __m256 &c )->void
+	{
+		const auto high = _mm256_shuffle_ps( b, c, _MM_SHUFFLE( 2, 1, 3, 2 ) );
+		const auto low  = _mm256_shuffle_ps( a, b, _MM_SHUFFLE( 1, 0, 2, 1 ) );
+
+		const auto x = _mm256_shuffle_ps( a, high, _MM_SHUFFLE( 2, 0, 3, 0 ) );
+		const auto y = _mm256_shuffle_ps( low, high, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+		const auto z = _mm256_shuffle_ps( low, c, _MM_SHUFFLE( 3, 0, 3, 1 ) );
+
+		a = x;
+		b = y;
+		c = z;
+	}
+
+	inline auto interleave3( __m256 &x, __m256 &y, __m256 &z )->void
+	{
+		const auto even_xy = _mm256_shuffle_ps( x, y, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+		const auto odd_yz  = _mm256_shuffle_ps( y, z, _MM_SHUFFLE( 3, 1, 3, 1 ) );
+		const auto zx      = _mm256_shuffle_ps( z, x, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+
+		x = _mm256_shuffle_ps( even_xy, zx, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+		y = _mm256_shuffle_ps( odd_yz, even_xy, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+		z = _mm256_shuffle_ps( zx, odd_yz, _MM_SHUFFLE( 3, 1, 3, 1 ) );
+	}
+
+	/**
+	 * Elements 0 - 3 in the low lane, 4 - 7 in the high one
+	 */
+	inline auto load_lanes( const float *low, const float *high )->__m256
+	{
+		return _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( low ) ), _mm_loadu_ps( high ), 1 );
+	}
+
+	inline auto store_lanes( float *low, float *high, const __m256 v )->void
+	{
+		_mm_storeu_ps( low, _mm256_castps256_ps128( v ) );
+		_mm_storeu_ps( high, _mm256_extractf128_ps( v, 1 ) );
+	}
+#endif
+
+	//	============================================================================================
+	//	Transposition
+	//	============================================================================================
+
+	/**
+	 * Split count packs into one stream per component
+	 *
+	 * \param source
+	 * \param lanes
+	 * \param count
+	 */
+	template <pack_t P>
+	auto deinterleave( const P *source, typename P::Type *const *lanes, const size_t count )->void
+	{
+		auto i = size_t{ 0 };
+
+#if defined( PACK_SSE2 )
+		if constexpr( float_pack_t<P> )
+		{
+			const auto *flat = reinterpret_cast<const float *>( source );
+
+			if constexpr( P::Len == 2U )
+			{
+				for( ; i + 4 <= count; i += 4 )
+				{
+					const auto a = _mm_loadu_ps( flat + i * 2 );
+					const auto b = _mm_loadu_ps( flat + i * 2 + 4 );
+
+					_mm_storeu_ps( lanes[ 0 ] + i, _mm_shuffle_ps( a, b, _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+					_mm_storeu_ps( lanes[ 1 ] + i, _mm_shuffle_ps( a, b, _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+				}
+			}
+			else if constexpr( P::Len == 3U )
+			{
+#if defined( PACK_AVX2 )
+				for( ; i + 8 <= count; i += 8 )
+				{
+					const auto *base = flat + i * 3;
+
+					auto a = load_lanes( base, base + 12 );
+					auto b = load_lanes( base + 4, base + 16 );
+					auto c = load_lanes( base + 8, base + 20 );
+
+					deinterleave3( a, b, c );
+
+					_mm256_storeu_ps( lanes[ 0 ] + i, a );
+					_mm256_storeu_ps( lanes[ 1 ] + i, b );
+					_mm256_storeu_ps( lanes[ 2 ] + i, c );
+				}
+#endif
+
+				for( ; i + 4 <= count; i += 4 )
+				{
+					auto a = _mm_loadu_ps( flat + i * 3 );
+					auto b = _mm_loadu_ps( flat + i * 3 + 4 );
+					auto c = _mm_loadu_ps( flat + i * 3 + 8 );
+
+					deinterleave3( a, b, c );
+
+					_mm_storeu_ps( lanes[ 0 ] + i, a );
+					_mm_storeu_ps( lanes[ 1 ] + i, b );
+					_mm_storeu_ps( lanes[ 2 ] + i, c );
+				}
+			}
+			else if constexpr( P::Len == 4U )
+			{
+				for( ; i + 4 <= count; i += 4 )
+				{
+					auto a = _mm_loadu_ps( flat + i * 4 );
+					auto b = _mm_loadu_ps( flat + i * 4 + 4 );
+					auto c = _mm_loadu_ps( flat + i * 4 + 8 );
+					auto d = _mm_loadu_ps( flat + i * 4 + 12 );
+
+					_MM_TRANSPOSE4_PS( a, b, c, d );
+
+					_mm_storeu_ps( lanes[ 0 ] + i, a );
+					_mm_storeu_ps( lanes[ 1 ] + i, b );
+					_mm_storeu_ps( lanes[ 2 ] + i, c );
+					_mm_storeu_ps( lanes[ 3 ] + i, d );
+				}
+			}
+		}
+#endif
+
+		for( ; i < count; ++i )
+		{
+			for( auto c = size_t{ 0 }; c < P::Len; ++c )
+			{
+				lanes[ c ][ i ] = source[ i ][ c ];
+			}
+		}
+	}
+
+	/**
+	 * Merge one stream per component back into count packs
+	 *
+	 * \param lanes
+	 * \param destination
+	 * \param count
+	 */
+	template <pack_t P>
+	auto interleave( const typename P::Type *const *lanes, P *destination, const size_t count )->void
+	{
+		auto i = size_t{ 0 };
+
+#if defined( PACK_SSE2 )
+		if constexpr( float_pack_t<P> )
+		{
+			auto *flat = reinterpret_cast<float *>( destination );
+
+			if constexpr( P::Len == 2U )
+			{
+				for( ; i + 4 <= count; i += 4 )
+				{
+					const auto x = _mm_loadu_ps( lanes[ 0 ] + i );
+					const auto y = _mm_loadu_ps( lanes[ 1 ] + i );
+
+					_mm_storeu_ps( flat + i * 2, _mm_unpacklo_ps( x, y ) );
+					_mm_storeu_ps( flat + i * 2 + 4, _mm_unpackhi_ps( x, y ) );
+				}
+			}
+			else if constexpr( P::Len == 3U )
+			{
+#if defined( PACK_AVX2 )
+				for( ; i + 8 <= count; i += 8 )
+				{
+					auto *base = flat + i * 3;
+
+					auto x = _mm256_loadu_ps( lanes[ 0 ] + i );
+					auto y = _mm256_loadu_ps( lanes[ 1 ] + i );
+					auto z = _mm256_loadu_ps( lanes[ 2 ] + i );
+
+					interleave3( x, y, z );
+
+					store_lanes( base, base + 12, x );
+					store_lanes( base + 4, base + 16, y );
+					store_lanes( base + 8, base + 20, z );
+				}
+#endif
+
+				for( ; i + 4 <= count; i += 4 )
+				{
+					auto x = _mm_loadu_ps( lanes[ 0 ] + i );
+					auto y = _mm_loadu_ps( lanes[ 1 ] + i );
+					auto z = _mm_loadu_ps( lanes[ 2 ] + i );
+
+					interleave3( x, y, z );
+
+					_mm_storeu_ps( flat + i * 3, x );
+					_mm_storeu_ps( flat + i * 3 + 4, y );
+					_mm_storeu_ps( flat + i * 3 + 8, z );
+				}
+			}
+			else if constexpr( P::Len == 4U )
+			{
+				for( ; i + 4 <= count; i += 4 )
+				{
+					auto a = _mm_loadu_ps( lanes[ 0 ] + i );
+					auto b = _mm_loadu_ps( lanes[ 1 ] + i );
+					auto c = _mm_loadu_ps( lanes[ 2 ] + i );
+					auto d = _mm_loadu_ps( lanes[ 3 ] + i );
+
+					_MM_TRANSPOSE4_PS( a, b, c, d );
+
+					_mm_storeu_ps( flat + i * 4, a );
+					_mm_storeu_ps( flat + i * 4 + 4, b );
+					_mm_storeu_ps( flat + i * 4 + 8, c );
+					_mm_storeu_ps( flat + i * 4 + 12, d );
+				}
+			}
+		}
+#endif
+
+		for( ; i < count; ++i )
+		{
+			for( auto c = size_t{ 0 }; c < P::Len; ++c )
+			{
+				destination[ i ][ c ] = lanes[ c ][ i ];
+			}
+		}
+	}
+}
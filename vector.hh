@@ -1,17 +1,56 @@
 #pragma once
 
+#include <array>
+#include <cassert>
 #include <cstdint>
 #include <cmath>
+#include <concepts>
 #include <type_traits>
 #include <utility>
 #include <algorithm>
 #include <corecrt_math_defines.h>
 #include "enums.hh"
+#include "instrument.hh"
 
 namespace detail
 {
 	template <typename T>
 	concept args_t = std::is_integral<T>::value || std::is_floating_point<T>::value;
+
+	/**
+	 * Call function( I ) for every I < N as one unrolled expression,
+	 * I arrives as a std::integral_constant
+	 *
+	 * \param function
+	 */
+	template <size_t N, typename F>
+	constexpr auto unroll( F &&function )->void
+	{
+		[ & ]<size_t... I>( std::index_sequence<I...> )
+		{
+			( function( std::integral_constant<size_t, I>{ } ), ... );
+		}( std::make_index_sequence<N>{ } );
+	}
+
+	/**
+	 * Sum of function( I ) for every I < N, folded left to right
+	 * so it rounds exactly like an accumulating loop
+	 *
+	 * \param function
+	 * \return
+	 */
+	template <typename T, size_t N, typename F>
+	constexpr auto fold_sum( F &&function )->T
+	{
+		return [ & ]<size_t... I>( std::index_sequence<I...> )
+		{
+			return static_cast<T>( ( T{ } + ... + function( std::integral_constant<size_t, I>{ } ) ) );
+		}( std::make_index_sequence<N>{ } );
+	}
+
+	//	T once per index, spells out the pack type of a swizzle
+	template <typename T, size_t>
+	using repeat_t = T;
 }
 
 template <detail::args_t T>
@@ -22,6 +61,7 @@ struct vector_t
 	{
 		public:
 		constexpr static size_t Len = sizeof...( Args );
+		using Type                  = T;
 		using Arr                   = std::array<T, Len>;
 
 		//	============================================================================================
@@ -119,6 +159,64 @@ struct vector_t
 
 		//	============================================================================================
 
+		//	============================================================================================
+		//	Swizzles
+		//	Indices are template arguments, so a swizzle is a fixed register permutation
+		//	the compiler folds into one shuffle or plain moves
+		//	============================================================================================
+
+		/**
+		 * Components I... as a new pack, in that order, repeats allowed
+		 *
+		 * \return
+		 */
+		template <size_t... I>
+		auto swizzle( )const->pack<detail::repeat_t<T, I>...>
+		{
+			static_assert( sizeof...( I ) > 0 );
+			static_assert( ( ( I < Len ) && ... ) );
+
+			return pack<detail::repeat_t<T, I>...>( m_contents[ I ]... );
+		}
+
+		auto xy( )const->pack<T, T>
+			requires( Len >= 2U )
+		{
+			return swizzle<0, 1>( );
+		}
+
+		auto yx( )const->pack<T, T>
+			requires( Len >= 2U )
+		{
+			return swizzle<1, 0>( );
+		}
+
+		auto xz( )const->pack<T, T>
+			requires( Len >= 3U )
+		{
+			return swizzle<0, 2>( );
+		}
+
+		auto yz( )const->pack<T, T>
+			requires( Len >= 3U )
+		{
+			return swizzle<1, 2>( );
+		}
+
+		auto xyz( )const->pack<T, T, T>
+			requires( Len >= 3U )
+		{
+			return swizzle<0, 1, 2>( );
+		}
+
+		auto zyx( )const->pack<T, T, T>
+			requires( Len >= 3U )
+		{
+			return swizzle<2, 1, 0>( );
+		}
+
+		//	============================================================================================
+
 		//	============================================================================================
 		//	Mathematical methods
 		//	============================================================================================
@@ -128,15 +226,7 @@ struct vector_t
 		{
 			static_assert( N <= Len );
 
-			const auto &contents = get_contents( );
-			auto result          = T{};
-
-			for( auto i = size_t{ 0 }; i < N; ++i )
-			{
-				result += contents[ i ] * contents[ i ];
-			}
-
-			return result;
+			return detail::fold_sum<T, N>( [ this ]( const size_t i ) { return m_contents[ i ] * m_contents[ i ]; } );
 		}
 
 		template <size_t N = Len>
@@ -150,33 +240,15 @@ struct vector_t
 		{
 			static_assert( N <= Len );
 
-			const auto &contents = get_contents( );
-			auto result          = T{};
-
-			for( auto i = size_t{ 0 }; i < N; ++i )
-			{
-				result += contents[ i ] * arg;
-			}
-
-			return result;
+			return detail::fold_sum<T, N>( [ this, arg ]( const size_t i ) { return m_contents[ i ] * arg; } );
 		}
 
 		template <size_t N = Len>
 		auto dot( const pack &arg )const->T
 		{
 			static_assert( N <= Len );
-			assert( arg.get_size( ) <= N );
-
-			const auto &arg_contents = get_contents( );
-			const auto &contents     = get_contents( );
-			auto result              = T{};
 
-			for( auto i = size_t{ 0 }; i < N; ++i )
-			{
-				result += contents[ i ] * arg_contents[ i ];
-			}
-
-			return result;
+			return detail::fold_sum<T, N>( [ this, &arg ]( const size_t i ) { return m_contents[ i ] * arg.m_contents[ i ]; } );
 		}
 
 		template <size_t N = Len>
@@ -193,6 +265,83 @@ struct vector_t
 
 		//	============================================================================================
 
+		//	============================================================================================
+		//	Geometric methods
+		//	============================================================================================
+
+		/**
+		 * Right handed cross product
+		 *
+		 * \param arg
+		 * \return
+		 */
+		auto cross( const pack &arg )const->pack<Args...>
+		{
+			static_assert( Len == 3U );
+
+			auto result = pack<Args...>{};
+
+			result[ 0 ] = operator[]( 1 ) * arg[ 2 ] - operator[]( 2 ) * arg[ 1 ];
+			result[ 1 ] = operator[]( 2 ) * arg[ 0 ] - operator[]( 0 ) * arg[ 2 ];
+			result[ 2 ] = operator[]( 0 ) * arg[ 1 ] - operator[]( 1 ) * arg[ 0 ];
+
+			return result;
+		}
+
+		/**
+		 * Part of self along onto, zero when onto has no length
+		 *
+		 * \param onto
+		 * \return
+		 */
+		auto project( const pack &onto )const->pack<Args...>
+		{
+			const auto length = onto.get_dot( );
+			auto result       = pack<Args...>{};
+
+			if( length == T{} )
+			{
+				return result;
+			}
+
+			const auto scale = dot( onto ) / length;
+
+			detail::unroll<Len>( [ &result, &onto, scale ]( const size_t i ) { result[ i ] = onto[ i ] * scale; } );
+
+			return result;
+		}
+
+		/**
+		 * Signed distance to the plane dot( normal, x ) = distance,
+		 * positive in front. normal must be of unit length
+		 *
+		 * \param normal
+		 * \param distance
+		 * \return
+		 */
+		auto get_plane_distance( const pack &normal, const T distance )const->T
+		{
+			return dot( normal ) - distance;
+		}
+
+		/**
+		 * Mirror about a plane through the origin, normal must be of unit length
+		 *
+		 * \param normal
+		 * \return
+		 */
+		auto reflect( const pack &normal )const->pack<Args...>
+		{
+			const auto along = dot( normal );
+			auto result      = pack<Args...>{};
+
+			detail::unroll<Len>( [ this, &result, &normal, along ]( const size_t i ) { result[ i ] = m_contents[ i ] - normal[ i ] * ( along + along ); } );
+
+			return result;
+		}
+
+		//	============================================================================================
+
 		//	============================================================================================
 		//	CS:GO methods
 		//	============================================================================================
@@ -202,6 +351,9 @@ struct vector_t
 			static_assert( std::is_same_v<T, float> );
 			static_assert( Len == 3U );
 
+			PACK_TIME( normalize_angle );
+			PACK_COUNT_IF( !std::isfinite( operator[]( PITCH ) ) || !std::isfinite( operator[]( YAW ) ), normalize_angle_nonfinite );
+
 			operator[]( PITCH ) = std::isfinite( operator[]( PITCH ) ) ? std::remainderf( operator[]( PITCH ), 360.F ) : 0.F;
 			operator[]( YAW )   = std::isfinite( operator[]( YAW ) ) ? std::remainderf( operator[]( YAW ), 360.F ) : 0.F;
 			operator[]( ROLL )  = 0.F;
@@ -217,30 +369,32 @@ struct vector_t
 			return copy;
 		}
 
+		/**
+		 * Zero length turns into the last axis, up for v3
+		 */
 		auto normalize_length( )->void
 		{
 			static_assert( std::is_same_v<T, float> );
-			static_assert( Len == 3U );
+
+			PACK_TIME( normalize_length );
 
 			const auto &length = get_length( );
 
+			PACK_COUNT_IF( length == 0.F, normalize_length_zero );
+
 			if( length != 0.F )
 			{
-				operator[]( PITCH ) /= length;
-				operator[]( YAW )   /= length;
-				operator[]( ROLL )  /= length;
+				detail::unroll<Len>( [ this, length ]( const size_t i ) { m_contents[ i ] /= length; } );
 			}
 			else
 			{
-				operator[]( PITCH ) = operator[]( YAW ) = 0.F;
-				operator[]( ROLL )  = 1.F;
+				detail::unroll<Len>( [ this ]( const size_t i ) { m_contents[ i ] = i + 1 == Len ? 1.F : 0.F; } );
 			}
 		}
 
 		auto normalized_length( )const->pack<Args...>
 		{
 			static_assert( std::is_same_v<T, float> );
-			static_assert( Len == 3U );
 
 			auto copy = get_copy( );
 			copy.normalize_length( );
@@ -249,18 +403,22 @@ struct vector_t
 
 		auto get_angle( )const->pack<Args...>
 		{
+			PACK_TIME( get_angle );
+
 			auto forward = *this;
 			auto angles  = pack<Args...>{};
 		
 			if( forward[ PITCH ] == 0.F && forward[ YAW ] == 0.F )
 			{
-				angles[ PITCH ] = angles[ ROLL ] > 0.F ? -90.F : 90.F;
+				PACK_COUNT( get_angle_vertical );
+
+				angles[ PITCH ] = forward[ ROLL ] > 0.F ? -90.F : 90.F;
 				angles[ YAW ]   = 0.F;
 			}
 			else
 			{
-				angles[ PITCH ] = atan2( -forward[ ROLL ], forward.get_length<2>( ) ) * ( 180.F / M_PI );
-				angles[ YAW ]   = atan2( forward[ YAW ], forward[ PITCH ] * ( 180.F / M_PI ) );
+				angles[ PITCH ] = atan2( -forward[ ROLL ], forward.template get_length<2>( ) ) * ( 180.F / M_PI );
+				angles[ YAW ]   = atan2( forward[ YAW ], forward[ PITCH ] ) * ( 180.F / M_PI );
 			}
 
 			angles[ ROLL ] = 0.F;
@@ -268,11 +426,39 @@ struct vector_t
 			return angles;
 		}
 
+		/**
+		 * Source's AngleVectors, self being pitch / yaw / roll in degrees
+		 *
+		 * \param forward
+		 * \param right
+		 * \param up
+		 */
+		auto angle_vectors( pack &forward, pack &right, pack &up )const->void
+		{
+			static_assert( std::is_same_v<T, float> );
+			static_assert( Len == 3U );
+
+			constexpr auto Radians = static_cast<float>( M_PI / 180.0 );
+
+			const auto sp = std::sin( operator[]( PITCH ) * Radians );
+			const auto cp = std::cos( operator[]( PITCH ) * Radians );
+			const auto sy = std::sin( operator[]( YAW ) * Radians );
+			const auto cy = std::cos( operator[]( YAW ) * Radians );
+			const auto sr = std::sin( operator[]( ROLL ) * Radians );
+			const auto cr = std::cos( operator[]( ROLL ) * Radians );
+
+			forward.initialize( cp * cy, cp * sy, -sp );
+			right.initialize( -sr * sp * cy + cr * sy, -sr * sp * sy - cr * cy, -sr * cp );
+			up.initialize( cr * sp * cy + sr * sy, cr * sp * sy - sr * cy, cr * cp );
+		}
+
 		auto clamp_angle( )
 		{
 			static_assert( std::is_same_v<T, float> );
 			static_assert( Len == 3U );
 
+			PACK_TIME( clamp_angle );
+
 			//	Enforce non-const operator[] to be called
 			operator[]( PITCH ) = std::clamp<float>( operator[]( PITCH ), -89.F, 89.F );
 			operator[]( YAW )   = std::clamp<float>( operator[]( YAW ), -180.F, 180.F );
@@ -289,3 +475,18 @@ struct vector_t
 	using v3 = pack<T, T, T>;
 	using v4 = pack<T, T, T, T>;
 };
+
+namespace detail
+{
+	template <typename P>
+	concept pack_t = requires( const P & p )
+	{
+		typename P::Type;
+		typename P::Arr;
+		{ P::Len } -> std::convertible_to<size_t>;
+		{ p[ size_t{ 0 } ] } -> std::convertible_to<typename P::Type>;
+	};
+
+	template <typename P>
+	concept float_pack_t = pack_t<P> && std::is_same_v<typename P::Type, float> && sizeof( P ) == sizeof( float ) * P::Len;
+}
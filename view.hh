@@ -0,0 +1,525 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include "instrument.hh"
+#include "simd.hh"
+#include "vector.hh"
+
+namespace detail
+{
+	template <typename P>
+	concept view_pack_t = pack_t<std::remove_const_t<P>>;
+
+	template <typename P, typename U>
+	using copy_const_t = std::conditional_t<std::is_const_v<P>, const U, U>;
+}
+
+/**
+ * Non-owning pack over components I... of a P living elsewhere, in that order,
+ * e.g. the ground plane part of an origin without copying it out
+ * Use a const P to view read-only memory
+ */
+template <detail::view_pack_t P, size_t... I>
+struct swizzle_view_t
+{
+	public:
+	using Source                = std::remove_const_t<P>;
+	using Value                 = typename Source::Type;
+	using Type                  = detail::copy_const_t<P, Value>;
+	using Pack                  = typename vector_t<Value>::template pack<detail::repeat_t<Value, I>...>;
+	constexpr static size_t Len = sizeof...( I );
+
+	static_assert( Len > 0 );
+	static_assert( ( ( I < Source::Len ) && ... ) );
+
+	//	============================================================================================
+
+	explicit swizzle_view_t( Type *data ) : m_data( data )
+	{
+	}
+
+	explicit swizzle_view_t( detail::copy_const_t<P, Source> &pack ) : m_data( reinterpret_cast<Type *>( &pack ) )
+	{
+		static_assert( sizeof( Source ) == sizeof( Value ) * Source::Len );
+	}
+
+	//	============================================================================================
+
+	constexpr auto get_size( )const->size_t
+	{
+		return Len;
+	}
+
+	auto operator[ ]( const size_t i )const->Type &
+	{
+		return m_data[ Indices[ i ] ];
+	}
+
+	/**
+	 * Owning copy of viewed components
+	 *
+	 * \return
+	 */
+	auto get_pack( )const->Pack
+	{
+		return Pack( m_data[ I ]... );
+	}
+
+	/**
+	 * Write a pack through the view, with repeated indices the last one wins
+	 *
+	 * \param value
+	 */
+	auto assign( const Pack &value )const->void
+		requires( !std::is_const_v<P> )
+	{
+		detail::unroll<Len>( [ this, &value ]( const size_t i ) { m_data[ Indices[ i ] ] = value[ i ]; } );
+	}
+
+	auto get_dot( )const->Value
+	{
+		return detail::fold_sum<Value, Len>( [ this ]( const size_t i ) { return m_data[ Indices[ i ] ] * m_data[ Indices[ i ] ]; } );
+	}
+
+	auto get_length( )const
+	{
+		return sqrt( get_dot( ) );
+	}
+
+	auto dot( const Pack &arg )const->Value
+	{
+		return detail::fold_sum<Value, Len>( [ this, &arg ]( const size_t i ) { return m_data[ Indices[ i ] ] * arg[ i ]; } );
+	}
+
+	//	============================================================================================
+
+	private:
+	constexpr static size_t Indices[ Len ] = { I... };
+
+	Type *m_data = nullptr;
+};
+
+/**
+ * Non-owning pack over Len contiguous components living elsewhere
+ * Use a const P to view read-only memory
+ */
+template <detail::view_pack_t P>
+struct pack_view_t
+{
+	public:
+	using Pack                  = std::remove_const_t<P>;
+	using Value                 = typename Pack::Type;
+	using Type                  = detail::copy_const_t<P, Value>;
+	constexpr static size_t Len = Pack::Len;
+
+	//	============================================================================================
+
+	explicit pack_view_t( Type *data ) : m_data( data )
+	{
+	}
+
+	explicit pack_view_t( detail::copy_const_t<P, Pack> &pack ) : m_data( reinterpret_cast<Type *>( &pack ) )
+	{
+		static_assert( sizeof( Pack ) == sizeof( Value ) * Len );
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	Operational methods
+	//	============================================================================================
+
+	constexpr auto get_size( )const->size_t
+	{
+		return Len;
+	}
+
+	auto get_data( )const->Type *
+	{
+		return m_data;
+	}
+
+	auto operator[ ]( const size_t i )const->Type &
+	{
+		return m_data[ i ];
+	}
+
+	/**
+	 * Owning copy of viewed contents
+	 *
+	 * \return
+	 */
+	auto get_pack( )const->Pack
+	{
+		auto result = Pack{ };
+		detail::unroll<Len>( [ this, &result ]( const size_t i ) { result[ i ] = m_data[ i ]; } );
+
+		return result;
+	}
+
+	/**
+	 * Write a pack through the view
+	 *
+	 * \param value
+	 */
+	auto assign( const Pack &value )const->void
+		requires( !std::is_const_v<P> )
+	{
+		detail::unroll<Len>( [ this, &value ]( const size_t i ) { m_data[ i ] = value[ i ]; } );
+	}
+
+	/**
+	 * View of components I... of the same memory
+	 *
+	 * \return
+	 */
+	template <size_t... I>
+	auto swizzle( )const->swizzle_view_t<P, I...>
+	{
+		return swizzle_view_t<P, I...>{ m_data };
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	Mathematical methods
+	//	============================================================================================
+
+	template <size_t N = Len>
+	auto get_dot( )const->Value
+	{
+		static_assert( N <= Len );
+
+		return detail::fold_sum<Value, N>( [ this ]( const size_t i ) { return m_data[ i ] * m_data[ i ]; } );
+	}
+
+	template <size_t N = Len>
+	auto get_length( )const
+	{
+		return sqrt( get_dot<N>( ) );
+	}
+
+	template <size_t N = Len>
+	auto dot( const Pack &arg )const->Value
+	{
+		static_assert( N <= Len );
+
+		return detail::fold_sum<Value, N>( [ this, &arg ]( const size_t i ) { return m_data[ i ] * arg[ i ]; } );
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	CS:GO methods
+	//	Round trip through a register sized pack so results match pack bit for bit
+	//	============================================================================================
+
+	auto normalize_angle( )const->void
+		requires( !std::is_const_v<P> )
+	{
+		auto value = get_pack( );
+		value.normalize_angle( );
+		assign( value );
+	}
+
+	auto normalize_length( )const->void
+		requires( !std::is_const_v<P> )
+	{
+		auto value = get_pack( );
+		value.normalize_length( );
+		assign( value );
+	}
+
+	auto clamp_angle( )const->void
+		requires( !std::is_const_v<P> )
+	{
+		auto value = get_pack( );
+		value.clamp_angle( );
+		assign( value );
+	}
+
+	//	============================================================================================
+
+	private:
+	Type *m_data = nullptr;
+};
+
+/**
+ * Non-owning batch of packs spaced stride bytes apart,
+ * e.g. the origin member of every entity in a state block
+ */
+template <detail::view_pack_t P>
+struct strided_view_t
+{
+	public:
+	using Pack                  = std::remove_const_t<P>;
+	using Value                 = typename Pack::Type;
+	using Type                  = detail::copy_const_t<P, Value>;
+	using Byte                  = detail::copy_const_t<P, unsigned char>;
+	using Length                = std::conditional_t<std::is_floating_point_v<Value>, Value, double>;
+	constexpr static size_t Len = Pack::Len;
+
+	//	============================================================================================
+
+	strided_view_t( Type *first, const size_t count, const size_t stride )
+		: m_first( reinterpret_cast<Byte *>( first ) ), m_count( count ), m_stride( stride )
+	{
+		assert( stride >= sizeof( Value ) * Len );
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	Operational methods
+	//	============================================================================================
+
+	auto get_size( )const->size_t
+	{
+		return m_count;
+	}
+
+	auto get_stride( )const->size_t
+	{
+		return m_stride;
+	}
+
+	auto operator[ ]( const size_t i )const->pack_view_t<P>
+	{
+		return pack_view_t<P>{ get_element( i ) };
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	Mathematical methods
+	//	============================================================================================
+
+	/**
+	 * Squared length of every element
+	 *
+	 * \param destination
+	 */
+	template <size_t N = Len>
+	auto get_dot( std::span<Value> destination )const->void
+	{
+		static_assert( N <= Len );
+		assert( destination.size( ) >= m_count );
+
+		PACK_TIME( view_get_dot );
+
+		auto i = size_t{ 0 };
+
+#if defined( PACK_AVX2 )
+		if constexpr( std::is_same_v<Value, float> )
+		{
+			if( can_gather( ) )
+			{
+				//	A bound known up front leaves the tail below under 8 iterations, GCC cannot
+				//	prove that after i + 8 <= m_count and warns the tail might overflow the index
+				for( const auto whole = m_count - m_count % 8; i < whole; i += 8 )
+				{
+					_mm256_storeu_ps( destination.data( ) + i, gather_dot<N>( i ) );
+				}
+			}
+		}
+#endif
+
+		for( ; i < m_count; ++i )
+		{
+			destination[ i ] = operator[]( i ).template get_dot<N>( );
+		}
+	}
+
+	/**
+	 * Length of every element
+	 *
+	 * \param destination
+	 */
+	template <size_t N = Len>
+	auto get_length( std::span<Length> destination )const->void
+	{
+		static_assert( N <= Len );
+		assert( destination.size( ) >= m_count );
+
+		PACK_TIME( view_get_length );
+
+		auto i = size_t{ 0 };
+
+#if defined( PACK_AVX2 )
+		if constexpr( std::is_same_v<Value, float> )
+		{
+			if( can_gather( ) )
+			{
+				for( const auto whole = m_count - m_count % 8; i < whole; i += 8 )
+				{
+					_mm256_storeu_ps( destination.data( ) + i, _mm256_sqrt_ps( gather_dot<N>( i ) ) );
+				}
+			}
+		}
+#endif
+
+		for( ; i < m_count; ++i )
+		{
+			destination[ i ] = static_cast<Length>( operator[]( i ).template get_length<N>( ) );
+		}
+	}
+
+	//	============================================================================================
+
+	//	============================================================================================
+	//	CS:GO methods
+	//	============================================================================================
+
+	auto normalize_angle( )const->void
+		requires( !std::is_const_v<P> )
+	{
+		PACK_TIME( view_normalize_angle );
+
+		for( auto i = size_t{ 0 }; i < m_count; ++i )
+		{
+			operator[]( i ).normalize_angle( );
+		}
+	}
+
+	auto normalize_length( )const->void
+		requires( !std::is_const_v<P> )
+	{
+		PACK_TIME( view_normalize_length );
+
+		auto i = size_t{ 0 };
+
+#if defined( PACK_AVX2 )
+		if constexpr( std::is_same_v<Value, float> )
+		{
+			if( can_gather( ) )
+			{
+				const auto zero = _mm256_setzero_ps( );
+
+				for( const auto whole = m_count - m_count % 8; i < whole; i += 8 )
+				{
+					const auto length = _mm256_sqrt_ps( gather_dot<Len>( i ) );
+					const auto valid  = _mm256_cmp_ps( length, zero, _CMP_NEQ_OQ );
+
+					//	Stores have no AVX2 counterpart to gathers, scatter by hand
+					alignas( 32 ) float components[ Len ][ 8 ];
+
+					for( auto c = size_t{ 0 }; c < Len; ++c )
+					{
+						const auto fallback = c + 1 == Len ? _mm256_set1_ps( 1.F ) : zero;
+						const auto scaled   = _mm256_div_ps( gather( i, c ), length );
+						_mm256_store_ps( components[ c ], _mm256_blendv_ps( fallback, scaled, valid ) );
+					}
+
+					for( auto k = size_t{ 0 }; k < 8; ++k )
+					{
+						auto *element = get_element( i + k );
+
+						for( auto c = size_t{ 0 }; c < Len; ++c )
+						{
+							element[ c ] = components[ c ][ k ];
+						}
+					}
+				}
+			}
+		}
+#endif
+
+		//	Square root and divide in Value like the gather path above, pack::normalize_length
+		//	may widen to double depending on which sqrt overload the platform picks
+		for( ; i < m_count; ++i )
+		{
+			auto *element     = get_element( i );
+			const auto length = std::sqrt( operator[]( i ).get_dot( ) );
+
+			for( auto c = size_t{ 0 }; c < Len; ++c )
+			{
+				element[ c ] = length != Value{ 0 } ? element[ c ] / length : ( c + 1 == Len ? Value{ 1 } : Value{ 0 } );
+			}
+		}
+	}
+
+	auto clamp_angle( )const->void
+		requires( !std::is_const_v<P> )
+	{
+		PACK_TIME( view_clamp_angle );
+
+		for( auto i = size_t{ 0 }; i < m_count; ++i )
+		{
+			operator[]( i ).clamp_angle( );
+		}
+	}
+
+	//	============================================================================================
+
+	private:
+	auto get_element( const size_t i )const->Type *
+	{
+		return reinterpret_cast<Type *>( m_first + i * m_stride );
+	}
+
+#if defined( PACK_AVX2 )
+	/**
+	 * Gathers index in whole floats relative to a block's first element
+	 *
+	 * \return
+	 */
+	auto can_gather( )const->bool
+	{
+		return m_stride % sizeof( float ) == 0 && m_stride / sizeof( float ) * 8 <= size_t{ INT32_MAX };
+	}
+
+	auto gather( const size_t i, const size_t c )const->__m256
+	{
+		const auto step    = static_cast<int32_t>( m_stride / sizeof( float ) );
+		const auto offsets = _mm256_mullo_epi32( _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 ), _mm256_set1_epi32( step ) );
+
+		return _mm256_i32gather_ps( get_element( i ) + c, offsets, sizeof( float ) );
+	}
+
+	template <size_t N>
+	auto gather_dot( const size_t i )const->__m256
+	{
+		auto result = _mm256_setzero_ps( );
+
+		for( auto c = size_t{ 0 }; c < N; ++c )
+		{
+			const auto component = gather( i, c );
+			result               = _mm256_add_ps( result, _mm256_mul_ps( component, component ) );
+		}
+
+		return result;
+	}
+#endif
+
+	Byte *m_first   = nullptr;
+	size_t m_count  = 0;
+	size_t m_stride = 0;
+};
+
+/**
+ * View a pack member of every struct in a span
+ *
+ * \param structs
+ * \param member
+ * \return
+ */
+template <detail::view_pack_t P, typename S, typename M>
+auto make_strided_view( std::span<S> structs, M std::remove_const_t<S>::*member )
+	->strided_view_t<detail::copy_const_t<S, P>>
+{
+	using Pack = std::remove_const_t<P>;
+	using View = strided_view_t<detail::copy_const_t<S, P>>;
+
+	static_assert( sizeof( M ) == sizeof( typename Pack::Type ) * Pack::Len );
+
+	if( structs.empty( ) )
+	{
+		return View{ nullptr, 0, sizeof( S ) };
+	}
+
+	return View{ reinterpret_cast<typename View::Type *>( &( structs.front( ).*member ) ), structs.size( ), sizeof( S ) };
+}